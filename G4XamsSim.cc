@@ -1,10 +1,13 @@
 #include "DetectorConstruction.hh"
 #include "DetectorConstructionMessenger.hh"
 #include "ActionInitialization.hh"
+#include "ProcessPool.hh"
 
 #include "G4RunManagerFactory.hh"
 #include "G4SteppingVerbose.hh"
 #include "G4UImanager.hh"
+#include "G4UIcommand.hh"
+#include "G4UIcommandStatus.hh"
 #include "QBBC.hh"
 #include "FTFP_BERT_HP.hh"
 
@@ -15,17 +18,194 @@
 
 #include "Randomize.hh"
 
+#include "nlohmann/json.hpp"
+
+#include <fstream>
+
 //#include "TTree.h"
 
 using namespace G4Sim;
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
+namespace {
+  void PrintUsage() {
+    G4cerr << " Usage: " << G4endl;
+    G4cerr << " G4XamsSim [macro] [-m manifest [-f nProcesses]] [-r serial|mt|tasking] [-t nThreads]" << G4endl;
+    G4cerr << "   macro : batch macro; without it (and without -m) an interactive session is started" << G4endl;
+    G4cerr << "   -m    : JSON manifest of runs, executed back to back after a single /run/initialize" << G4endl;
+    G4cerr << "   -f    : execute the manifest runs in this many processes forked after initialization" << G4endl;
+    G4cerr << "   -r    : run manager type (default: serial, or the Geant4 default when -t is given)" << G4endl;
+    G4cerr << "   -t    : number of worker threads for the mt and tasking run managers" << G4endl;
+  }
+
+  // Applies a UI command, and reports it if it fails
+  G4bool ApplyCommand(G4UImanager* UImanager, const G4String& command) {
+    G4int status = UImanager->ApplyCommand(command);
+    if ( status != fCommandSucceeded ) {
+      G4cerr << "G4XamsSim: command failed (status " << status << "): " << command << G4endl;
+      return false;
+    }
+    return true;
+  }
+
+  // Returns the output file of a run: its "outputFileName", else the last /run/setOutputFileName in its commands
+  G4String OutputFileName(const nlohmann::json& run) {
+    if ( run.contains("outputFileName") ) return run["outputFileName"].get<std::string>();
+    const G4String prefix = "/run/setOutputFileName ";
+    G4String fileName;
+    for ( const auto& command : run.value("commands", nlohmann::json::array()) ) {
+      G4String value = command.get<std::string>();
+      if ( value.compare(0, prefix.size(), prefix) == 0 ) fileName = value.substr(prefix.size());
+    }
+    return fileName;
+  }
+
+  // Applies the commands of one manifest run and starts it
+  G4int ExecuteRun(const nlohmann::json& run, G4UImanager* UImanager) {
+    for ( const auto& command : run.value("commands", nlohmann::json::array()) ) {
+      if ( ! ApplyCommand(UImanager, command.get<std::string>()) ) return 1;
+    }
+    if ( run.contains("outputFileName") ) {
+      if ( ! ApplyCommand(UImanager, "/run/setOutputFileName " + run["outputFileName"].get<std::string>()) ) return 1;
+    }
+    if ( run.contains("seeds") ) {
+      G4String seeds = std::to_string(run["seeds"][0].get<long>()) + " " + std::to_string(run["seeds"][1].get<long>());
+      if ( ! ApplyCommand(UImanager, "/random/setSeeds " + seeds) ) return 1;
+    }
+    if ( ! ApplyCommand(UImanager, "/run/beamOn " + std::to_string(run.value("beamOn", 0))) ) return 1;
+    return 0;
+  }
+
+  // Executes the runs of a manifest in forked processes (see ProcessPool). The physics tables are built by a
+  // /run/beamOn 0 before the fork, so all children share them. Runs without seeds get seeds drawn from the
+  // engine of the master, and runs without an output file get <name>.root, so no two children write the same
+  // stream or file. The outputs are listed in <manifest>_outputs.json.
+  G4int ExecuteManifestForked(const G4String& fileName, nlohmann::json& runs, G4UImanager* UImanager,
+                              G4int nProcesses, G4int maxRetries) {
+    if ( ! ApplyCommand(UImanager, "/run/beamOn 0") ) return 1;
+
+    for ( size_t i = 0; i < runs.size(); ++i ) {
+      auto& run = runs[i];
+      if ( ! run.contains("name") ) run["name"] = "run_" + std::to_string(i);
+      if ( ! run.contains("seeds") ) {
+        run["seeds"] = { static_cast<long>(G4UniformRand() * 1.e9) + 1, static_cast<long>(G4UniformRand() * 1.e9) + 1 };
+      }
+      if ( OutputFileName(run).empty() ) run["outputFileName"] = run["name"].get<std::string>() + ".root";
+    }
+
+    ProcessPool pool(nProcesses, maxRetries);
+    G4int childStatus = 0;
+    if ( ! pool.Run(runs.size(), [&](size_t i) { return ExecuteRun(runs[i], UImanager); }, childStatus) ) {
+      // in a child: clean up as a normal job
+      return childStatus;
+    }
+
+    G4int status = 0;
+    nlohmann::json outputs = nlohmann::json::array();
+    for ( size_t i = 0; i < runs.size(); ++i ) {
+      const ProcessPool::Result& result = pool.GetResults()[i];
+      outputs.push_back({ {"name", runs[i]["name"]}, {"outputFileName", OutputFileName(runs[i])},
+                          {"seeds", runs[i]["seeds"]}, {"succeeded", result.succeeded},
+                          {"attempts", result.attempts}, {"exitCode", result.exitCode}, {"signal", result.signal} });
+      if ( ! result.succeeded ) status = 1;
+    }
+    G4String outputsFileName = fileName;
+    size_t dot = outputsFileName.rfind('.');
+    if ( dot != G4String::npos && outputsFileName.find('/', dot) == G4String::npos ) outputsFileName.erase(dot);
+    outputsFileName += "_outputs.json";
+    std::ofstream outputsFile(outputsFileName);
+    outputsFile << outputs.dump(4) << std::endl;
+    G4cout << "G4XamsSim: outputs listed in " << outputsFileName << G4endl;
+    return status;
+  }
+
+  // Executes a manifest of runs in one process:
+  //
+  //   { "setup": [ commands before /run/initialize ],
+  //     "runs":  [ { "name": ..., "commands": [ ... ], "outputFileName": ..., "seeds": [s1, s2], "beamOn": n }, ... ],
+  //     "maxRetries": n }
+  //
+  // The geometry and physics are initialized once. The commands of a run are applied on top of the state left by
+  // the previous runs, so every run has to set all settings it depends on (e.g. all GPS settings). With nProcesses
+  // > 0 the runs are executed in forked processes instead, see ExecuteManifestForked(); the children return the
+  // status of their run.
+  G4int ExecuteManifest(const G4String& fileName, G4UImanager* UImanager, G4int nProcesses) {
+    std::ifstream file(fileName);
+    if ( ! file ) {
+      G4cerr << "G4XamsSim: cannot open manifest " << fileName << G4endl;
+      return 1;
+    }
+    nlohmann::json manifest;
+    try {
+      file >> manifest;
+    } catch ( const nlohmann::json::exception& e ) {
+      G4cerr << "G4XamsSim: cannot parse manifest " << fileName << ": " << e.what() << G4endl;
+      return 1;
+    }
+
+    for ( const auto& command : manifest.value("setup", nlohmann::json::array()) ) {
+      if ( ! ApplyCommand(UImanager, command.get<std::string>()) ) return 1;
+    }
+    if ( ! ApplyCommand(UImanager, "/run/initialize") ) return 1;
+
+    auto& runs = manifest["runs"];
+    if ( nProcesses > 0 ) {
+      return ExecuteManifestForked(fileName, runs, UImanager, nProcesses, manifest.value("maxRetries", 1));
+    }
+
+    G4int iRun = 0;
+    for ( const auto& run : runs ) {
+      ++iRun;
+      G4cout << "G4XamsSim: manifest run " << iRun << "/" << runs.size() << " " << run.value("name", "") << G4endl;
+      if ( ExecuteRun(run, UImanager) != 0 ) return 1;
+    }
+    return 0;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
 int main(int argc,char** argv)
 {
-  // Detect interactive mode (if no arguments) and define UI session
+  // Parse the command line
+  //
+  G4String macro;
+  G4String manifest;
+  G4String runManagerType;
+  G4int nThreads = 0;
+  G4int nProcesses = 0;
+  for ( G4int i = 1; i < argc; ++i ) {
+    G4String arg = argv[i];
+    if ( arg == "-r" && i + 1 < argc ) { runManagerType = argv[++i]; }
+    else if ( arg == "-m" && i + 1 < argc ) { manifest = argv[++i]; }
+    else if ( arg == "-t" && i + 1 < argc ) { nThreads = G4UIcommand::ConvertToInt(argv[++i]); }
+    else if ( arg == "-f" && i + 1 < argc ) { nProcesses = G4UIcommand::ConvertToInt(argv[++i]); }
+    else if ( arg[0] != '-' && macro.empty() ) { macro = arg; }
+    else {
+      PrintUsage();
+      return 1;
+    }
+  }
+
+  G4RunManagerType type = G4RunManagerType::Serial;
+  if ( runManagerType == "mt" ) { type = G4RunManagerType::MT; }
+  else if ( runManagerType == "tasking" ) { type = G4RunManagerType::Tasking; }
+  else if ( runManagerType.empty() && nThreads > 0 ) { type = G4RunManagerType::Default; }
+  else if ( ! runManagerType.empty() && runManagerType != "serial" ) {
+    PrintUsage();
+    return 1;
+  }
+  // forking is only safe with a single thread
+  if ( nProcesses > 0 && ( manifest.empty() || type != G4RunManagerType::Serial ) ) {
+    G4cerr << " -f needs a manifest and the serial run manager" << G4endl;
+    PrintUsage();
+    return 1;
+  }
+
+  // Detect interactive mode (if no macro) and define UI session
   //
   G4UIExecutive* ui = nullptr;
-  if ( argc == 1 ) { ui = new G4UIExecutive(argc, argv); }
+  if ( macro.empty() && manifest.empty() ) { ui = new G4UIExecutive(argc, argv); }
 
   // Optionally: choose a different Random engine...
   // G4Random::setTheEngine(new CLHEP::MTwistEngine);
@@ -34,17 +214,18 @@ int main(int argc,char** argv)
   G4int precision = 4;
   G4SteppingVerbose::UseBestUnit(precision);
 
-  // Construct the default run manager
+  // Construct the run manager
   //
   auto* runManager =
-    G4RunManagerFactory::CreateRunManager(G4RunManagerType::Serial);
+    G4RunManagerFactory::CreateRunManager(type);
 
-  //runManager->SetNumberOfThreads(1);
+  if ( nThreads > 0 ) { runManager->SetNumberOfThreads(nThreads); }
 
   // Set mandatory initialization classes
   //
   // Detector construction
-  runManager->SetUserInitialization(new DetectorConstruction());
+  auto* detector = new DetectorConstruction();
+  runManager->SetUserInitialization(detector);
 
   // Physics list
   G4PhysListFactory factory;
@@ -53,7 +234,7 @@ int main(int argc,char** argv)
   //if you want to mess with the Em physics list ...... physicsList->ReplacePhysics(new CustomEmPhysics());
   runManager->SetUserInitialization(physicsList);
   // User action initialization
-  runManager->SetUserInitialization(new ActionInitialization());
+  runManager->SetUserInitialization(new ActionInitialization(detector));
 
   // Initialize visualization
   //
@@ -67,11 +248,15 @@ int main(int argc,char** argv)
 
   // Process macro or start UI session
   //
-  if ( ! ui ) {
+  G4int status = 0;
+  if ( ! manifest.empty() ) {
+    // several runs with one initialization, optionally in forked processes
+    status = ExecuteManifest(manifest, UImanager, nProcesses);
+  }
+  else if ( ! ui ) {
     // batch mode
     G4String command = "/control/execute ";
-    G4String fileName = argv[1];
-    UImanager->ApplyCommand(command+fileName);
+    UImanager->ApplyCommand(command+macro);
   }
   else {
     // interactive mode
@@ -88,7 +273,7 @@ int main(int argc,char** argv)
   delete visManager;
   delete runManager;
 
-  return 0;
+  return status;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo.....
\ No newline at end of file
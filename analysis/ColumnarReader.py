@@ -0,0 +1,199 @@
+import json
+import os
+import struct
+
+import numpy as np
+import awkward as ak
+
+HEADER_MAGIC = b"XAMSCOL1"
+FOOTER_MAGIC = b"XAMSEND1"
+
+COMPRESSION_NONE = 0
+COMPRESSION_ZSTD = 1
+
+DOUBLE = 0
+JAGGED_DOUBLE = 1
+JAGGED_INT = 2
+
+class ColumnarReader:
+    """
+    Reader for the columnar output of G4XamsSim (.xcol files, see ColumnarOutput.hh for the format).
+
+    Uncompressed blocks are memory mapped, so reading a column does not copy the file. Compressed blocks need the
+    `zstandard` package.
+    """
+    def __init__(self, file_path):
+        """
+        Opens the file and reads the column definitions and the chunk index.
+
+        Args:
+            file_path (str): The path to the .xcol file.
+        """
+        self.file_path = file_path
+        self.buffer = np.memmap(file_path, dtype=np.uint8, mode="r")
+
+        if bytes(self.buffer[:8]) != HEADER_MAGIC:
+            raise ValueError(f"{file_path} is not a G4XamsSim columnar file")
+        if bytes(self.buffer[-8:]) != FOOTER_MAGIC:
+            raise ValueError(f"{file_path} is incomplete (no footer), was the run finished?")
+
+        self.compression, n_columns = struct.unpack_from("<II", self.buffer, 8)
+        self.columns = []
+        position = 16
+        for _ in range(n_columns):
+            column_type, length = struct.unpack_from("<II", self.buffer, position)
+            position += 8
+            name = bytes(self.buffer[position:position + length]).decode()
+            position = self._align(position + length)
+            self.columns.append((name, column_type))
+
+        footer_offset = struct.unpack_from("<Q", self.buffer, len(self.buffer) - 16)[0]
+        n_chunks = struct.unpack_from("<Q", self.buffer, footer_offset)[0]
+        index = np.frombuffer(self.buffer, dtype="<u8", count=2 * n_chunks, offset=footer_offset + 8)
+        self.chunks = index.reshape(n_chunks, 2)
+
+        self._decompressor = None
+
+    @staticmethod
+    def _align(position):
+        return (position + 7) // 8 * 8
+
+    def _read_block(self, position, dtype):
+        raw_size, stored_size = struct.unpack_from("<QQ", self.buffer, position)
+        data_position = position + 16
+        if stored_size == raw_size:
+            data = np.frombuffer(self.buffer, dtype=dtype, count=raw_size // np.dtype(dtype).itemsize, offset=data_position)
+        else:
+            if self._decompressor is None:
+                import zstandard
+                self._decompressor = zstandard.ZstdDecompressor()
+            compressed = bytes(self.buffer[data_position:data_position + stored_size])
+            data = np.frombuffer(self._decompressor.decompress(compressed, max_output_size=raw_size), dtype=dtype)
+        return data, self._align(data_position + stored_size)
+
+    def read(self, library="ak"):
+        """
+        Reads all chunks of the file.
+
+        Args:
+            library (str, optional): "ak" returns an awkward record array with the same fields as the ROOT ntuple.
+                                     "np" returns a dict with numpy arrays; jagged columns are (offsets, values).
+
+        Returns:
+            ak.Array or dict: The columns of the file.
+        """
+        values = {name: [] for name, _ in self.columns}
+        offsets = {name: [np.zeros(1, dtype=np.int64)] for name, column_type in self.columns if column_type != DOUBLE}
+        n_values = {name: 0 for name in offsets}
+
+        for chunk_offset, _ in self.chunks:
+            position = int(chunk_offset) + 8
+            for name, column_type in self.columns:
+                if column_type != DOUBLE:
+                    chunk_offsets, position = self._read_block(position, "<u8")
+                    offsets[name].append(chunk_offsets[1:].astype(np.int64) + n_values[name])
+                    n_values[name] += int(chunk_offsets[-1])
+                dtype = "<i4" if column_type == JAGGED_INT else "<f8"
+                chunk_values, position = self._read_block(position, dtype)
+                values[name].append(chunk_values)
+
+        columns = {}
+        for name, column_type in self.columns:
+            data = np.concatenate(values[name]) if values[name] else np.zeros(0)
+            if column_type == DOUBLE:
+                columns[name] = data
+            else:
+                columns[name] = (np.concatenate(offsets[name]), data)
+
+        if library == "np":
+            return columns
+
+        fields = {}
+        for name, column in columns.items():
+            if isinstance(column, tuple):
+                layout = ak.contents.ListOffsetArray(ak.index.Index64(column[0]), ak.contents.NumpyArray(column[1]))
+                fields[name] = ak.Array(layout)
+            else:
+                fields[name] = column
+        return ak.zip(fields, depth_limit=1)
+
+def read_columnar(file_path, library="ak"):
+    """
+    Reads a G4XamsSim columnar file.
+
+    Args:
+        file_path (str): The path to the .xcol file.
+        library (str, optional): "ak" or "np", see ColumnarReader.read.
+    """
+    return ColumnarReader(file_path).read(library=library)
+
+def to_dense_layout(events, n_detectors=None):
+    """
+    Converts events written with the sparse layout (/run/setEventLayout sparse) to the dense layout.
+
+    The per detector fields (edet, ndet) get one entry per active volume again, zero for the volumes without
+    clusters, nphot and ncomp are added with zeros, and the det field is dropped. Events in the dense layout are
+    returned unchanged. Works for the columnar and ROOT output.
+
+    Args:
+        events (ak.Array): The events, as returned by read_columnar or uproot.
+        n_detectors (int, optional): The number of active volumes; by default the highest index in det plus one.
+
+    Returns:
+        ak.Array: The events in the dense layout.
+    """
+    if "det" not in events.fields:
+        return events
+
+    det = events["det"]
+    flat_det = ak.to_numpy(ak.flatten(det))
+    if n_detectors is None:
+        n_detectors = int(flat_det.max()) + 1 if len(flat_det) else 0
+    counts = ak.to_numpy(ak.num(det))
+    index = np.repeat(np.arange(len(events)) * n_detectors, counts) + flat_det
+
+    fields = {name: events[name] for name in events.fields if name != "det"}
+    for name in ("edet", "ndet"):
+        values = ak.to_numpy(ak.flatten(events[name]))
+        dense = np.zeros(len(events) * n_detectors, dtype=values.dtype)
+        dense[index] = values
+        fields[name] = ak.unflatten(dense, np.full(len(events), n_detectors))
+    for name in ("nphot", "ncomp"):
+        fields[name] = ak.unflatten(np.zeros(len(events) * n_detectors, dtype=np.int32), np.full(len(events), n_detectors))
+    return ak.zip(fields, depth_limit=1)
+
+def is_columnar_file(file_path):
+    """Check if the given file is a G4XamsSim columnar file."""
+    return os.path.splitext(file_path)[1] == ".xcol"
+
+def read_histograms(file_path):
+    """
+    Reads the histograms written by G4XamsSim_merge.
+
+    Args:
+        file_path (str): The path to the JSON file.
+
+    Returns:
+        dict: Per histogram, keyed by column (with a suffix _1, _2, ... for further histograms of the same column), a
+              dict with "edges", "counts" (sum of weights), "errors" (sqrt of the sum of squared weights),
+              "underflow", "overflow" and "entries" as numpy arrays and numbers.
+    """
+    with open(file_path) as file:
+        result = json.load(file)
+
+    histograms = {}
+    for histogram in result.get("histograms", []):
+        name = histogram["column"]
+        n = 1
+        while name in histograms:
+            name = f"{histogram['column']}_{n}"
+            n += 1
+        histograms[name] = {
+            "edges": np.array(histogram["edges"]),
+            "counts": np.array(histogram["sumWeights"]),
+            "errors": np.sqrt(np.array(histogram["sumWeights2"])),
+            "underflow": histogram["underflow"],
+            "overflow": histogram["overflow"],
+            "entries": histogram["entries"],
+        }
+    return histograms
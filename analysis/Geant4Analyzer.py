@@ -5,6 +5,7 @@ import matplotlib.pyplot as plt
 from matplotlib.colors import LogNorm
 
 from RunManager import RunManager
+from ColumnarReader import read_columnar, is_columnar_file, to_dense_layout
 from mendeleev import element
 
 def is_jagged(array):
@@ -63,8 +64,11 @@ class Geant4Analyzer:
         for file_path in self.file_paths:
             try:
                 print(f"Loading {file_path}")
-                root = uproot.open(file_path)
-                data = root["ev"].arrays(library="ak")  # Use awkward array
+                if is_columnar_file(file_path):
+                    data = read_columnar(file_path)
+                else:
+                    root = uproot.open(file_path)
+                    data = root["ev"].arrays(library="ak")  # Use awkward array
                 data_list.append(data)
             except FileNotFoundError:
                 raise FileNotFoundError(f"File not found: {file_path}")
@@ -72,6 +76,8 @@ class Geant4Analyzer:
         if data_list:
             # Concatenate awkward arrays
             self.raw = ak.concatenate(data_list, axis=0)
+            # files written with the sparse layout get one entry per detector again
+            self.raw = to_dense_layout(self.raw)
 
             # Add derived variables
             self.raw['r'] = np.sqrt(self.raw['xh']**2 + self.raw['yh']**2)
@@ -60,6 +60,7 @@ class RunManager:
     def get_output_root_files(self, run_id, first_only=False):
         """
         Retrieves the paths of the output ROOT files associated with the given run ID.
+        Files of the columnar output (.xcol) are returned as well.
 
         Args:
             run_id (int): The ID of the run.
@@ -73,7 +74,7 @@ class RunManager:
         if run and run.get("status") != "deleted":
             output_dir = run.get("outputDir")
             if output_dir:
-                root_files = [os.path.join(output_dir, file) for file in os.listdir(output_dir) if file.endswith(".root")]
+                root_files = [os.path.join(output_dir, file) for file in os.listdir(output_dir) if file.endswith(".root") or file.endswith(".xcol")]
                 if first_only:
                     return root_files[0] if root_files else None
                 return root_files
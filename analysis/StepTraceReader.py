@@ -0,0 +1,81 @@
+import struct
+
+import numpy as np
+
+HEADER_MAGIC = b"XAMSSTP1"
+FOOTER_MAGIC = b"XAMSEND1"
+
+STEP_DTYPE = np.dtype([
+    ("eventID", "<i4"), ("trackID", "<i4"), ("parentID", "<i4"), ("pdgCode", "<i4"),
+    ("volume", "<i2"), ("process", "<i2"),
+    ("preX", "<f4"), ("preY", "<f4"), ("preZ", "<f4"),
+    ("postX", "<f4"), ("postY", "<f4"), ("postZ", "<f4"),
+    ("kineticEnergy", "<f4"), ("energyDeposit", "<f4"), ("time", "<f4"),
+])
+
+class StepTraceReader:
+    """
+    Reader for the step trace files of G4XamsSim (.xst files, see StepTracer.hh for the format).
+
+    The steps are memory mapped as a numpy structured array. Positions are in mm, energies in MeV and times in ns.
+    """
+    def __init__(self, file_path):
+        """
+        Opens the file and reads the volume and process tables.
+
+        Args:
+            file_path (str): The path to the .xst file.
+        """
+        self.file_path = file_path
+        buffer = np.memmap(file_path, dtype=np.uint8, mode="r")
+
+        if bytes(buffer[:8]) != HEADER_MAGIC:
+            raise ValueError(f"{file_path} is not a G4XamsSim step trace file")
+        if bytes(buffer[-8:]) != FOOTER_MAGIC:
+            raise ValueError(f"{file_path} is incomplete (no footer), was the job finished?")
+        record_size = struct.unpack_from("<I", buffer, 8)[0]
+        if record_size != STEP_DTYPE.itemsize:
+            raise ValueError(f"{file_path} has records of {record_size} bytes, expected {STEP_DTYPE.itemsize}")
+
+        footer_offset = struct.unpack_from("<Q", buffer, len(buffer) - 16)[0]
+        n_steps = (footer_offset - 16) // record_size
+        self.steps = np.frombuffer(buffer, dtype=STEP_DTYPE, count=n_steps, offset=16)
+
+        position = footer_offset
+        n_volumes = struct.unpack_from("<I", buffer, position)[0]
+        position += 4
+        self.volumes = {}
+        for _ in range(n_volumes):
+            instance_id, length = struct.unpack_from("<iI", buffer, position)
+            position += 8
+            self.volumes[instance_id] = bytes(buffer[position:position + length]).decode()
+            position += length
+        n_processes = struct.unpack_from("<I", buffer, position)[0]
+        position += 4
+        self.processes = []
+        for _ in range(n_processes):
+            length = struct.unpack_from("<I", buffer, position)[0]
+            position += 4
+            self.processes.append(bytes(buffer[position:position + length]).decode())
+            position += length
+
+    def volume_names(self):
+        """Returns the name of the pre-step volume of every step."""
+        return np.array([self.volumes.get(int(volume), "") for volume in self.steps["volume"]])
+
+    def process_names(self):
+        """Returns the name of the process that limited every step, "" if none."""
+        names = np.array(self.processes + [""])
+        return names[self.steps["process"]]
+
+def read_step_trace(file_path):
+    """
+    Reads a G4XamsSim step trace file.
+
+    Args:
+        file_path (str): The path to the .xst file.
+
+    Returns:
+        StepTraceReader: The reader, with the steps in `steps` and the name tables in `volumes` and `processes`.
+    """
+    return StepTraceReader(file_path)
@@ -0,0 +1,46 @@
+import json
+
+import numpy as np
+
+
+def read_summary(file_path):
+    """
+    Reads the run summary written by G4XamsSim (see RunSummary.hh), e.g. "output/run_1/G4XamsSim_0_summary.json".
+
+    Args:
+        file_path (str): The path to the JSON file.
+
+    Returns:
+        dict: "run" and "events", and "histograms": a list with per histogram a dict with "definition", "collection",
+              "quantities" (one name per axis), "edges" (one array per axis), "counts" (sum of weights) and "errors"
+              (sqrt of the sum of squared weights) as numpy arrays of shape (nBins of axis 1, nBins of axis 2, ...),
+              "outside" (sum of the weights outside the range) and "entries".
+    """
+    with open(file_path) as file:
+        result = json.load(file)
+
+    histograms = []
+    for histogram in result.get("histograms", []):
+        axes = histogram["axes"]
+        shape = tuple(axis["nBins"] for axis in axes)
+        histograms.append({
+            "definition": histogram["definition"],
+            "collection": histogram["collection"],
+            "quantities": [axis["quantity"] for axis in axes],
+            "edges": [np.linspace(axis["min"], axis["max"], axis["nBins"] + 1) for axis in axes],
+            "counts": np.array(histogram["sumWeights"]).reshape(shape),
+            "errors": np.sqrt(np.array(histogram["sumWeights2"])).reshape(shape),
+            "outside": histogram["outside"],
+            "entries": histogram["entries"],
+        })
+    return {"run": result["run"], "events": result["events"], "histograms": histograms}
+
+
+def find_histogram(summary, collection, definition):
+    """
+    Returns the histogram of a collection with the given definition, e.g. ("LXe", "edet 200 0 2000").
+    """
+    for histogram in summary["histograms"]:
+        if histogram["collection"] == collection and histogram["definition"] == definition:
+            return histogram
+    raise KeyError(f"no histogram {definition} of {collection}")
@@ -0,0 +1,424 @@
+//
+// Microbenchmarks for the hit and clustering hot paths of G4XamsSim.
+//
+// The benchmark replays synthetic hit sets of increasing multiplicity, and optionally recorded hit sets, through
+// the same code that the simulation uses per event:
+//   - hit creation: HitStore::Add, and Hit objects in a hits collection, as in SensitiveDetector::ProcessHits
+//   - clustering:   HitClusterer::ClusterDeposits, as in EventAction, compared with the original clustering
+//   - output:       filling the event ntuple of a ColumnarOutput
+//
+// It reports ns per hit (or per event), heap allocations per event, and whether the clusters are identical to the
+// original algorithm. Results can be stored as a baseline JSON file and compared with later runs. Only the Geant4
+// headers and libraries are needed, no run manager, geometry or physics.
+//
+// Usage: G4XamsSim_bench [options]
+//   -e, --events N             number of synthetic events per multiplicity (default 1000)
+//   -m, --multiplicities LIST  comma separated hits per event (default 10,100,1000,10000)
+//   --hits FILE.csv            also replay a recorded hit set (see bench/HitSets.hh for the format)
+//   --write-hits FILE.csv      write the first synthetic hit set as CSV
+//   --spatial MM               spatial clustering threshold in mm (default 10)
+//   --time NS                  time clustering threshold in ns (default 100)
+//   --baseline FILE.json       compare with a stored baseline
+//   --write-baseline FILE.json store the results as a baseline
+//   --max-slowdown X           fail if a timing is more than X times the baseline
+//   --output-dir DIR           directory for the temporary output file (default /tmp)
+//
+// Exit code: 0 on success, 1 if the clusters differ from the original algorithm, 2 if a timing exceeds the
+// allowed slowdown, 3 on a usage error.
+//
+
+#include "HitSets.hh"
+#include "LegacyClustering.hh"
+
+#include "HitClusterer.hh"
+#include "HitStore.hh"
+#include "Hit.hh"
+#include "ColumnarOutput.hh"
+
+#include "G4SystemOfUnits.hh"
+#include "nlohmann/json.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+//
+// Global allocation counter
+//
+namespace {
+    std::atomic<std::size_t> gAllocations{0};
+}
+
+void* operator new(std::size_t size) {
+    ++gAllocations;
+    if (void* pointer = std::malloc(size ? size : 1)) return pointer;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size) {
+    ++gAllocations;
+    if (void* pointer = std::malloc(size ? size : 1)) return pointer;
+    throw std::bad_alloc();
+}
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+void operator delete[](void* pointer) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, std::size_t) noexcept { std::free(pointer); }
+
+using namespace G4Sim;
+
+namespace {
+
+struct Options {
+    size_t nEvents = 1000;
+    std::vector<size_t> multiplicities = {10, 100, 1000, 10000};
+    std::string hitsFile;
+    std::string writeHitsFile;
+    G4double spatialThreshold = 10. * mm;
+    G4double timeThreshold = 100. * ns;
+    std::string baselineFile;
+    std::string writeBaselineFile;
+    G4double maxSlowdown = 0.;
+    std::string outputDir = "/tmp";
+};
+
+/**
+ * @brief Measures the wall time and the heap allocations of a piece of code.
+ */
+class Measurement {
+public:
+    Measurement() : fAllocations(gAllocations.load()), fStart(std::chrono::steady_clock::now()) {}
+
+    G4double Nanoseconds() const {
+        return std::chrono::duration<G4double, std::nano>(std::chrono::steady_clock::now() - fStart).count();
+    }
+    std::size_t Allocations() const { return gAllocations.load() - fAllocations; }
+
+private:
+    std::size_t fAllocations;
+    std::chrono::steady_clock::time_point fStart;
+};
+
+void PrintUsage() {
+    std::cerr << "Usage: G4XamsSim_bench [-e events] [-m multiplicities] [--hits file.csv] [--write-hits file.csv]"
+              << " [--spatial mm] [--time ns] [--baseline file.json] [--write-baseline file.json]"
+              << " [--max-slowdown x] [--output-dir dir]" << std::endl;
+}
+
+std::vector<size_t> ParseList(const std::string& text) {
+    std::vector<size_t> values;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        values.push_back(std::stoul(item));
+    }
+    return values;
+}
+
+//
+// Hit creation
+//
+void FillHitStore(const HitSet& hitSet, HitStore& store, size_t event) {
+    store.Clear();
+    for (size_t i = hitSet.eventBegin[event]; i < hitSet.eventBegin[event + 1]; ++i) {
+        store.Add(hitSet.energyDeposit[i], G4ThreeVector(hitSet.x[i], hitSet.y[i], hitSet.z[i]), hitSet.time[i],
+                  hitSet.trackID[i], 0, G4ThreeVector(), 11, hitSet.processID[i], 0., 0.);
+    }
+}
+
+void FillHitsCollection(const HitSet& hitSet, size_t event) {
+    auto* hitsCollection = new HitsCollection("bench", "benchCollection");
+    for (size_t i = hitSet.eventBegin[event]; i < hitSet.eventBegin[event + 1]; ++i) {
+        Hit* hit = new Hit();
+        hit->energyDeposit = hitSet.energyDeposit[i];
+        hit->position = G4ThreeVector(hitSet.x[i], hitSet.y[i], hitSet.z[i]);
+        hit->time = hitSet.time[i];
+        hit->trackID = hitSet.trackID[i];
+        hit->particleID = 11;
+        hit->processID = hitSet.processID[i];
+        hitsCollection->insert(hit);
+    }
+    // the event deletes its hits collections, and with them the hits
+    delete hitsCollection;
+}
+
+//
+// Clustering
+//
+void ClusterEvent(const HitSet& hitSet, size_t event, const Options& options, HitClusterer& clusterer,
+                  std::vector<Cluster>& clusters) {
+    size_t begin = hitSet.eventBegin[event];
+    size_t nDeposits = hitSet.eventBegin[event + 1] - begin;
+    clusters.clear();
+    clusterer.ClusterDeposits(nDeposits, hitSet.x.data() + begin, hitSet.y.data() + begin, hitSet.z.data() + begin,
+                              hitSet.time.data() + begin, hitSet.energyDeposit.data() + begin,
+                              hitSet.processID.data() + begin, options.spatialThreshold, options.timeThreshold);
+    clusterer.GetClusters(clusters, 0);
+}
+
+void LegacyClusterEvent(const HitSet& hitSet, size_t event, const Options& options, std::vector<LegacyHit>& hits,
+                        std::vector<Cluster>& clusters) {
+    hits.clear();
+    for (size_t i = hitSet.eventBegin[event]; i < hitSet.eventBegin[event + 1]; ++i) {
+        hits.push_back(LegacyHit{G4ThreeVector(hitSet.x[i], hitSet.y[i], hitSet.z[i]), hitSet.energyDeposit[i],
+                                 hitSet.time[i], hitSet.processID[i], false});
+    }
+    clusters.clear();
+    LegacyClusterHits(hits, options.spatialThreshold, options.timeThreshold, clusters);
+}
+
+G4bool Identical(const std::vector<Cluster>& a, const std::vector<Cluster>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].position != b[i].position || a[i].energyDeposit != b[i].energyDeposit ||
+            a[i].time != b[i].time || a[i].nHits != b[i].nHits) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Runs all benchmarks on one hit set.
+ */
+nlohmann::json RunHitSet(const HitSet& hitSet, const Options& options) {
+    const size_t nEvents = hitSet.GetNumberOfEvents();
+    const G4double nHits = std::max<size_t>(hitSet.GetNumberOfHits(), 1);
+    nlohmann::json result;
+    result["events"] = nEvents;
+    result["hits_per_event"] = nHits / std::max<size_t>(nEvents, 1);
+
+    // hit store, one pass to warm up the arena
+    HitStore store;
+    for (size_t event = 0; event < nEvents; ++event) FillHitStore(hitSet, store, event);
+    {
+        Measurement measurement;
+        for (size_t event = 0; event < nEvents; ++event) FillHitStore(hitSet, store, event);
+        result["hitstore_ns_per_hit"] = measurement.Nanoseconds() / nHits;
+        result["hitstore_allocs_per_event"] = G4double(measurement.Allocations()) / nEvents;
+    }
+
+    // hits collection
+    for (size_t event = 0; event < nEvents; ++event) FillHitsCollection(hitSet, event);
+    {
+        Measurement measurement;
+        for (size_t event = 0; event < nEvents; ++event) FillHitsCollection(hitSet, event);
+        result["hitscollection_ns_per_hit"] = measurement.Nanoseconds() / nHits;
+        result["hitscollection_allocs_per_event"] = G4double(measurement.Allocations()) / nEvents;
+    }
+
+    // clustering
+    HitClusterer clusterer;
+    std::vector<Cluster> clusters;
+    for (size_t event = 0; event < nEvents; ++event) ClusterEvent(hitSet, event, options, clusterer, clusters);
+    {
+        size_t nClusters = 0;
+        Measurement measurement;
+        for (size_t event = 0; event < nEvents; ++event) {
+            ClusterEvent(hitSet, event, options, clusterer, clusters);
+            nClusters += clusters.size();
+        }
+        result["clustering_ns_per_hit"] = measurement.Nanoseconds() / nHits;
+        result["clustering_allocs_per_event"] = G4double(measurement.Allocations()) / nEvents;
+        result["clusters_per_event"] = G4double(nClusters) / nEvents;
+    }
+
+    // original clustering: timing and comparison of the output
+    std::vector<LegacyHit> legacyHits;
+    std::vector<Cluster> legacyClusters;
+    G4double legacyNanoseconds = 0.;
+    size_t mismatches = 0;
+    for (size_t event = 0; event < nEvents; ++event) {
+        Measurement measurement;
+        LegacyClusterEvent(hitSet, event, options, legacyHits, legacyClusters);
+        legacyNanoseconds += measurement.Nanoseconds();
+
+        ClusterEvent(hitSet, event, options, clusterer, clusters);
+        if (!Identical(clusters, legacyClusters)) mismatches++;
+    }
+    result["legacy_clustering_ns_per_hit"] = legacyNanoseconds / nHits;
+    result["mismatched_events"] = mismatches;
+
+    // output: one row per event with the clusters, as in EventAction
+    std::string fileName = options.outputDir + "/G4XamsSim_bench_" + std::to_string(::getpid());
+    std::vector<G4double> e, x, y, z, w;
+    std::vector<G4int> id;
+    {
+        ColumnarOutput output(10000, ColumnarOutput::kNone);
+        output.OpenFile(fileName);
+        output.CreateNtuple("ev", "G4XamsSim bench");
+        output.CreateDColumn("ev");
+        output.CreateDColumn("eh", e);
+        output.CreateDColumn("xh", x);
+        output.CreateDColumn("yh", y);
+        output.CreateDColumn("zh", z);
+        output.CreateDColumn("wh", w);
+        output.CreateIColumn("id", id);
+        output.FinishNtuple();
+
+        G4double outputNanoseconds = 0.;
+        size_t outputAllocations = 0;
+        for (size_t event = 0; event < nEvents; ++event) {
+            ClusterEvent(hitSet, event, options, clusterer, clusters);
+            Measurement measurement;
+            e.clear(); x.clear(); y.clear(); z.clear(); w.clear(); id.clear();
+            for (const auto& cluster : clusters) {
+                e.push_back(cluster.energyDeposit / keV);
+                x.push_back(cluster.position.x());
+                y.push_back(cluster.position.y());
+                z.push_back(cluster.position.z());
+                w.push_back(0.);
+                id.push_back(cluster.collectionID);
+            }
+            output.FillDColumn(0, event);
+            output.AddRow();
+            outputNanoseconds += measurement.Nanoseconds();
+            outputAllocations += measurement.Allocations();
+        }
+        output.CloseFile();
+        result["output_ns_per_event"] = outputNanoseconds / nEvents;
+        result["output_allocs_per_event"] = G4double(outputAllocations) / nEvents;
+    }
+    std::remove(ColumnarOutput::MakeFileName(fileName).c_str());
+
+    return result;
+}
+
+void PrintResult(const std::string& name, const nlohmann::json& result) {
+    std::cout << std::fixed << std::setprecision(2)
+              << std::setw(22) << std::left << name << std::right
+              << std::setw(9) << result["hits_per_event"].get<G4double>()
+              << std::setw(11) << result["hitstore_ns_per_hit"].get<G4double>()
+              << std::setw(11) << result["hitscollection_ns_per_hit"].get<G4double>()
+              << std::setw(11) << result["clustering_ns_per_hit"].get<G4double>()
+              << std::setw(11) << result["legacy_clustering_ns_per_hit"].get<G4double>()
+              << std::setw(11) << result["output_ns_per_event"].get<G4double>()
+              << std::setw(9) << result["hitstore_allocs_per_event"].get<G4double>()
+              << std::setw(9) << result["hitscollection_allocs_per_event"].get<G4double>()
+              << std::setw(9) << result["clustering_allocs_per_event"].get<G4double>()
+              << std::setw(9) << result["output_allocs_per_event"].get<G4double>()
+              << std::setw(10) << (result["mismatched_events"].get<size_t>() == 0 ? "yes" : "NO")
+              << std::endl;
+}
+
+/**
+ * @brief Compares the timings with a baseline. Returns false if a timing exceeds the allowed slowdown.
+ */
+G4bool CompareWithBaseline(const nlohmann::json& results, const nlohmann::json& baseline, G4double maxSlowdown) {
+    G4bool ok = true;
+    std::cout << "\nComparison with baseline (current / baseline):" << std::endl;
+    for (auto set = results.begin(); set != results.end(); ++set) {
+        if (!baseline.contains(set.key())) continue;
+        const auto& reference = baseline[set.key()];
+        for (auto metric = set.value().begin(); metric != set.value().end(); ++metric) {
+            const std::string& key = metric.key();
+            G4bool isTiming = key.find("_ns_per_") != std::string::npos;
+            if (!isTiming || !reference.contains(key)) continue;
+            G4double referenceValue = reference[key].get<G4double>();
+            if (referenceValue <= 0.) continue;
+            G4double ratio = metric.value().get<G4double>() / referenceValue;
+            G4bool tooSlow = maxSlowdown > 0. && ratio > maxSlowdown;
+            if (tooSlow) ok = false;
+            std::cout << "  " << std::setw(22) << std::left << set.key() << std::setw(34) << key << std::right
+                      << std::setw(8) << std::setprecision(3) << ratio << (tooSlow ? "  SLOWER" : "") << std::endl;
+        }
+    }
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        auto next = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                PrintUsage();
+                std::exit(3);
+            }
+            return argv[++i];
+        };
+        if (argument == "-e" || argument == "--events") options.nEvents = std::stoul(next());
+        else if (argument == "-m" || argument == "--multiplicities") options.multiplicities = ParseList(next());
+        else if (argument == "--hits") options.hitsFile = next();
+        else if (argument == "--write-hits") options.writeHitsFile = next();
+        else if (argument == "--spatial") options.spatialThreshold = std::stod(next()) * mm;
+        else if (argument == "--time") options.timeThreshold = std::stod(next()) * ns;
+        else if (argument == "--baseline") options.baselineFile = next();
+        else if (argument == "--write-baseline") options.writeBaselineFile = next();
+        else if (argument == "--max-slowdown") options.maxSlowdown = std::stod(next());
+        else if (argument == "--output-dir") options.outputDir = next();
+        else {
+            PrintUsage();
+            return 3;
+        }
+    }
+
+    std::vector<HitSet> hitSets;
+    for (size_t multiplicity : options.multiplicities) {
+        // keep the total number of hits per set bounded
+        size_t nEvents = std::max<size_t>(1, std::min(options.nEvents, 2000000 / std::max<size_t>(multiplicity, 1)));
+        hitSets.push_back(MakeSyntheticHitSet(nEvents, multiplicity, 12345));
+    }
+    if (!options.writeHitsFile.empty() && !hitSets.empty()) WriteHitSet(hitSets.front(), options.writeHitsFile);
+    if (!options.hitsFile.empty()) hitSets.push_back(ReadHitSet(options.hitsFile));
+
+    std::cout << "spatial threshold = " << options.spatialThreshold / mm << " mm, time threshold = "
+              << options.timeThreshold / ns << " ns\n" << std::endl;
+    std::cout << std::setw(22) << std::left << "hit set" << std::right
+              << std::setw(9) << "hits/ev" << std::setw(11) << "store" << std::setw(11) << "collect."
+              << std::setw(11) << "cluster" << std::setw(11) << "legacy" << std::setw(11) << "output"
+              << std::setw(9) << "a:store" << std::setw(9) << "a:coll." << std::setw(9) << "a:clus."
+              << std::setw(9) << "a:out" << std::setw(10) << "identical" << std::endl;
+    std::cout << std::setw(22) << "" << std::setw(9) << "" << std::setw(11) << "ns/hit" << std::setw(11) << "ns/hit"
+              << std::setw(11) << "ns/hit" << std::setw(11) << "ns/hit" << std::setw(11) << "ns/event"
+              << std::setw(9) << "/event" << std::setw(9) << "/event" << std::setw(9) << "/event"
+              << std::setw(9) << "/event" << std::endl;
+
+    nlohmann::json results;
+    G4bool identical = true;
+    for (const auto& hitSet : hitSets) {
+        nlohmann::json result = RunHitSet(hitSet, options);
+        PrintResult(hitSet.name, result);
+        if (result["mismatched_events"].get<size_t>() > 0) identical = false;
+        results[hitSet.name] = result;
+    }
+
+    if (!options.writeBaselineFile.empty()) {
+        std::ofstream file(options.writeBaselineFile);
+        file << results.dump(2) << std::endl;
+        std::cout << "\nBaseline written to " << options.writeBaselineFile << std::endl;
+    }
+
+    G4bool fastEnough = true;
+    if (!options.baselineFile.empty()) {
+        std::ifstream file(options.baselineFile);
+        if (!file) {
+            std::cerr << "Cannot open baseline " << options.baselineFile << std::endl;
+            return 3;
+        }
+        nlohmann::json baseline = nlohmann::json::parse(file);
+        fastEnough = CompareWithBaseline(results, baseline, options.maxSlowdown);
+    }
+
+    if (!identical) {
+        std::cerr << "\nERROR: the clusters differ from the original clustering" << std::endl;
+        return 1;
+    }
+    if (!fastEnough) {
+        std::cerr << "\nERROR: slower than the baseline by more than a factor " << options.maxSlowdown << std::endl;
+        return 2;
+    }
+    return 0;
+}
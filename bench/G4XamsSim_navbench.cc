@@ -0,0 +1,387 @@
+//
+// Navigation benchmark and hotspot report for a geometry file of G4XamsSim.
+//
+// The geometry is built with the DetectorConstruction of the simulation (materials, LoadGeometryFromJson, boolean
+// flattening), and the geometry is closed with voxel optimisation, as at the start of a run. Then
+//   - points: random points in the sampling box are located (G4Navigator::LocateGlobalPointAndSetup) and their
+//             safety is computed (ComputeSafety)
+//   - rays:   straight rays from random points in isotropic directions are followed to the edge of the world with
+//             ComputeStep and the relocation after every step, as in transportation without a field
+// Every call is timed and charged to the logical volume it ends in (locate, safety) or starts in (step). The report
+// ranks the volumes by their total time, with the solid type, the depth of boolean solids and the number of
+// daughters, and sums the time per solid type. No run manager or physics is needed.
+//
+// Usage: G4XamsSim_navbench -g geometry.json -m materials.json [options]
+//   -g, --geometry FILE     geometry file
+//   -m, --materials FILE    material file
+//   -p, --points N          number of random points (default 1000000)
+//   -r, --rays N            number of random rays (default 100000)
+//   --max-steps N           maximum number of steps per ray (default 10000)
+//   --half-size MM          sample in a box of this half size around the origin (default: the box around the
+//                           daughters of the world)
+//   --seed N                seed of the random points (default 12345)
+//   --no-flatten            keep the boolean solids (/detector/flattenBooleans false), to compare
+//   --top N                 number of volumes in the table (default 20)
+//   --json FILE             also write the report as JSON
+//
+// Exit code: 0 on success, 3 on a usage error.
+//
+
+#include "DetectorConstruction.hh"
+
+#include "G4BooleanSolid.hh"
+#include "G4DisplacedSolid.hh"
+#include "G4GeometryManager.hh"
+#include "G4LogicalVolume.hh"
+#include "G4Navigator.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4ThreeVector.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4VSolid.hh"
+#include "nlohmann/json.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace G4Sim;
+
+namespace {
+
+struct Options {
+    std::string geometryFile;
+    std::string materialFile;
+    size_t nPoints = 1000000;
+    size_t nRays = 100000;
+    size_t maxSteps = 10000;
+    G4double halfSize = 0.;
+    unsigned long seed = 12345;
+    G4bool flatten = true;
+    size_t top = 20;
+    std::string jsonFile;
+};
+
+/**
+ * @brief Number of calls and time of one navigation operation.
+ */
+struct Timing {
+    std::uint64_t calls = 0;
+    G4double ns = 0.;
+
+    void Add(G4double time) {
+        calls++;
+        ns += time;
+    }
+    G4double PerCall() const { return calls ? ns / calls : 0.; }
+};
+
+/**
+ * @brief The timings charged to one logical volume, and what describes its cost.
+ */
+struct VolumeStats {
+    G4String name;
+    G4String solidType;
+    G4int booleanDepth = 0;  // 0 for a solid that is not boolean
+    G4int components = 1;    // solids in the boolean tree
+    size_t daughters = 0;
+    Timing locate;
+    Timing safety;
+    Timing step;
+
+    G4double Total() const { return locate.ns + safety.ns + step.ns; }
+};
+
+using Clock = std::chrono::steady_clock;
+
+G4double Nanoseconds(Clock::time_point start) {
+    return std::chrono::duration<G4double, std::nano>(Clock::now() - start).count();
+}
+
+void PrintUsage() {
+    std::cerr << "Usage: G4XamsSim_navbench -g geometry.json -m materials.json [-p points] [-r rays] [--max-steps n]"
+              << " [--half-size mm] [--seed n] [--no-flatten] [--top n] [--json file.json]" << std::endl;
+}
+
+/**
+ * @brief Depth of the boolean tree of a solid, and the number of solids in it.
+ */
+void DescribeSolid(const G4VSolid* solid, G4int& depth, G4int& components) {
+    if (auto* displaced = dynamic_cast<const G4DisplacedSolid*>(solid)) {
+        DescribeSolid(displaced->GetConstituentMovedSolid(), depth, components);
+        return;
+    }
+    auto* boolean = dynamic_cast<const G4BooleanSolid*>(solid);
+    if (!boolean) {
+        depth = 0;
+        components = 1;
+        return;
+    }
+    G4int depthA, depthB, componentsA, componentsB;
+    DescribeSolid(boolean->GetConstituentSolid(0), depthA, componentsA);
+    DescribeSolid(boolean->GetConstituentSolid(1), depthB, componentsB);
+    depth = 1 + std::max(depthA, depthB);
+    components = componentsA + componentsB;
+}
+
+/**
+ * @brief The box around the daughters of the world, large enough for any rotation of the daughters.
+ */
+void SamplingBox(const G4VPhysicalVolume* world, G4ThreeVector& low, G4ThreeVector& high) {
+    const G4LogicalVolume* logical = world->GetLogicalVolume();
+    if (logical->GetNoDaughters() == 0) {
+        logical->GetSolid()->BoundingLimits(low, high);
+        return;
+    }
+    for (size_t i = 0; i < logical->GetNoDaughters(); ++i) {
+        const G4VPhysicalVolume* daughter = logical->GetDaughter(i);
+        G4ThreeVector pMin, pMax;
+        daughter->GetLogicalVolume()->GetSolid()->BoundingLimits(pMin, pMax);
+        G4double radius = std::max(pMin.mag(), pMax.mag());
+        G4ThreeVector center = daughter->GetTranslation();
+        G4ThreeVector extent(radius, radius, radius);
+        if (i == 0) {
+            low = center - extent;
+            high = center + extent;
+            continue;
+        }
+        low.set(std::min(low.x(), center.x() - radius), std::min(low.y(), center.y() - radius),
+                std::min(low.z(), center.z() - radius));
+        high.set(std::max(high.x(), center.x() + radius), std::max(high.y(), center.y() + radius),
+                 std::max(high.z(), center.z() + radius));
+    }
+}
+
+/**
+ * @brief Collects the logical volumes of the geometry tree, with a description of their solids.
+ */
+void CollectVolumes(const G4LogicalVolume* logical, std::map<const G4LogicalVolume*, VolumeStats>& stats) {
+    if (stats.count(logical)) return;
+    VolumeStats& volume = stats[logical];
+    volume.name = logical->GetName();
+    volume.solidType = logical->GetSolid()->GetEntityType();
+    DescribeSolid(logical->GetSolid(), volume.booleanDepth, volume.components);
+    volume.daughters = logical->GetNoDaughters();
+    for (size_t i = 0; i < logical->GetNoDaughters(); ++i) CollectVolumes(logical->GetDaughter(i)->GetLogicalVolume(), stats);
+}
+
+G4String SolidTypeKey(const VolumeStats& volume) {
+    if (volume.booleanDepth == 0) return volume.solidType;
+    return volume.solidType + " depth " + std::to_string(volume.booleanDepth);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        auto next = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                PrintUsage();
+                std::exit(3);
+            }
+            return argv[++i];
+        };
+        if (argument == "-g" || argument == "--geometry") options.geometryFile = next();
+        else if (argument == "-m" || argument == "--materials") options.materialFile = next();
+        else if (argument == "-p" || argument == "--points") options.nPoints = std::stoul(next());
+        else if (argument == "-r" || argument == "--rays") options.nRays = std::stoul(next());
+        else if (argument == "--max-steps") options.maxSteps = std::stoul(next());
+        else if (argument == "--half-size") options.halfSize = std::stod(next()) * mm;
+        else if (argument == "--seed") options.seed = std::stoul(next());
+        else if (argument == "--no-flatten") options.flatten = false;
+        else if (argument == "--top") options.top = std::stoul(next());
+        else if (argument == "--json") options.jsonFile = next();
+        else {
+            PrintUsage();
+            return 3;
+        }
+    }
+    if (options.geometryFile.empty() || options.materialFile.empty()) {
+        PrintUsage();
+        return 3;
+    }
+
+    // the geometry as the simulation builds it
+    auto* detector = new DetectorConstruction();
+    detector->SetGeometryFileName(options.geometryFile);
+    detector->SetMaterialFileName(options.materialFile);
+    detector->SetFlattenBooleans(options.flatten);
+    G4VPhysicalVolume* world = detector->Construct();
+    G4GeometryManager::GetInstance()->CloseGeometry(true, false, world);
+
+    G4Navigator navigator;
+    navigator.SetWorldVolume(world);
+
+    std::map<const G4LogicalVolume*, VolumeStats> stats;
+    CollectVolumes(world->GetLogicalVolume(), stats);
+
+    G4ThreeVector low, high;
+    if (options.halfSize > 0.) {
+        low.set(-options.halfSize, -options.halfSize, -options.halfSize);
+        high.set(options.halfSize, options.halfSize, options.halfSize);
+    } else {
+        SamplingBox(world, low, high);
+    }
+
+    std::mt19937_64 engine(options.seed);
+    std::uniform_real_distribution<G4double> uniform(0., 1.);
+    auto randomPoint = [&]() {
+        return G4ThreeVector(low.x() + (high.x() - low.x()) * uniform(engine),
+                             low.y() + (high.y() - low.y()) * uniform(engine),
+                             low.z() + (high.z() - low.z()) * uniform(engine));
+    };
+    auto randomDirection = [&]() {
+        G4double cosTheta = 2. * uniform(engine) - 1.;
+        G4double sinTheta = std::sqrt(1. - cosTheta * cosTheta);
+        G4double phi = 2. * M_PI * uniform(engine);
+        return G4ThreeVector(sinTheta * std::cos(phi), sinTheta * std::sin(phi), cosTheta);
+    };
+
+    // cost of reading the clock, included in every timing
+    G4double overhead = 0.;
+    for (int i = 0; i < 100000; ++i) overhead += Nanoseconds(Clock::now());
+    overhead /= 100000;
+
+    // points: locate and safety
+    Clock::time_point pointsStart = Clock::now();
+    for (size_t n = 0; n < options.nPoints; ++n) {
+        G4ThreeVector point = randomPoint();
+        Clock::time_point start = Clock::now();
+        G4VPhysicalVolume* physical = navigator.LocateGlobalPointAndSetup(point, nullptr, false, true);
+        G4double locateTime = Nanoseconds(start);
+        if (!physical) continue;
+        VolumeStats& volume = stats[physical->GetLogicalVolume()];
+        volume.locate.Add(locateTime);
+
+        start = Clock::now();
+        navigator.ComputeSafety(point);
+        volume.safety.Add(Nanoseconds(start));
+    }
+    G4double pointsTime = Nanoseconds(pointsStart);
+
+    // rays: step to the next boundary and relocate, until the ray leaves the world
+    std::uint64_t nSteps = 0;
+    std::uint64_t nTruncated = 0;
+    Clock::time_point raysStart = Clock::now();
+    for (size_t n = 0; n < options.nRays; ++n) {
+        G4ThreeVector position = randomPoint();
+        G4ThreeVector direction = randomDirection();
+        Clock::time_point start = Clock::now();
+        G4VPhysicalVolume* physical = navigator.LocateGlobalPointAndSetup(position, &direction, false, false);
+        G4double locateTime = Nanoseconds(start);
+        if (physical) stats[physical->GetLogicalVolume()].locate.Add(locateTime);
+
+        size_t step = 0;
+        for (; physical && step < options.maxSteps; ++step) {
+            VolumeStats& volume = stats[physical->GetLogicalVolume()];
+            G4double safety = 0.;
+            start = Clock::now();
+            G4double length = navigator.ComputeStep(position, direction, kInfinity, safety);
+            if (length == kInfinity) {
+                volume.step.Add(Nanoseconds(start));
+                physical = nullptr;
+                break;
+            }
+            position += length * direction;
+            navigator.SetGeometricallyLimitedStep();
+            physical = navigator.LocateGlobalPointAndSetup(position, &direction, true);
+            volume.step.Add(Nanoseconds(start));
+        }
+        nSteps += step;
+        if (physical) nTruncated++;
+    }
+    G4double raysTime = Nanoseconds(raysStart);
+
+    // volumes ranked by their total time
+    std::vector<const VolumeStats*> ranked;
+    G4double total = 0.;
+    for (const auto& entry : stats) {
+        ranked.push_back(&entry.second);
+        total += entry.second.Total();
+    }
+    std::sort(ranked.begin(), ranked.end(), [](const VolumeStats* a, const VolumeStats* b) { return a->Total() > b->Total(); });
+
+    std::map<G4String, Timing> locateByType, safetyByType, stepByType;
+    std::map<G4String, size_t> volumesByType;
+    for (const VolumeStats* volume : ranked) {
+        G4String key = SolidTypeKey(*volume);
+        volumesByType[key]++;
+        locateByType[key].calls += volume->locate.calls;
+        locateByType[key].ns += volume->locate.ns;
+        safetyByType[key].calls += volume->safety.calls;
+        safetyByType[key].ns += volume->safety.ns;
+        stepByType[key].calls += volume->step.calls;
+        stepByType[key].ns += volume->step.ns;
+    }
+
+    std::cout << "\nsampling box (mm): " << low / mm << " - " << high / mm << "\n"
+              << options.nPoints << " points in " << pointsTime / 1e6 << " ms, " << options.nRays << " rays with "
+              << nSteps << " steps in " << raysTime / 1e6 << " ms (" << nTruncated << " rays stopped at "
+              << options.maxSteps << " steps)\n"
+              << "timer overhead " << std::setprecision(3) << overhead << " ns per call, included below\n" << std::endl;
+
+    std::cout << std::setw(24) << std::left << "volume" << std::setw(22) << "solid" << std::right << std::setw(6)
+              << "depth" << std::setw(6) << "parts" << std::setw(7) << "daugh." << std::setw(11) << "locate"
+              << std::setw(11) << "safety" << std::setw(11) << "step" << std::setw(11) << "steps" << std::setw(8)
+              << "share" << std::endl;
+    std::cout << std::setw(66) << "" << std::setw(11) << "ns/call" << std::setw(11) << "ns/call" << std::setw(11)
+              << "ns/call" << std::setw(11) << "" << std::setw(8) << "%" << std::endl;
+    std::cout << std::fixed << std::setprecision(1);
+    for (size_t i = 0; i < ranked.size() && i < options.top; ++i) {
+        const VolumeStats& volume = *ranked[i];
+        std::cout << std::setw(24) << std::left << volume.name << std::setw(22) << volume.solidType << std::right
+                  << std::setw(6) << volume.booleanDepth << std::setw(6) << volume.components << std::setw(7)
+                  << volume.daughters << std::setw(11) << volume.locate.PerCall() << std::setw(11)
+                  << volume.safety.PerCall() << std::setw(11) << volume.step.PerCall() << std::setw(11)
+                  << volume.step.calls << std::setw(8) << (total > 0. ? 100. * volume.Total() / total : 0.) << std::endl;
+    }
+
+    std::cout << "\n" << std::setw(30) << std::left << "solid type" << std::right << std::setw(8) << "volumes"
+              << std::setw(11) << "locate" << std::setw(11) << "safety" << std::setw(11) << "step" << std::setw(8)
+              << "share" << std::endl;
+    for (const auto& entry : volumesByType) {
+        const G4String& key = entry.first;
+        G4double typeTotal = locateByType[key].ns + safetyByType[key].ns + stepByType[key].ns;
+        std::cout << std::setw(30) << std::left << key << std::right << std::setw(8) << entry.second << std::setw(11)
+                  << locateByType[key].PerCall() << std::setw(11) << safetyByType[key].PerCall() << std::setw(11)
+                  << stepByType[key].PerCall() << std::setw(8) << (total > 0. ? 100. * typeTotal / total : 0.)
+                  << std::endl;
+    }
+
+    if (!options.jsonFile.empty()) {
+        auto timing = [](const Timing& t) { return nlohmann::json{{"calls", t.calls}, {"ns", t.ns}}; };
+        nlohmann::json report;
+        report["geometry"] = options.geometryFile;
+        report["flattenBooleans"] = options.flatten;
+        report["points"] = options.nPoints;
+        report["rays"] = options.nRays;
+        report["steps"] = nSteps;
+        report["timerOverheadNs"] = overhead;
+        for (const VolumeStats* volume : ranked) {
+            report["volumes"].push_back({{"name", volume->name}, {"solid", volume->solidType},
+                                         {"booleanDepth", volume->booleanDepth}, {"components", volume->components},
+                                         {"daughters", volume->daughters}, {"locate", timing(volume->locate)},
+                                         {"safety", timing(volume->safety)}, {"step", timing(volume->step)}});
+        }
+        for (const auto& entry : volumesByType) {
+            const G4String& key = entry.first;
+            report["solidTypes"][key] = {{"volumes", entry.second}, {"locate", timing(locateByType[key])},
+                                         {"safety", timing(safetyByType[key])}, {"step", timing(stepByType[key])}};
+        }
+        std::ofstream file(options.jsonFile);
+        file << report.dump(2) << std::endl;
+        std::cout << "\nReport written to " << options.jsonFile << std::endl;
+    }
+
+    G4GeometryManager::GetInstance()->OpenGeometry(world);
+    return 0;
+}
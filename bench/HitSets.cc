@@ -0,0 +1,121 @@
+#include "HitSets.hh"
+
+#include "G4EmProcessSubType.hh"
+
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+/**
+ * @namespace G4Sim
+ * @brief Namespace for the G4Sim library.
+/*/
+namespace G4Sim {
+
+namespace {
+    const size_t kDepositsPerInteraction = 50;
+    const G4double kDetectorRadius = 50.;       // mm
+    const G4double kTrackSpread = 0.5;          // mm, spread of the electron track deposits
+    const G4double kInteractionTimeScale = 1.;  // ns, mean time between interactions
+}
+
+HitSet MakeSyntheticHitSet(size_t nEvents, size_t multiplicity, unsigned int seed) {
+    HitSet hitSet;
+    hitSet.name = "synthetic_" + std::to_string(multiplicity);
+
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<G4double> uniform(-kDetectorRadius, kDetectorRadius);
+    std::normal_distribution<G4double> spread(0., kTrackSpread);
+    std::exponential_distribution<G4double> interval(1. / kInteractionTimeScale);
+    std::exponential_distribution<G4double> energy(1. / 0.001);  // MeV
+
+    for (size_t event = 0; event < nEvents; ++event) {
+        G4double x0 = 0., y0 = 0., z0 = 0., t0 = 0.;
+        G4int track = 0;
+        for (size_t i = 0; i < multiplicity; ++i) {
+            G4int processID;
+            if (i % kDepositsPerInteraction == 0) {
+                // a new interaction point, the last one of the event is photo-electric
+                x0 = uniform(rng);
+                y0 = uniform(rng);
+                z0 = uniform(rng);
+                t0 += interval(rng);
+                track++;
+                processID = (i + kDepositsPerInteraction >= multiplicity) ? fPhotoElectricEffect : fComptonScattering;
+            } else {
+                processID = (i % 3 == 0) ? fMultipleScattering : fIonisation;
+            }
+            hitSet.x.push_back(x0 + spread(rng));
+            hitSet.y.push_back(y0 + spread(rng));
+            hitSet.z.push_back(z0 + spread(rng));
+            hitSet.time.push_back(t0 + 1.e-3 * (i % kDepositsPerInteraction));
+            hitSet.energyDeposit.push_back(energy(rng));
+            hitSet.processID.push_back(processID);
+            hitSet.trackID.push_back(track);
+        }
+        hitSet.eventBegin.push_back(hitSet.x.size());
+    }
+    return hitSet;
+}
+
+HitSet ReadHitSet(const std::string& fileName) {
+    std::ifstream file(fileName);
+    if (!file) throw std::runtime_error("cannot open hit set " + fileName);
+
+    HitSet hitSet;
+    hitSet.name = fileName;
+
+    std::string line;
+    long currentEvent = 0;
+    G4bool first = true;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#' || std::isalpha(static_cast<unsigned char>(line[0]))) continue;
+        for (auto& c : line) {
+            if (c == ',') c = ' ';
+        }
+        std::istringstream fields(line);
+        long event;
+        G4double x, y, z, time, edep;
+        G4int processID, trackID = 0;
+        if (!(fields >> event >> x >> y >> z >> time >> edep >> processID)) {
+            throw std::runtime_error("bad line in " + fileName + ": " + line);
+        }
+        fields >> trackID;
+
+        if (!first && event != currentEvent) hitSet.eventBegin.push_back(hitSet.x.size());
+        currentEvent = event;
+        first = false;
+
+        hitSet.x.push_back(x);
+        hitSet.y.push_back(y);
+        hitSet.z.push_back(z);
+        hitSet.time.push_back(time);
+        hitSet.energyDeposit.push_back(edep);
+        hitSet.processID.push_back(processID);
+        hitSet.trackID.push_back(trackID);
+    }
+    if (!first) hitSet.eventBegin.push_back(hitSet.x.size());
+    return hitSet;
+}
+
+void WriteHitSet(const HitSet& hitSet, const std::string& fileName) {
+    std::ofstream file(fileName);
+    if (!file) throw std::runtime_error("cannot write hit set " + fileName);
+    file.precision(17);
+
+    file << "event,x,y,z,time,edep,processID,trackID\n";
+    for (size_t event = 0; event < hitSet.GetNumberOfEvents(); ++event) {
+        for (size_t i = hitSet.eventBegin[event]; i < hitSet.eventBegin[event + 1]; ++i) {
+            file << event << "," << hitSet.x[i] << "," << hitSet.y[i] << "," << hitSet.z[i] << ","
+                 << hitSet.time[i] << "," << hitSet.energyDeposit[i] << "," << hitSet.processID[i] << ","
+                 << hitSet.trackID[i] << "\n";
+        }
+    }
+}
+
+} // namespace G4Sim
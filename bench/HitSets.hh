@@ -0,0 +1,59 @@
+#ifndef HIT_SETS_HH
+#define HIT_SETS_HH
+
+#include "G4Types.hh"
+
+#include <string>
+#include <vector>
+
+/**
+ * @namespace G4Sim
+ * @brief Namespace for the G4Sim library.
+/*/
+namespace G4Sim {
+
+/**
+ * @struct HitSet
+ * @brief Deposits of a number of events, replayed by the benchmark.
+ *
+ * The deposits of event i are the elements [eventBegin[i], eventBegin[i+1]) of the arrays. Units are the Geant4
+ * internal units: mm, ns and MeV.
+ */
+struct HitSet {
+    std::string name;
+    std::vector<size_t> eventBegin{0};
+    std::vector<G4double> x;
+    std::vector<G4double> y;
+    std::vector<G4double> z;
+    std::vector<G4double> time;
+    std::vector<G4double> energyDeposit;
+    std::vector<G4int> processID;
+    std::vector<G4int> trackID;
+
+    size_t GetNumberOfEvents() const { return eventBegin.size() - 1; }
+    size_t GetNumberOfHits() const { return x.size(); }
+};
+
+/**
+ * @brief Generates events that look like gamma interactions in liquid xenon.
+ *
+ * Every event has `multiplicity` deposits, grouped around interaction points that start with a Compton or
+ * photo-electric deposit followed by the electron track, at about 50 deposits per interaction point.
+ */
+HitSet MakeSyntheticHitSet(size_t nEvents, size_t multiplicity, unsigned int seed);
+
+/**
+ * @brief Reads recorded deposits from a CSV file with the columns event,x,y,z,time,edep,processID[,trackID].
+ *
+ * Lines starting with '#' or a letter (a header) are skipped. Deposits of one event must be consecutive.
+ */
+HitSet ReadHitSet(const std::string& fileName);
+
+/**
+ * @brief Writes a hit set as CSV, in the format read by ReadHitSet().
+ */
+void WriteHitSet(const HitSet& hitSet, const std::string& fileName);
+
+} // namespace G4Sim
+
+#endif
@@ -0,0 +1,85 @@
+#include "LegacyClustering.hh"
+
+#include "G4SystemOfUnits.hh"
+#include "G4EmProcessSubType.hh"
+
+#include <cmath>
+
+/**
+ * @namespace G4Sim
+ * @brief Namespace for the G4Sim library.
+/*/
+namespace G4Sim {
+
+void LegacyClusterHits(std::vector<LegacyHit>& hits, G4double spatialThreshold, G4double timeThreshold,
+                       std::vector<Cluster>& clusters) {
+    if (hits.empty()) return;
+
+    // the original clusters kept the list of their hits, only its size was used
+    std::vector<std::vector<LegacyHit*>> clusterHits;
+
+    G4double startTime = hits[0].time;
+    for (const auto& hit : hits) {
+        if (hit.time < startTime) startTime = hit.time;
+    }
+    for (auto& hit : hits) {
+        hit.time -= startTime;
+    }
+
+    for (auto& hit : hits) {
+        if (hit.processID == fComptonScattering || hit.processID == fPhotoElectricEffect) {
+            clusters.push_back(Cluster{hit.position, hit.energyDeposit, hit.time, 1, 0});
+            clusterHits.push_back({&hit});
+            hit.used = true;
+        }
+    }
+
+    for (auto& hit : hits) {
+        if (hit.used) continue;
+
+        bool addedToCluster = false;
+        for (size_t c = 0; c < clusters.size(); ++c) {
+            Cluster& cluster = clusters[c];
+            if ((hit.position - cluster.position).mag() < spatialThreshold &&
+                std::fabs(hit.time - cluster.time) < timeThreshold) {
+                if (hit.energyDeposit > 0 * eV) {
+                    G4int clusterSize = clusterHits[c].size();
+                    cluster.position = (cluster.position * clusterSize + hit.position) / (clusterSize + 1);
+                    cluster.energyDeposit += hit.energyDeposit;
+                    cluster.time = (cluster.time * clusterSize + hit.time) / (clusterSize + 1);
+                    clusterHits[c].push_back(&hit);
+                    addedToCluster = true;
+                    break;
+                }
+            }
+        }
+        if (!addedToCluster) {
+            clusters.push_back(Cluster{hit.position, hit.energyDeposit, hit.time, 1, 0});
+            clusterHits.push_back({&hit});
+        }
+    }
+
+    for (size_t i = 0; i < clusters.size(); ++i) {
+        for (size_t j = i + 1; j < clusters.size();) {
+            if ((clusters[i].position - clusters[j].position).mag() < spatialThreshold &&
+                std::fabs(clusters[i].time - clusters[j].time) < timeThreshold) {
+                G4int totalHits = clusterHits[i].size() + clusterHits[j].size();
+                clusters[i].position = (clusters[i].position * clusterHits[i].size() + clusters[j].position * clusterHits[j].size()) / totalHits;
+                clusters[i].energyDeposit += clusters[j].energyDeposit;
+                clusters[i].time = (clusters[i].time * clusterHits[i].size() + clusters[j].time * clusterHits[j].size()) / totalHits;
+                clusterHits[i].insert(clusterHits[i].end(), clusterHits[j].begin(), clusterHits[j].end());
+
+                clusters.erase(clusters.begin() + j);
+                clusterHits.erase(clusterHits.begin() + j);
+            } else {
+                ++j;
+            }
+        }
+    }
+
+    for (size_t c = 0; c < clusters.size(); ++c) {
+        clusters[c].nHits = clusterHits[c].size();
+    }
+}
+
+} // namespace G4Sim
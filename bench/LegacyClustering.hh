@@ -0,0 +1,44 @@
+#ifndef LEGACY_CLUSTERING_HH
+#define LEGACY_CLUSTERING_HH
+
+#include "G4ThreeVector.hh"
+#include "G4Types.hh"
+#include "Cluster.hh"
+
+#include <vector>
+
+/**
+ * @namespace G4Sim
+ * @brief Namespace for the G4Sim library.
+/*/
+namespace G4Sim {
+
+/**
+ * @struct LegacyHit
+ * @brief The hit properties used by the original clustering.
+ */
+struct LegacyHit {
+    G4ThreeVector position;
+    G4double energyDeposit;
+    G4double time;
+    G4int processID;
+    G4bool used;
+};
+
+/**
+ * @brief The clustering of EventAction before the HitClusterer, kept as the reference for the benchmark.
+ *
+ * Every hit is compared with every cluster, and the merge step erases from the middle of the cluster vector.
+ * The output of HitClusterer::ClusterDeposits must be identical to the output of this function.
+ *
+ * @param hits The hits of one collection. The times are normalized and the seeds are flagged as used.
+ * @param spatialThreshold The spatial threshold for clustering.
+ * @param timeThreshold The time threshold for clustering.
+ * @param clusters The vector to append the clusters to.
+ */
+void LegacyClusterHits(std::vector<LegacyHit>& hits, G4double spatialThreshold, G4double timeThreshold,
+                       std::vector<Cluster>& clusters);
+
+} // namespace G4Sim
+
+#endif
@@ -13,25 +13,29 @@
 namespace G4Sim
 {
 
+class DetectorConstruction;
+
 /**
  * @class ActionInitialization
  * @brief Initializes user actions for the Geant4 simulation.
  *
  * This class inherits from G4VUserActionInitialization and is responsible for
  * setting up the actions that will be used during the simulation. It provides
- * methods to build actions for both master and worker threads.
+ * methods to build actions for both master and worker threads. The detector construction is handed to
+ * the event actions, so that each thread can set up its own readout of the active volumes.
  *
  * @note The destructor is defined as default.
  */
 class ActionInitialization : public G4VUserActionInitialization
 {
   public:
-    ActionInitialization();
+    ActionInitialization(const DetectorConstruction* detector);
     ~ActionInitialization() override = default;
 
     void BuildForMaster() const override;
     void Build() const override;
   private:
+    const DetectorConstruction* fDetector = nullptr;
 };
 
 }
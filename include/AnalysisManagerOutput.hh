@@ -0,0 +1,50 @@
+#ifndef ANALYSIS_MANAGER_OUTPUT_HH
+#define ANALYSIS_MANAGER_OUTPUT_HH
+
+#include "OutputBackend.hh"
+
+/**
+ * @namespace G4Sim
+ * @brief Namespace for the G4Sim library.
+/*/
+namespace G4Sim {
+
+/**
+ * @class AnalysisManagerOutput
+ * @brief Output backend that writes a ROOT ntuple with the G4AnalysisManager.
+ *
+ * This is the original output of G4XamsSim. In a multithreaded run the rows of the workers are merged into the
+ * file of the master.
+ *
+ * The G4AnalysisManager of a thread keeps its ntuples for the whole job, so the ntuple is booked in the first run
+ * only. In later runs (e.g. the runs of a batch manifest) a new file is opened and the booked ntuple, which is bound
+ * to the same EventAction vectors, is reused.
+ */
+class AnalysisManagerOutput : public OutputBackend {
+public:
+    AnalysisManagerOutput() = default;
+    ~AnalysisManagerOutput() override = default;
+
+    void OpenFile(const G4String& fileName) override;
+    void CreateNtuple(const G4String& name, const G4String& title) override;
+    G4int CreateDColumn(const G4String& name) override;
+    G4int CreateDColumn(const G4String& name, std::vector<G4double>& values) override;
+    G4int CreateIColumn(const G4String& name, std::vector<G4int>& values) override;
+    void FinishNtuple() override;
+
+    void FillDColumn(G4int column, G4double value) override;
+    void AddRow() override;
+
+    void Write() override;
+    void CloseFile() override;
+    G4bool IsThreadLocal() const override { return true; }
+
+private:
+    G4int fNtupleId = -1;
+    G4bool fBooked = false;  // the ntuple was booked in an earlier run
+    G4int fNColumns = 0;
+};
+
+} // namespace G4Sim
+
+#endif
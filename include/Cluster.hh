@@ -1,9 +1,8 @@
 #ifndef CLUSTER_HH
 #define CLUSTER_HH
 
-#include <vector>
 #include "G4ThreeVector.hh"
-#include "Hit.hh"
+#include "G4Types.hh"
 
 /**
  * @namespace G4Sim
@@ -15,14 +14,16 @@ namespace G4Sim {
  * @struct Cluster
  * @brief A struct representing a cluster of hits in the simulation.
  *
- * The Cluster struct represents a cluster of hits in the simulation, with a position, energy deposit, time, and a vector of hits.
+ * The Cluster struct represents a cluster of hits in the simulation, with a position, energy deposit, time, and the
+ * number of hits that were combined into it. The weight is the energy weighted mean of the track weights of its hits.
  */
 struct Cluster {
     G4ThreeVector position;
     G4double energyDeposit;
     G4double time;
-    std::vector<Hit*> hits;
+    G4int nHits;
     G4int collectionID;
+    G4double weight = 1.;
 };
 
 } // namespace G4FastSim
@@ -0,0 +1,97 @@
+#ifndef COLUMNAR_OUTPUT_HH
+#define COLUMNAR_OUTPUT_HH
+
+#include "OutputBackend.hh"
+
+#include <cstdint>
+#include <fstream>
+#include <vector>
+
+/**
+ * @namespace G4Sim
+ * @brief Namespace for the G4Sim library.
+/*/
+namespace G4Sim {
+
+/**
+ * @class ColumnarOutput
+ * @brief Output backend that writes a chunked columnar binary file (.xcol).
+ *
+ * Rows are collected in memory per column and written in chunks of a fixed number of rows. Within a chunk every
+ * scalar column is one array of values, and every jagged column is an array of nRows+1 offsets followed by an array
+ * with the values of all rows. All numbers are little endian (blocks are written from memory, so the build fails on
+ * a big endian host) and every block starts at a multiple of 8 bytes, so an uncompressed file can be memory mapped
+ * and used as numpy arrays without copying. The format is:
+ *
+ *     header:  "XAMSCOL1", uint32 compression, uint32 nColumns,
+ *              per column: uint32 type, uint32 name length, name (padded to 8 bytes)
+ *     chunk:   uint64 nRows, per column one block (scalar) or two blocks (jagged: offsets, values)
+ *     block:   uint64 raw size, uint64 stored size, data (padded to 8 bytes)
+ *     footer:  uint64 nChunks, per chunk uint64 file offset and uint64 nRows,
+ *              uint64 footer offset, "XAMSEND1"
+ *
+ * Column types are 0 (double), 1 (jagged double) and 2 (jagged int32). Offsets are uint64 and start at 0 in every
+ * chunk. With zstd compression a block is compressed if that makes it smaller, which shows as a stored size below
+ * the raw size. Compression is only available if G4XamsSim is built with WITH_ZSTD.
+ *
+ * Each thread writes its own file. analysis/ColumnarReader.py reads the files with numpy.
+ */
+class ColumnarOutput : public OutputBackend {
+public:
+    enum Compression { kNone = 0, kZstd = 1 };
+
+    ColumnarOutput(size_t chunkSize, Compression compression);
+    ~ColumnarOutput() override;
+
+    void OpenFile(const G4String& fileName) override;
+    void CreateNtuple(const G4String& name, const G4String& title) override;
+    G4int CreateDColumn(const G4String& name) override;
+    G4int CreateDColumn(const G4String& name, std::vector<G4double>& values) override;
+    G4int CreateIColumn(const G4String& name, std::vector<G4int>& values) override;
+    void FinishNtuple() override;
+
+    void FillDColumn(G4int column, G4double value) override;
+    void AddRow() override;
+
+    void Write() override;
+    void CloseFile() override;
+    G4bool IsThreadLocal() const override { return false; }
+
+    static G4String MakeFileName(const G4String& fileName);
+
+private:
+    enum ColumnType : std::uint32_t { kDouble = 0, kJaggedDouble = 1, kJaggedInt = 2 };
+
+    struct Column {
+        G4String name;
+        ColumnType type;
+        G4double value = 0.;                              // current value of a scalar column
+        const std::vector<G4double>* doubleSource = nullptr; // bound vector of a jagged double column
+        const std::vector<G4int>* intSource = nullptr;       // bound vector of a jagged int column
+        std::vector<std::uint64_t> offsets;               // chunk buffers
+        std::vector<G4double> doubleValues;
+        std::vector<std::int32_t> intValues;
+    };
+
+    void WriteHeader();
+    void FlushChunk();
+    void WriteBlock(const void* data, std::uint64_t size);
+    void WriteRaw(const void* data, size_t size);
+    void Pad();
+
+    size_t fChunkSize;
+    Compression fCompression;
+
+    std::ofstream fFile;
+    G4String fFileName;
+    std::uint64_t fPosition = 0;
+    std::vector<Column> fColumns;
+    size_t fRowsInChunk = 0;
+    std::vector<std::uint64_t> fChunkOffsets;
+    std::vector<std::uint64_t> fChunkRows;
+    std::vector<char> fCompressBuffer;
+};
+
+} // namespace G4Sim
+
+#endif
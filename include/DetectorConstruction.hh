@@ -9,11 +9,15 @@
 #include "G4VSolid.hh"
 #include "DetectorConstructionMessenger.hh"
 #include "Materials.hh"
+#include "SensitiveVolume.hh"
+#include "TerminationPolicy.hh"
+#include "VolumeImportance.hh"
 
 #include "nlohmann/json.hpp"
 
 #include <map>
 #include <string>
+#include <vector>
 
 /**
  * @namespace G4Sim
@@ -31,6 +35,13 @@ namespace G4Sim {
  * The class also contains maps to store logical and physical volumes for easy lookup, as well as the world physical and logical volumes.
  * It has a flag to check for overlaps and a pointer to the Materials class.
  * The class also has a member variable to store the JSON file name and a pointer to the DetectorConstructionMessenger class.
+ *
+ * With a geometry cache directory (/detector/geometryCache) the constructed geometry is stored as GDML plus its
+ * metadata (see GeometryCache), and later jobs with the same geometry and material files load it from there.
+ *
+ * Unions and subtractions of coaxial, unrotated tubs are replaced by an equivalent polycone (see SolidFlattener),
+ * which is much cheaper to navigate. This is switched off with /detector/flattenBooleans false, or per volume with
+ * "flatten": false in the geometry file.
  */
 class DetectorConstruction : public G4VUserDetectorConstruction {
 public:
@@ -38,20 +49,41 @@ public:
     ~DetectorConstruction() override;
 
     G4VPhysicalVolume* Construct() override;
+    void ConstructSDandField() override;
         
     // set the JSON geometry file name
     void SetGeometryFileName(const std::string& fileName);
     void SetMaterialFileName(const std::string& fileName);
+    // default clustering mode of the active volumes
+    void SetStreamingClustering(G4bool value) { fStreamingClustering = value; }
+    void SetHitStore(G4bool value) { fHitStore = value; }
+    // directory of the geometry cache, no cache if empty
+    void SetGeometryCacheDirectory(const G4String& directory) { fGeometryCacheDirectory = directory; }
+    // replace boolean solids of tubs by polycones
+    void SetFlattenBooleans(G4bool value) { fFlattenBooleans = value; }
+
+    // active volumes and their clustering parameters, in the order of the JSON file
+    const std::vector<SensitiveVolume>& GetSensitiveVolumes() const { return fSensitiveVolumes; }
+    // volumes in which tracks are killed, see TerminationPolicy
+    const std::vector<TerminationPolicy>& GetTerminationPolicies() const { return fTerminationPolicies; }
+    // importance of every volume and the particles that are biased, empty without importance biasing
+    const std::vector<VolumeImportance>& GetVolumeImportances() const { return fVolumeImportances; }
+    const std::vector<G4String>& GetImportanceParticles() const { return fImportanceParticles; }
 
 private:
     G4VPhysicalVolume* PlaceVolume(const nlohmann::json& volumeDef, G4LogicalVolume* logicalVolume);
     G4RotationMatrix* GetRotationMatrix(const nlohmann::json& volumeDef);
     void SetAttributes(const nlohmann::json& volumeDef, G4LogicalVolume* logicalVolume);
+    void SetTerminationPolicy(const nlohmann::json& volumeDef, G4LogicalVolume* logicalVolume);
     void LoadGeometryFromJson(const std::string& jsonFileName);
-    void MakeVolumeSensitive(const G4String& volumeName, const G4String& collectionName);
+    void MakeVolumeSensitive(const SensitiveVolume& sensitiveVolume);
     G4LogicalVolume* ConstructVolume(const nlohmann::json& volumeDef);
     G4VSolid* CreateSolid(const nlohmann::json& solidDef);
+    G4VSolid* FlattenSolid(const nlohmann::json& volumeDef, G4VSolid* booleanSolid);
     G4LogicalVolume* GetLogicalVolume(const G4String& name);
+    G4VPhysicalVolume* BuildGeometry();
+    nlohmann::json MakeCacheMetadata() const;
+    void RestoreCacheMetadata(const nlohmann::json& metadata);
 
     // Maps to store logical and physical volumes for easy lookup
     std::map<G4String, G4LogicalVolume*> logicalVolumeMap;
@@ -68,7 +100,16 @@ private:
     std::string geoFileName;
     std::string matFileName;
     
-    std::map<G4String, std::pair<G4double, G4double>> fClusteringParameters;
+    std::vector<SensitiveVolume> fSensitiveVolumes;
+    std::vector<TerminationPolicy> fTerminationPolicies;
+    std::vector<VolumeImportance> fVolumeImportances;
+    std::vector<G4String> fImportanceParticles;
+    G4bool fStreamingClustering = false;
+    G4bool fHitStore = false;
+    G4String fGeometryCacheDirectory;
+    G4bool fFlattenBooleans = true;
+    G4int fNBooleanVolumes = 0;    // boolean volumes of the geometry file
+    G4int fNFlattenedVolumes = 0;  // of which replaced by a polycone
 
     DetectorConstructionMessenger* fMessenger;
 };
@@ -4,6 +4,7 @@
 #include "G4UImessenger.hh"
 #include "G4UIcmdWithADoubleAndUnit.hh"
 #include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithABool.hh"
 #include "globals.hh"
 
 /**
@@ -32,6 +33,10 @@ class DetectorConstructionMessenger : public G4UImessenger {
         DetectorConstruction* fDetectorConstruction;
         G4UIcmdWithAString* fGeometryFileNameCmd;  // New command to set geometry file name
         G4UIcmdWithAString* fMaterialFileNameCmd;  // New command to set material file name
+        G4UIcmdWithABool* fStreamingClusteringCmd;  // Command to cluster deposits while tracking
+        G4UIcmdWithABool* fHitStoreCmd;  // Command to store hits in per-property arrays
+        G4UIcmdWithAString* fGeometryCacheCmd;  // Command to set the geometry cache directory
+        G4UIcmdWithABool* fFlattenBooleansCmd;  // Command to replace boolean solids of tubs by polycones
 
 };
 
@@ -7,10 +7,17 @@
 #include "G4String.hh"
 #include "G4Types.hh"
 #include "Cluster.hh"
+#include "Hit.hh"
+#include "HitClusterer.hh"
+#include "HitStore.hh"
+#include "OutputBackend.hh"
+#include "EventRecord.hh"
+#include "EventTrigger.hh"
+#include "PhaseTimers.hh"
+#include "RunSummary.hh"
 #include "globals.hh"
 
 #include <vector>
-#include <mutex>
 
 ///
 /// Event action class
@@ -27,6 +34,10 @@ class G4VHitsCollection;
 namespace G4Sim
 {
 
+class DetectorConstruction;
+class SensitiveDetector;
+class EventPipeline;
+
 // Use enum to define the constants
 enum EventType {
     DIRECT_GAMMA = 0,
@@ -39,18 +50,43 @@ enum EventType {
  *
  * This class inherits from G4UserEventAction and provides methods for handling the beginning and end of events,
  * analyzing hits, and resetting variables. It also provides getter and setter methods for accessing event data.
- * The class includes functions for hit clustering and calculating distances and time differences.
+ * The hits of each collection are clustered with a HitClusterer owned by the event action.
  *
  * The variables stored for each event in the ntuple tree include the logarithm of the weight, energy deposition,
  * number of clusters, number of photons, number of components, event ID, event type, and position coordinates.
  * The class also includes vectors for storing energy deposition, position coordinates, and weights.
  *
- * The class uses a mutex for thread safety and includes a messenger for setting event action properties.
+ * Every thread owns its own EventAction. At the start of each run the sensitive volumes of the DetectorConstruction
+ * are turned into a readout plan: for each volume the hits collection ID or sensitive detector, the clustering
+ * thresholds and the output slot are resolved once, so the end of event path does no name lookups. No state is
+ * shared between threads.
+ *
+ * Optionally the clustering and output run on a dedicated thread (see EventPipeline): at the end of an event the
+ * deposits are copied into an EventRecord, and the tracking thread continues with the next event.
+ *
+ * Before any clustering the EventTrigger of this thread decides from the raw energy per active volume whether the
+ * event is written. Rejected events are dropped right away; events kept by the prescale are written with their
+ * weight multiplied by the prescale and the trigger column set to 0.
+ *
+ * The event weight (w) is the weight of the primary. Tracks can change weight through importance biasing (see
+ * SteppingAction), so every cluster has its own weight (wh): the energy weighted mean of the track weights of its
+ * deposits. Both include the prescale of the trigger.
+ *
+ * The event, clustering and output phases of the PhaseTimers are timed here. With the pipeline, clustering and
+ * output are timed on the consumer thread, and copying the event into the record counts as transport.
+ *
+ * Every written event is also filled into the RunSummary of this EventAction, also when there is no output.
+ *
+ * The per detector vectors have one of two layouts:
+ * - dense (default): one entry per active volume, in the order of the output slots, zero for volumes without
+ *   clusters.
+ * - sparse: one entry per active volume with clusters, and the detector index of each entry in det. Nothing is
+ *   written or reset for the other volumes, and nphot and ncomp, which are always zero, are left out.
  */
 class EventAction : public G4UserEventAction
 {
   public:
-    EventAction();
+    EventAction(const DetectorConstruction* detector);
     
     ~EventAction();
 
@@ -68,19 +104,33 @@ class EventAction : public G4UserEventAction
     // per detector information
     std::vector<G4double>& GetEdet(){return fEdet;};
     std::vector<G4int>& GetNdet(){return fNdet;};
-    std::vector<G4int>& GetNphot(){return fNphot;};
-    std::vector<G4int>& GetNcomp(){return fNcomp;};
+    std::vector<G4int>& GetNphot(){return fNphot;};  // dense layout only
+    std::vector<G4int>& GetNcomp(){return fNcomp;};  // dense layout only
+    std::vector<G4int>& GetDet(){return fDet;};  // sparse layout only
 
     void AnalyzeHits(const G4Event* event);
     void ResetVariables();
+    void ConfigureReadout();
+    void SetOutput(OutputBackend* output) { fOutput = output; }
+    void SetSparseLayout(G4bool value) { fSparseLayout = value; }
+    G4bool IsSparseLayout() const { return fSparseLayout; }
+
+    // pipelined post-processing
+    void SetUsePipeline(G4bool value) { fUsePipeline = value; }
+    void SetPipelineBatchSize(G4int value) { fPipelineBatchSize = value; }
+    void StartPipeline();
+    void StopPipeline();
+
+    // event trigger
+    void SetTriggerWindow(const G4String& volumeName, G4double minEnergy, G4double maxEnergy) {
+      fTrigger.SetWindow(volumeName, minEnergy, maxEnergy);
+    }
+    void SetTriggerCoincidence(G4int value) { fTrigger.SetCoincidence(value); }
+    void SetTriggerPrescale(G4int value) { fTrigger.SetPrescale(value); }
+    void PrintTriggerSummary() const { fTrigger.PrintSummary(); }
 
     void SetSpatialThreshold(G4double value) { fSpatialThreshold = value; }
     void SetTimeThreshold(G4double value) { fTimeThreshold = value; }
-    void AddHitsCollectionName(const G4String& name);
-
-    G4double GetSpatialThreshold(const G4String& collectionName);
-    G4double GetTimeThreshold(const G4String& collectionName);
-    static void SetClusteringParameters(const std::map<G4String, std::pair<G4double, G4double>>& params);
 
 
   private:
@@ -92,18 +142,30 @@ class EventAction : public G4UserEventAction
     // functions for hit clustering
     //
     void ClusterHits(std::vector<G4Sim::Hit*>& hits, G4double spatialThreshold, G4double timeThreshold, std::vector<Cluster>& clusters, int collectionID);
-
-    G4double CalculateDistance(const G4ThreeVector& pos1, const G4ThreeVector& pos2);
-    G4double CalculateTimeDifference(G4double time1, G4double time2);
+    void ClusterHits(const HitStore& hits, G4double spatialThreshold, G4double timeThreshold, std::vector<Cluster>& clusters, int collectionID);
+    void ClusterDeposits(size_t nDeposits, const G4double* x, const G4double* y, const G4double* z,
+                         const G4double* time, const G4double* energyDeposit, const G4int* processID,
+                         const G4double* weight, G4double spatialThreshold, G4double timeThreshold,
+                         std::vector<Cluster>& clusters, int collectionID);
+    void ClearOutput();
+    void WriteRow(G4int eventID, G4double logWeight, G4int eventType, G4double xp, G4double yp, G4double zp, G4int trigger);
+    EventTrigger::Decision ApplyTrigger();
+    void FillRecord(const G4Event* event, EventRecord& record);
+    void ProcessRecord(const EventRecord& record);
+
+    HitClusterer fClusterer;
+    std::vector<Cluster> fClusters;  // clusters of the current collection, keeps its capacity between events
 
     // define here all the variables that you want to store for each event in the 
     // ntuple tree  
-    G4double fLogWeight;
+    G4double fLogWeight;         // primary weight and prescale
+    G4double fLogTriggerWeight;  // prescale only, the track weights already contain the primary weight
     G4int fEventID;
     G4int fEventType;
     G4double fXp;
     G4double fYp;
     G4double fZp;
+    G4int fTriggered;  // 1 if the event passed the trigger, 0 if it was kept by the prescale
 
     std::vector<G4double> fE;
     std::vector<G4double> fX;
@@ -116,12 +178,52 @@ class EventAction : public G4UserEventAction
     std::vector<G4int> fNdet;
     std::vector<G4int> fNphot;
     std::vector<G4int> fNcomp;
+    std::vector<G4int> fDet;      // detector index of the per detector entries, sparse layout only
 
-    //static std::mutex mtx; // Mutex for thread safety
-    std::vector<G4String> fHitsCollectionNames;
+    G4bool fSparseLayout = false;
+
+    const DetectorConstruction* fDetector = nullptr;
+    OutputBackend* fOutput = nullptr;  // owned by the RunAction of this thread
     G4int verbosityLevel=0;
-        
-    static std::map<G4String, std::pair<G4double, G4double>> fClusteringParameters;
+
+    /**
+     * @brief How the hits of one active volume are read out at the end of an event.
+     */
+    enum ReadoutMode {
+        kHitsCollection, /**< Hit objects in a hits collection of the event. */
+        kHitStore,       /**< Arrays of the HitStore of the sensitive detector. */
+        kStreaming,      /**< Clusters made by the sensitive detector while tracking. */
+        kNoReadout       /**< Not available on this thread, e.g. on the master of a multithreaded run. */
+    };
+
+    /**
+     * @brief One entry of the readout plan, resolved once per run.
+     */
+    struct ReadoutEntry {
+        G4String collectionName;    /**< Name of the hits collection, only used for printing. */
+        ReadoutMode mode;           /**< Where the hits or clusters are taken from. */
+        G4int hcID;                 /**< Hits collection ID, for kHitsCollection. */
+        const SensitiveDetector* sensitiveDetector; /**< The detector, for kHitStore and kStreaming. */
+        G4double spatialThreshold;  /**< Spatial threshold for clustering. */
+        G4double timeThreshold;     /**< Time threshold for clustering. */
+        G4int detectorIndex;        /**< Index of the active volume, stored as the cluster ID. */
+        size_t outputSlot;          /**< Index in the per detector output vectors. */
+    };
+    std::vector<ReadoutEntry> fReadoutPlan;
+
+    EventTrigger fTrigger;
+    std::vector<G4double> fTriggerEnergies;  // raw energy per entry of the readout plan
+
+    void FillClusters(const std::vector<Cluster>& clusters, const ReadoutEntry& entry, G4double logTriggerWeight);
+
+    G4bool fUsePipeline = false;
+    G4int fPipelineBatchSize = 256;
+    EventPipeline* fPipeline = nullptr;
+
+    PhaseTimers* fTimers = nullptr;           // timers of the tracking thread
+    PhaseTimers* fConsumerTimers = nullptr;   // timers of the consumer thread, the same in every run
+
+    RunSummary* fSummary = nullptr;           // owned by the RunSummary registry
 
 
   protected:
@@ -5,6 +5,8 @@
 #include "G4UIcmdWithADoubleAndUnit.hh"
 #include "G4UIcmdWithAnInteger.hh"
 #include "G4UIcmdWithABool.hh"
+#include "G4UIcommand.hh"
+#include "G4UIdirectory.hh"
 #include "EventAction.hh"
 
 /**
@@ -32,6 +34,13 @@ private:
 
     G4UIcmdWithADoubleAndUnit* fSpatialThresholdCmd;
     G4UIcmdWithADoubleAndUnit* fTimeThresholdCmd;
+    G4UIcmdWithABool* fPipelineCmd;
+    G4UIcmdWithAnInteger* fPipelineBatchSizeCmd;
+
+    G4UIdirectory* fTriggerDirectory;
+    G4UIcommand* fTriggerWindowCmd;
+    G4UIcmdWithAnInteger* fTriggerCoincidenceCmd;
+    G4UIcmdWithAnInteger* fTriggerPrescaleCmd;
 
 };
 
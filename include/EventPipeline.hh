@@ -0,0 +1,64 @@
+#ifndef EVENT_PIPELINE_HH
+#define EVENT_PIPELINE_HH
+
+#include "EventRecord.hh"
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @namespace G4Sim
+ * @brief Namespace for the G4Sim library.
+/*/
+namespace G4Sim {
+
+/**
+ * @class EventPipeline
+ * @brief Bounded producer/consumer stage that processes event records on a dedicated thread.
+ *
+ * The tracking thread fills EventRecords in one of two batches. When a batch is full it is handed to the consumer
+ * thread, which calls the consumer function for every record, and the tracking thread continues with the other
+ * batch. If that batch is full as well before the consumer is done, the tracking thread waits, so at most two
+ * batches of events are in memory. The records of both batches are reused for the whole run.
+ *
+ * Usage per run: Start(), then per event NextRecord() and Commit(), and Stop() at the end of the run. Stop()
+ * processes all remaining records before it returns.
+ */
+class EventPipeline {
+public:
+    using Consumer = std::function<void(const EventRecord&)>;
+
+    EventPipeline(size_t batchSize, Consumer consumer);
+    ~EventPipeline();
+
+    void Start();
+    EventRecord& NextRecord();
+    void Commit();
+    void Stop();
+
+    G4bool IsRunning() const { return fThread.joinable(); }
+
+private:
+    void HandOver();
+    void Run();
+
+    size_t fBatchSize;
+    Consumer fConsumer;
+
+    std::vector<EventRecord> fBatches[2];
+    size_t fBatchFill[2] = {0, 0};
+    G4int fProducerBatch = 0;
+
+    std::mutex fMutex;
+    std::condition_variable fCondition;
+    G4int fPendingBatch = -1;  // batch handed over and not yet processed, -1 if the consumer is idle
+    G4bool fStopRequested = false;
+    std::thread fThread;
+};
+
+} // namespace G4Sim
+
+#endif
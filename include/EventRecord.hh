@@ -0,0 +1,76 @@
+#ifndef EVENT_RECORD_HH
+#define EVENT_RECORD_HH
+
+#include "G4Types.hh"
+#include "Cluster.hh"
+
+#include <vector>
+
+/**
+ * @namespace G4Sim
+ * @brief Namespace for the G4Sim library.
+/*/
+namespace G4Sim {
+
+/**
+ * @struct EventRecord
+ * @brief Compact copy of an event, handed from the tracking thread to the EventPipeline.
+ *
+ * The record holds the event level variables and, per entry of the readout plan of the EventAction, the deposits
+ * that are needed for clustering. Detectors in streaming clustering mode contribute their clusters instead. The
+ * deposits of entry i are the elements [depositBegin[i], depositBegin[i+1]) of the deposit arrays.
+ *
+ * Records are reused: Clear() keeps the capacity of all vectors.
+ */
+struct EventRecord {
+    G4int eventID = 0;
+    G4double logWeight = 0.;
+    G4double logTriggerWeight = 0.;
+    G4int eventType = 0;
+    G4double xp = 0.;
+    G4double yp = 0.;
+    G4double zp = 0.;
+    G4int trigger = 1;
+
+    std::vector<size_t> depositBegin;
+    std::vector<G4double> x;
+    std::vector<G4double> y;
+    std::vector<G4double> z;
+    std::vector<G4double> time;
+    std::vector<G4double> energyDeposit;
+    std::vector<G4int> processID;
+    std::vector<G4double> weight;
+
+    std::vector<std::vector<Cluster>> clusters;
+
+    void Clear(size_t nEntries) {
+        depositBegin.assign(1, 0);
+        x.clear();
+        y.clear();
+        z.clear();
+        time.clear();
+        energyDeposit.clear();
+        processID.clear();
+        weight.clear();
+        clusters.resize(nEntries);
+        for (auto& entryClusters : clusters) entryClusters.clear();
+    }
+
+    void AddDeposit(G4double xDeposit, G4double yDeposit, G4double zDeposit, G4double timeDeposit,
+                    G4double energy, G4int process, G4double trackWeight) {
+        x.push_back(xDeposit);
+        y.push_back(yDeposit);
+        z.push_back(zDeposit);
+        time.push_back(timeDeposit);
+        energyDeposit.push_back(energy);
+        processID.push_back(process);
+        weight.push_back(trackWeight);
+    }
+
+    // closes the deposits of the current entry
+    void EndEntry() { depositBegin.push_back(x.size()); }
+};
+
+} // namespace G4Sim
+
+#endif
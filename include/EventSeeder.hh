@@ -0,0 +1,49 @@
+#ifndef EVENT_SEEDER_HH
+#define EVENT_SEEDER_HH
+
+#include "G4Types.hh"
+
+#include <cstdint>
+
+/**
+ * @namespace G4Sim
+ * @brief Namespace for the G4Sim library.
+/*/
+namespace G4Sim {
+
+/**
+ * @class EventSeeder
+ * @brief Seeds the random engine of every event from the run seed and the global event number.
+ *
+ * The global event number of an event is the event offset of the job (/run/eventOffset) plus its event ID. With a
+ * run seed (/run/eventSeed) the engine of the thread that processes an event is seeded at the start of the event
+ * with MakeSeeds(runSeed, eventNumber), a counter-based hash that needs no state from earlier events. An event
+ * therefore gets the same random numbers however a campaign is split into jobs and threads, and a single event can
+ * be simulated again with its event number as offset and /run/beamOn 1.
+ *
+ * The settings are shared by all threads. They are only set by the master, before the run starts.
+ */
+class EventSeeder {
+public:
+    static EventSeeder* Instance();
+
+    void SetRunSeed(G4long value) { fRunSeed = value; }
+    void SetEventOffset(G4int value) { fEventOffset = value; }
+
+    G4bool IsEnabled() const { return fRunSeed > 0; }
+    G4int GetEventNumber(G4int eventID) const { return fEventOffset + eventID; }
+
+    void SeedEvent(G4int eventID) const;
+
+    static void MakeSeeds(std::uint64_t runSeed, std::uint64_t eventNumber, long seeds[2]);
+
+private:
+    EventSeeder() = default;
+
+    G4long fRunSeed = 0;    // 0: the engine is not seeded per event
+    G4int fEventOffset = 0;
+};
+
+} // namespace G4Sim
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef EVENT_TRIGGER_HH
+#define EVENT_TRIGGER_HH
+
+#include "G4String.hh"
+#include "G4Types.hh"
+#include "SensitiveVolume.hh"
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+/**
+ * @namespace G4Sim
+ * @brief Namespace for the G4Sim library.
+/*/
+namespace G4Sim {
+
+/**
+ * @class EventTrigger
+ * @brief Decides per event, from the energy per active volume, whether the event is written.
+ *
+ * Every active volume has an energy window. A volume fires when it has an energy deposit inside its window; by
+ * default the window is open, so any deposit fires. Windows are declared per volume in the geometry JSON file
+ * ("trigger": {"minEnergy": ..., "maxEnergy": ...} in keV) and can be overridden with /event/trigger/window. An
+ * event is accepted when at least the coincidence number of volumes fire.
+ *
+ * The trigger is active when a window is set or the coincidence is above one; otherwise every event is accepted.
+ * With a prescale of N, one in every N rejected events is kept anyway and its weight is multiplied by N.
+ *
+ * The energies are the raw deposit sums of the sensitive detectors. Clustering does not change the energy per
+ * volume, so the decision is made before clustering and rejected events are never clustered.
+ *
+ * Every EventAction owns a trigger, so the counters are per thread.
+ */
+class EventTrigger {
+public:
+    enum Decision {
+        kAccept,    /**< The trigger condition is met, or the trigger is not active. */
+        kPrescaled, /**< Rejected, but kept by the prescale. */
+        kReject     /**< Rejected, the event is not written. */
+    };
+
+    EventTrigger() = default;
+    ~EventTrigger() = default;
+
+    void SetWindow(const G4String& volumeName, G4double minEnergy, G4double maxEnergy);
+    void SetCoincidence(G4int value) { fCoincidence = value; }
+    void SetPrescale(G4int value) { fPrescale = value; }
+
+    void Configure(const std::vector<SensitiveVolume>& sensitiveVolumes);
+    Decision Evaluate(const std::vector<G4double>& energies);
+
+    G4bool IsActive() const { return fActive; }
+    G4int GetPrescale() const { return fPrescale; }
+    void PrintSummary() const;
+
+private:
+    struct Window {
+        G4double minEnergy = 0.;
+        G4double maxEnergy = 0.;  // no upper limit if <= 0
+    };
+
+    std::map<G4String, Window> fOverrides;  // windows set with the messenger, by volume name
+    std::vector<Window> fWindows;           // window per entry of the readout plan
+    G4bool fActive = false;
+    G4int fCoincidence = 1;
+    G4int fPrescale = 0;                    // 0: rejected events are dropped
+
+    std::uint64_t fNAccepted = 0;
+    std::uint64_t fNPrescaled = 0;
+    std::uint64_t fNRejected = 0;
+};
+
+} // namespace G4Sim
+
+#endif
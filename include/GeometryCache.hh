@@ -0,0 +1,56 @@
+#ifndef GEOMETRY_CACHE_HH
+#define GEOMETRY_CACHE_HH
+
+#include "G4String.hh"
+#include "G4Types.hh"
+
+#include "nlohmann/json.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class G4VPhysicalVolume;
+
+/**
+ * @namespace G4Sim
+ * @brief Namespace for the G4Sim library.
+/*/
+namespace G4Sim {
+
+/**
+ * @class GeometryCache
+ * @brief Stores the constructed geometry in a cache directory, and loads it in later jobs.
+ *
+ * An entry is a GDML file with the volume tree and its materials, plus a JSON sidecar with what GDML does not
+ * hold: the active volumes with their clustering and trigger settings, the termination policies and the
+ * importances. Both are named after a key, the 64-bit FNV-1a hash of the geometry and material files and of the
+ * settings that change the constructed geometry, so an edited file gives a new entry. Entries are written to a
+ * temporary file and renamed, so jobs that share a cache directory never read a partial entry.
+ *
+ * A geometry loaded from the cache is not checked for overlaps again, it was checked when the entry was made.
+ * The cache needs Geant4 with GDML support (G4XAMSSIM_USE_GDML); without it IsAvailable() returns false.
+ */
+class GeometryCache {
+public:
+    GeometryCache(const G4String& directory, std::uint64_t key);
+    ~GeometryCache() = default;
+
+    static G4bool IsAvailable();
+    static std::uint64_t Hash(const std::vector<std::string>& fileNames, const std::string& settings);
+
+    G4bool Contains() const;
+    G4VPhysicalVolume* Load(nlohmann::json& metadata) const;
+    void Store(G4VPhysicalVolume* world, const nlohmann::json& metadata) const;
+
+    const G4String& GetGdmlFileName() const { return fGdmlFileName; }
+
+private:
+    G4String fDirectory;
+    G4String fGdmlFileName;
+    G4String fMetadataFileName;
+};
+
+} // namespace G4Sim
+
+#endif
@@ -18,6 +18,10 @@ namespace G4Sim {
  * 
  * It inherits from the G4VHit class and contains properties such as energy deposit, position, time, track ID, parent ID,
  * momentum, particle type, and process type.
+ *
+ * All properties are plain numbers, so creating or copying a hit never allocates. The particle is identified by its
+ * PDG encoding and the process by its Geant4 sub type (e.g. fComptonScattering from G4EmProcessSubType). The names
+ * are only looked up when they are printed, with GetParticleName() and GetProcessName().
  */
 class Hit : public G4VHit {
 public:
@@ -38,10 +42,11 @@ public:
     G4int trackID; /**< Track ID of the hit. */
     G4int parentID; /**< Parent ID of the hit. */
     G4ThreeVector momentum; /**< Momentum of the hit. */
-    G4String particleType; /**< Particle type of the hit. */
-    G4String processType; /**< Process type of the hit. */
+    G4int particleID; /**< PDG encoding of the particle of the hit. */
+    G4int processID; /**< Sub type of the process that limited the step (G4EmProcessSubType for EM processes). */
     G4double particleEnergy0; /**< Energy of the particle at the beginning of a step */
     G4double particleEnergy1; /**< Energy of the particle after the step */
+    G4double weight; /**< Weight of the track, changed by importance biasing. */
     G4bool used; /**< Flag to indicate if the hit has been used in a cluster. */
 
     
@@ -50,6 +55,16 @@ public:
      */
     void Print() const;
 
+    /**
+     * @brief Name of the particle with the given PDG encoding.
+     */
+    static G4String GetParticleName(G4int particleID);
+
+    /**
+     * @brief Name of the process with the given sub type in the process list of the given particle.
+     */
+    static G4String GetProcessName(G4int particleID, G4int processID);
+
     // Operators
     inline void* operator new(size_t);
     inline void operator delete(void* hit);
@@ -0,0 +1,93 @@
+#ifndef HIT_CLUSTERER_HH
+#define HIT_CLUSTERER_HH
+
+#include "G4ThreeVector.hh"
+#include "G4Types.hh"
+#include "Cluster.hh"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * @namespace G4Sim
+ * @brief Namespace for the G4Sim library.
+/*/
+namespace G4Sim {
+
+/**
+ * @class HitClusterer
+ * @brief Clustering engine that groups energy deposits within a spatial and a time threshold.
+ *
+ * The engine reproduces the clustering of EventAction hit by hit, but finds the candidate clusters with a uniform
+ * grid instead of comparing against every cluster. The grid cells have the size of the spatial threshold, so all
+ * clusters closer than the threshold are in the 27 cells around a position. Clusters are kept in the grid at their
+ * current (moving) position, and among the candidates that pass the distance and time cuts the one with the lowest
+ * index is taken. This is exactly the cluster the sequential loops would have picked, so the output is identical.
+ *
+ * Usage per collection and event:
+ * 1. Reset() with the thresholds of the collection.
+ * 2. AddSeed() for deposits that always start a cluster (Compton and photo-electric interactions).
+ * 3. AddHit() for all other deposits, in their original order.
+ * 4. MergeClusters() to combine clusters that ended up close together.
+ * 5. GetClusters() to append the result.
+ *
+ * ClusterDeposits() runs steps 1 to 4 for deposits given as arrays, as done by the EventAction.
+ *
+ * Every deposit can carry the weight of its track (importance biasing). The weight of a cluster is the energy
+ * weighted mean of the weights of its deposits; it does not influence the clustering itself.
+ *
+ * All buffers keep their capacity between events, so a warmed-up engine does not allocate.
+ */
+class HitClusterer {
+public:
+    HitClusterer() = default;
+    ~HitClusterer() = default;
+
+    void Reset(G4double spatialThreshold, G4double timeThreshold);
+    void AddSeed(const G4ThreeVector& position, G4double energyDeposit, G4double time, G4double weight = 1.);
+    void AddHit(const G4ThreeVector& position, G4double energyDeposit, G4double time, G4double weight = 1.);
+    void MergeClusters();
+    void ClusterDeposits(size_t nDeposits, const G4double* x, const G4double* y, const G4double* z,
+                         const G4double* time, const G4double* energyDeposit, const G4int* processID,
+                         G4double spatialThreshold, G4double timeThreshold, const G4double* weight = nullptr);
+    void GetClusters(std::vector<Cluster>& clusters, G4int collectionID) const;
+
+    G4int GetNumberOfClusters() const { return fNumberOfClusters; }
+
+private:
+    using CellKey = std::uint64_t;
+
+    G4int NewCluster(const G4ThreeVector& position, G4double energyDeposit, G4double time, G4double weight);
+    static G4double MeanWeight(G4double energy1, G4double weight1, G4double energy2, G4double weight2);
+    G4int FindCluster(const G4ThreeVector& position, G4double time, G4int after) const;
+    G4bool IsClose(const Cluster& cluster, const G4ThreeVector& position, G4double time) const;
+
+    // grid bookkeeping
+    void CellIndices(const G4ThreeVector& position, std::int64_t& ix, std::int64_t& iy, std::int64_t& iz) const;
+    static CellKey MakeKey(std::int64_t ix, std::int64_t iy, std::int64_t iz);
+    size_t FindSlot(CellKey key) const;
+    G4int& CellHead(CellKey key);
+    G4int LookupCellHead(CellKey key) const;
+    void InsertInGrid(G4int index);
+    void RemoveFromGrid(G4int index);
+    void GrowTable();
+
+    G4double fSpatialThreshold = 0.;
+    G4double fTimeThreshold = 0.;
+    G4bool fUseGrid = false;
+
+    std::vector<Cluster> fClusters;
+    std::vector<char> fAlive;
+    std::vector<CellKey> fClusterCell;
+    std::vector<G4int> fNextInCell;
+    G4int fNumberOfClusters = 0;
+
+    // open addressing hash table: cell key -> first cluster in the cell
+    std::vector<CellKey> fTableKeys;
+    std::vector<G4int> fTableHeads;
+    size_t fTableUsed = 0;
+};
+
+} // namespace G4Sim
+
+#endif
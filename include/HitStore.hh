@@ -0,0 +1,76 @@
+#ifndef HIT_STORE_HH
+#define HIT_STORE_HH
+
+#include "G4ThreeVector.hh"
+#include "G4Types.hh"
+
+#include <vector>
+
+/**
+ * @namespace G4Sim
+ * @brief Namespace for the G4Sim library.
+/*/
+namespace G4Sim {
+
+/**
+ * @class HitStore
+ * @brief Structure-of-arrays container for the hits of one sensitive detector.
+ *
+ * The HitStore holds the same information as a Hit, but every property is stored in its own contiguous array.
+ * All arrays are slices of two arena buffers (one for floating point and one for integer properties) that are
+ * owned by the store. Clear() only resets the number of hits, so after the first few events the buffers have
+ * reached their working size and filling the store does not allocate anymore.
+ *
+ * The arrays are accessed by index, e.g. GetX()[i] is the x coordinate of hit i.
+ */
+class HitStore {
+public:
+    HitStore();
+    ~HitStore() = default;
+
+    void Clear() { fSize = 0; }
+    void Add(G4double energyDeposit, const G4ThreeVector& position, G4double time, G4int trackID, G4int parentID,
+             const G4ThreeVector& momentum, G4int particleID, G4int processID,
+             G4double particleEnergy0, G4double particleEnergy1, G4double weight = 1.);
+
+    size_t GetSize() const { return fSize; }
+    G4bool IsEmpty() const { return fSize == 0; }
+    G4ThreeVector GetPosition(size_t i) const { return G4ThreeVector(GetX()[i], GetY()[i], GetZ()[i]); }
+
+    // per property arrays
+    const G4double* GetEnergyDeposit() const { return DoubleField(kEnergyDeposit); }
+    const G4double* GetX() const { return DoubleField(kX); }
+    const G4double* GetY() const { return DoubleField(kY); }
+    const G4double* GetZ() const { return DoubleField(kZ); }
+    const G4double* GetTime() const { return DoubleField(kTime); }
+    const G4double* GetPx() const { return DoubleField(kPx); }
+    const G4double* GetPy() const { return DoubleField(kPy); }
+    const G4double* GetPz() const { return DoubleField(kPz); }
+    const G4double* GetParticleEnergy0() const { return DoubleField(kParticleEnergy0); }
+    const G4double* GetParticleEnergy1() const { return DoubleField(kParticleEnergy1); }
+    const G4double* GetWeight() const { return DoubleField(kWeight); }
+    const G4int* GetTrackID() const { return IntField(kTrackID); }
+    const G4int* GetParentID() const { return IntField(kParentID); }
+    const G4int* GetParticleID() const { return IntField(kParticleID); }
+    const G4int* GetProcessID() const { return IntField(kProcessID); }
+
+private:
+    enum DoubleFields { kEnergyDeposit, kX, kY, kZ, kTime, kPx, kPy, kPz, kParticleEnergy0, kParticleEnergy1, kWeight, kNDoubleFields };
+    enum IntFields { kTrackID, kParentID, kParticleID, kProcessID, kNIntFields };
+
+    const G4double* DoubleField(G4int field) const { return fDoubleArena.data() + field * fCapacity; }
+    const G4int* IntField(G4int field) const { return fIntArena.data() + field * fCapacity; }
+    G4double* DoubleField(G4int field) { return fDoubleArena.data() + field * fCapacity; }
+    G4int* IntField(G4int field) { return fIntArena.data() + field * fCapacity; }
+
+    void Grow();
+
+    size_t fSize = 0;
+    size_t fCapacity = 0;
+    std::vector<G4double> fDoubleArena;
+    std::vector<G4int> fIntArena;
+};
+
+} // namespace G4Sim
+
+#endif
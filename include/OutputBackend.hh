@@ -0,0 +1,48 @@
+#ifndef OUTPUT_BACKEND_HH
+#define OUTPUT_BACKEND_HH
+
+#include "G4String.hh"
+#include "G4Types.hh"
+
+#include <vector>
+
+/**
+ * @namespace G4Sim
+ * @brief Namespace for the G4Sim library.
+/*/
+namespace G4Sim {
+
+/**
+ * @class OutputBackend
+ * @brief Interface for writing the event ntuple.
+ *
+ * The interface follows the calls that RunAction and EventAction made on the G4AnalysisManager: a file is opened,
+ * an ntuple is defined column by column, and a row is added per event. Scalar columns are filled by index, in the
+ * order in which they were created. Jagged columns are bound to a vector that is read when the row is added.
+ *
+ * Every thread owns its own backend, so implementations do not need to be thread safe.
+ */
+class OutputBackend {
+public:
+    virtual ~OutputBackend() = default;
+
+    virtual void OpenFile(const G4String& fileName) = 0;
+    virtual void CreateNtuple(const G4String& name, const G4String& title) = 0;
+    virtual G4int CreateDColumn(const G4String& name) = 0;
+    virtual G4int CreateDColumn(const G4String& name, std::vector<G4double>& values) = 0;
+    virtual G4int CreateIColumn(const G4String& name, std::vector<G4int>& values) = 0;
+    virtual void FinishNtuple() = 0;
+
+    virtual void FillDColumn(G4int column, G4double value) = 0;
+    virtual void AddRow() = 0;
+
+    virtual void Write() = 0;
+    virtual void CloseFile() = 0;
+
+    // true if rows can only be added on the thread that opened the file
+    virtual G4bool IsThreadLocal() const = 0;
+};
+
+} // namespace G4Sim
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef PHASE_SPACE_HH
+#define PHASE_SPACE_HH
+
+#include "G4String.hh"
+#include "G4Types.hh"
+#include "G4AutoLock.hh"
+
+#include <cstdint>
+#include <fstream>
+#include <vector>
+
+/**
+ * @namespace G4Sim
+ * @brief Namespace for the G4Sim library.
+/*/
+namespace G4Sim {
+
+/**
+ * @struct PhaseSpaceRecord
+ * @brief A particle crossing the phase space surface, as stored in a phase space file.
+ *
+ * Records are written as they are in memory (little endian, 80 bytes; both are checked at compile time) after a
+ * 16 byte header with the magic "XAMSPS01" and the record size. Positions are in mm, energies in MeV and times in ns.
+ */
+struct PhaseSpaceRecord {
+    std::int32_t eventID;       /**< ID of the event in which the particle crossed the surface. */
+    std::int32_t pdgCode;       /**< PDG code of the particle. */
+    G4double x, y, z;           /**< Position on the surface. */
+    G4double dx, dy, dz;        /**< Momentum direction. */
+    G4double kineticEnergy;     /**< Kinetic energy. */
+    G4double time;              /**< Global time. */
+    G4double weight;            /**< Track weight. */
+};
+
+// the readers (PhaseSpaceReader, analysis) rely on this layout
+static_assert(sizeof(PhaseSpaceRecord) == 80, "PhaseSpaceRecord must be 80 bytes without padding");
+
+/**
+ * @class PhaseSpaceWriter
+ * @brief Writes the particles that cross the phase space surface to a binary file.
+ *
+ * Every thread writes its own file (name_t<thread>.xps, like the columnar output). Records are buffered and written
+ * in blocks; the file is complete once the writer is closed or destroyed.
+ */
+class PhaseSpaceWriter {
+public:
+    explicit PhaseSpaceWriter(const G4String& fileName);
+    ~PhaseSpaceWriter();
+
+    void Write(const PhaseSpaceRecord& record);
+    void Close();
+
+    const G4String& GetFileName() const { return fFileName; }
+    std::uint64_t GetNRecords() const { return fNRecords; }
+
+    static G4String MakeFileName(const G4String& fileName);
+
+private:
+    void Flush();
+
+    G4String fFileName;
+    std::ofstream fFile;
+    std::vector<PhaseSpaceRecord> fBuffer;
+    std::uint64_t fNRecords = 0;
+};
+
+/**
+ * @class PhaseSpaceReader
+ * @brief Hands out the recorded events of one or more phase space files, shared by all threads.
+ *
+ * The consecutive records with the same event ID form one replayed event, so that particles from the same primary
+ * (e.g. the two photons of a Co-60 decay) stay together. With a reuse factor of N every recorded event is handed out N
+ * times, and the weights are divided by N. The threads take events in turn under a lock, so every recorded event is
+ * used exactly N times per pass through the files, whatever the number of threads.
+ */
+class PhaseSpaceReader {
+public:
+    static PhaseSpaceReader* Instance();
+
+    void Open(const std::vector<G4String>& fileNames, G4int reuse);
+    G4bool IsOpen() const { return !fFileNames.empty(); }
+    G4bool NextEvent(std::vector<PhaseSpaceRecord>& records);
+
+private:
+    PhaseSpaceReader() = default;
+
+    G4bool OpenFile(size_t index);
+    G4bool ReadRecord(PhaseSpaceRecord& record);
+
+    G4Mutex fMutex = G4MUTEX_INITIALIZER;
+    std::vector<G4String> fFileNames;
+    G4int fReuse = 1;
+
+    size_t fFileIndex = 0;
+    std::ifstream fFile;
+    G4bool fHasNext = false;              // fNext holds the first record of the next event
+    PhaseSpaceRecord fNext{};
+    std::vector<PhaseSpaceRecord> fEvent; // the event being reused
+    G4int fNUses = 0;                     // times fEvent has been handed out
+};
+
+} // namespace G4Sim
+
+#endif
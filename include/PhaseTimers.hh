@@ -0,0 +1,127 @@
+#ifndef PHASE_TIMERS_HH
+#define PHASE_TIMERS_HH
+
+#include "G4String.hh"
+#include "G4Types.hh"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/**
+ * @namespace G4Sim
+ * @brief Namespace for the G4Sim library.
+/*/
+namespace G4Sim {
+
+/**
+ * @class PhaseTimers
+ * @brief Wall time spent per phase of the simulation, per thread.
+ *
+ * Every thread that runs instrumented code has its own PhaseTimers (see Instance()), so timing needs no locks.
+ * Threads that are started anew in every run, like the consumer thread of the event pipeline, use timers from
+ * Create() that are kept by their owner instead, so that the registry does not grow from run to run.
+ * The phases are:
+ * - construct, materials and initialization: geometry construction, material definition, and the time in the
+ *   G4State_Init state (geometry, physics list and physics tables). These are always timed and accumulate over
+ *   the whole program. The phases are nested: construct includes materials, and initialization
+ *   includes both.
+ * - event, transport, ProcessHits, clustering and output: timed per event when the timers are enabled
+ *   (/run/timingReport true), and reset at the start of every run. Transport is the event time that is not
+ *   spent in ProcessHits, clustering or output of the same thread.
+ *
+ * For the per event phases a histogram with logarithmic bins (8 per factor 2) is kept, from which percentiles are
+ * estimated. At the end of a run the master merges the timers of all threads into a JSON report (WriteReport()).
+ */
+class PhaseTimers {
+public:
+    enum Phase {
+        kConstruct,
+        kMaterials,
+        kInitialization,
+        kEvent,
+        kTransport,
+        kProcessHits,
+        kClustering,
+        kOutput,
+        kNPhases
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    static PhaseTimers* Instance();
+    static PhaseTimers* Create(const G4String& name);
+    static void SetEnabled(G4bool value) { fEnabled.store(value, std::memory_order_relaxed); }
+    static G4bool IsEnabled() { return fEnabled.load(std::memory_order_relaxed); }
+
+    static const char* GetPhaseName(Phase phase);
+    static void WatchInitialization();
+    static void ResetRun();
+    static void WriteReport(const G4String& fileName, G4int runID, G4int nEvents, G4double wallTime);
+
+    void SetName(const G4String& name) { fName = name; }
+
+    void Add(Phase phase, G4double nanoseconds);
+    void BeginEvent();
+    void EndEvent();
+
+private:
+    PhaseTimers();
+
+    static constexpr size_t kBinsPerOctave = 8;
+    static constexpr size_t kNBins = 48 * kBinsPerOctave;  // 1 ns to about 3 days
+
+    struct Statistics {
+        G4double total = 0.;        // ns
+        std::uint64_t calls = 0;
+        std::uint64_t samples = 0;  // events, for the per event phases
+        G4double maximum = 0.;
+        std::array<std::uint64_t, kNBins> histogram{};
+    };
+
+    void Sample(Phase phase, G4double nanoseconds);
+    void Reset();
+
+    static std::atomic<G4bool> fEnabled;
+
+    G4String fName;
+    std::array<Statistics, kNPhases> fStatistics;
+    std::array<G4double, kNPhases> fEventTime{};  // time per phase in the current event
+    std::array<G4bool, kNPhases> fEventTimed{};
+    G4bool fInEvent = false;
+    Clock::time_point fEventStart;
+};
+
+/**
+ * @class PhaseTimer
+ * @brief Adds the time between its construction and destruction to a phase of the PhaseTimers of this thread.
+ *
+ * Per event phases are only timed when the timers are enabled; otherwise the timer costs one flag check.
+ */
+class PhaseTimer {
+public:
+    PhaseTimer(PhaseTimers* timers, PhaseTimers::Phase phase)
+        : fTimers(timers), fPhase(phase),
+          fActive(timers && (phase <= PhaseTimers::kInitialization || PhaseTimers::IsEnabled())) {
+        if (fActive) fStart = PhaseTimers::Clock::now();
+    }
+    ~PhaseTimer() {
+        if (fActive) {
+            fTimers->Add(fPhase, std::chrono::duration<G4double, std::nano>(PhaseTimers::Clock::now() - fStart).count());
+        }
+    }
+
+    PhaseTimer(const PhaseTimer&) = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+private:
+    PhaseTimers* fTimers;
+    PhaseTimers::Phase fPhase;
+    G4bool fActive;
+    PhaseTimers::Clock::time_point fStart;
+};
+
+} // namespace G4Sim
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef PHYSICS_TABLE_CACHE_HH
+#define PHYSICS_TABLE_CACHE_HH
+
+#include "G4String.hh"
+#include "G4Types.hh"
+#include "G4VStateDependent.hh"
+
+#include <cstdint>
+
+/**
+ * @namespace G4Sim
+ * @brief Namespace for the G4Sim library.
+/*/
+namespace G4Sim {
+
+/**
+ * @class PhysicsTableCache
+ * @brief Stores the physics tables in a cache directory with the Geant4 table store, and retrieves them in later jobs.
+ *
+ * The tables are built at the start of the first run. Just before that (the transition from Idle to Init) the key of
+ * the tables is computed from the materials, the production cuts of all regions, the physics constructors of the
+ * physics list and the Geant4 version. If the cache has an entry with that key, the physics list retrieves its tables
+ * from there; otherwise the tables are stored once they are built (the transition to GeomClosed). Geant4 checks the
+ * retrieved cuts table against the current couples and builds the tables itself if they do not match.
+ *
+ * An entry is stored in a temporary directory that is renamed, so jobs that share a cache directory never see a
+ * partial entry; if two jobs store the same entry, the first rename wins.
+ *
+ * Only the master thread (or the single thread in sequential mode) has a cache, see /run/physicsTableCache.
+ */
+class PhysicsTableCache : public G4VStateDependent {
+public:
+    static PhysicsTableCache* Instance();
+
+    void SetDirectory(const G4String& directory) { fDirectory = directory; }
+
+    G4bool Notify(G4ApplicationState previousState, G4ApplicationState requestedState) override;
+
+private:
+    PhysicsTableCache() = default;
+
+    static std::uint64_t ComputeKey();
+    void Retrieve();
+    void Store();
+
+    G4String fDirectory;
+    G4String fEntryName;         // directory of the entry of this job
+    G4bool fDone = false;        // tables retrieved or stored, only once per job
+    G4bool fStorePending = false;
+};
+
+} // namespace G4Sim
+
+#endif
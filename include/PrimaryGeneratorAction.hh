@@ -34,14 +34,26 @@
 #include "G4GeneralParticleSource.hh"
 #include "globals.hh"
 
+#include <vector>
+
 class G4GeneralParticleSource;
 class G4Event;
 class G4Box;
 
+namespace G4Sim {
+class PrimaryGeneratorMessenger;
+struct PhaseSpaceRecord;
+}
+
 /// The primary generator action class with particle gun.
 ///
 /// The default kinematic is a 6 MeV gamma, randomly distribued
 /// in front of the phantom across 80% of the (X,Y) phantom size.
+///
+/// When phase space files are given with /phaseSpace/replay/addFile, the
+/// primaries are the recorded particles instead (see G4Sim::PhaseSpaceReader):
+/// every event replays the particles of one recorded event, each with its own
+/// vertex. The run stops when all recorded events have been replayed.
 
 ///namespace G4FastSim
 ///{
@@ -60,11 +72,21 @@ class PrimaryGeneratorAction : public G4VUserPrimaryGeneratorAction
     
     G4double GetInitialEnergy() const;
 
+    void AddPhaseSpaceFile(const G4String& fileName) { fPhaseSpaceFiles.push_back(fileName); }
+    void SetPhaseSpaceReuse(G4int value) { fPhaseSpaceReuse = value; }
+
 
   private:
     G4GeneralParticleSource* fParticleGun = nullptr; // pointer a to G4 gun class
     G4Box* fEnvelopeBox = nullptr;
     G4double fInitialEnergy = 0;
+
+    void GeneratePhaseSpacePrimaries(G4Event* anEvent);
+
+    G4Sim::PrimaryGeneratorMessenger* fMessenger = nullptr;
+    std::vector<G4String> fPhaseSpaceFiles;
+    G4int fPhaseSpaceReuse = 1;
+    std::vector<G4Sim::PhaseSpaceRecord> fPhaseSpaceEvent;
 };
 
 ///}
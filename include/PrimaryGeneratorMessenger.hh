@@ -0,0 +1,41 @@
+#ifndef PRIMARY_GENERATOR_MESSENGER_H
+#define PRIMARY_GENERATOR_MESSENGER_H 1
+
+#include "G4UImessenger.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIdirectory.hh"
+#include "globals.hh"
+
+class PrimaryGeneratorAction;
+
+/**
+ * @namespace G4Sim
+ * @brief Namespace for the G4Sim library.
+/*/
+namespace G4Sim {
+
+/**
+ * @class PrimaryGeneratorMessenger
+ * @brief A class responsible for handling user commands related to the primary generator.
+ *
+ * It provides the commands of the /phaseSpace/replay/ directory that replay recorded phase space files.
+ */
+class PrimaryGeneratorMessenger : public G4UImessenger {
+public:
+    PrimaryGeneratorMessenger(PrimaryGeneratorAction* primaryGenerator);
+    ~PrimaryGeneratorMessenger() override;
+
+    void SetNewValue(G4UIcommand* command, G4String newValue) override;
+
+private:
+    PrimaryGeneratorAction* fPrimaryGenerator;
+
+    G4UIdirectory* fReplayDirectory;
+    G4UIcmdWithAString* fAddFileCmd;
+    G4UIcmdWithAnInteger* fReuseCmd;
+};
+
+} // namespace G4Sim
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef PROCESS_POOL_HH
+#define PROCESS_POOL_HH
+
+#include "G4Types.hh"
+
+#include <functional>
+#include <vector>
+
+/**
+ * @namespace G4Sim
+ * @brief Namespace for the G4Sim library.
+/*/
+namespace G4Sim {
+
+/**
+ * @class ProcessPool
+ * @brief Runs tasks in forked child processes of an initialized master.
+ *
+ * The master builds the geometry and the physics tables once and then forks a child per task, with at most
+ * nProcesses children at a time. The children share the memory of the master copy-on-write, so the physics tables
+ * are in memory only once, while code that is not thread safe runs as in a serial job. A child that crashes or
+ * exits with a non-zero status is started again, up to maxRetries times.
+ *
+ * Forking is only safe while the process has a single thread, so the pool is used with the serial run manager.
+ */
+class ProcessPool {
+public:
+    /**
+     * @struct Result
+     * @brief The outcome of one task.
+     */
+    struct Result {
+        G4int attempts = 0;
+        G4int exitCode = -1;   /**< Exit status of the last attempt, -1 if it did not exit normally. */
+        G4int signal = 0;      /**< Signal that ended the last attempt, 0 if none. */
+        G4bool succeeded = false;
+    };
+
+    ProcessPool(G4int nProcesses, G4int maxRetries);
+    ~ProcessPool() = default;
+
+    G4bool Run(size_t nTasks, const std::function<G4int(size_t)>& task, G4int& childStatus);
+
+    const std::vector<Result>& GetResults() const { return fResults; }
+
+private:
+    G4int fNProcesses;
+    G4int fMaxRetries;
+    std::vector<Result> fResults;
+};
+
+} // namespace G4Sim
+
+#endif
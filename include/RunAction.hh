@@ -36,6 +36,9 @@
 #include "G4AnalysisManager.hh"
 #include "globals.hh"
 #include "RunActionMessenger.hh"
+#include "OutputBackend.hh"
+#include "PhaseTimers.hh"
+#include "PhysicsTableCache.hh"
 
 class G4Run;
 
@@ -50,6 +53,7 @@ namespace G4Sim
 
 class EventAction;
 class RunActionMessenger;
+class SteppingAction;
 
 /**
  * @class RunAction
@@ -57,6 +61,14 @@ class RunActionMessenger;
  *
  * This class inherits from G4UserRunAction and is responsible for defining the actions to be taken at the beginning and end of a run.
  * It also provides methods for initializing and defining event ntuples, as well as setting the output file name.
+ * The ntuple is written through an OutputBackend: a ROOT file via the G4AnalysisManager ("root"), or a native
+ * columnar file per thread ("columnar").
+ *
+ * With /run/timingReport the master writes the PhaseTimers of all threads to a JSON report next to the output
+ * file at the end of each run.
+ *
+ * /run/physicsTableCache stores the physics tables in a cache directory, or retrieves them from it (see
+ * PhysicsTableCache).
  *
  * @note The default output file name is "G4XamsSim.root".
  */
@@ -72,14 +84,28 @@ class RunAction : public G4UserRunAction
     void InitializeNtuples();
     void DefineEventNtuple();
     void SetOutputFileName(G4String value) { fOutputFileName = value; }
+    void SetOutputFormat(G4String value) { fOutputFormat = value; }
+    void SetOutputChunkSize(G4int value) { fOutputChunkSize = value; }
+    void SetOutputCompression(G4String value) { fOutputCompression = value; }
+    void SetEventLayout(G4String value) { fEventLayout = value; }
+    void SetSteppingAction(SteppingAction* steppingAction) { fSteppingAction = steppingAction; }
+    void SetTimingReport(G4bool value) { PhaseTimers::SetEnabled(value); }
+    void SetPhysicsTableCache(const G4String& directory) { PhysicsTableCache::Instance()->SetDirectory(directory); }
 
   private:
     EventAction* fEventAction = nullptr;
+    SteppingAction* fSteppingAction = nullptr;  // none on the master
     RunActionMessenger* fMessenger;
 
-    int eventNtupleId = -1;
-
     G4String fOutputFileName = "G4XamsSim.root";
+    G4String fOutputFormat = "root";
+    G4int fOutputChunkSize = 10000;
+    G4String fOutputCompression = "none";
+    G4String fEventLayout = "dense";
+    G4String fNtupleLayout;  // layout of the booked ROOT ntuple, empty before it is booked
+    OutputBackend* fOutput = nullptr;
+
+    PhaseTimers::Clock::time_point fRunStart;  // start of the event loop, on the master
 };
 
 } // namespace G4Sim
@@ -7,6 +7,8 @@
 #include "G4UIcmdWithAnInteger.hh"
 #include "G4UIcmdWithADoubleAndUnit.hh"
 #include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithoutParameter.hh"
+#include "G4UIdirectory.hh"
 #include "globals.hh"
 
 namespace G4Sim {
@@ -23,6 +25,18 @@ public:
 private:
     RunAction* fRunAction;
     G4UIcmdWithAString* fOutputFileNameCmd;
+    G4UIcmdWithAString* fOutputFormatCmd;
+    G4UIcmdWithAnInteger* fOutputChunkSizeCmd;
+    G4UIcmdWithAString* fOutputCompressionCmd;
+    G4UIcmdWithAString* fEventLayoutCmd;
+    G4UIcmdWithABool* fTimingReportCmd;
+    G4UIcmdWithAString* fPhysicsTableCacheCmd;
+    G4UIcmdWithAnInteger* fEventSeedCmd;
+    G4UIcmdWithAnInteger* fEventOffsetCmd;
+    G4UIdirectory* fSummaryDirectory;
+    G4UIcmdWithAString* fSummaryHistogramCmd;
+    G4UIcmdWithoutParameter* fSummaryClearCmd;
+    G4UIcmdWithABool* fSummaryWriteNtupleCmd;
 };
 
 } // namespace G4Sim
@@ -0,0 +1,117 @@
+#ifndef RUN_SUMMARY_HH
+#define RUN_SUMMARY_HH
+
+#include "G4String.hh"
+#include "G4Types.hh"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * @namespace G4Sim
+ * @brief Namespace for the G4Sim library.
+/*/
+namespace G4Sim {
+
+/**
+ * @class RunSummary
+ * @brief Weighted 1D, 2D and 3D histograms of the clustered events, accumulated during the run.
+ *
+ * Histograms are defined with /summary/histogram, e.g. "edet 200 0 2000" or "xh 50 -50 50 yh 50 -50 50". A
+ * definition is booked for every active collection. The quantities are the columns of the event ntuple, in the same
+ * units (keV, mm):
+ * - per detector: edet, ndet, nphot, ncomp; filled once per event for every collection with clusters, with the
+ *   event weight exp(w).
+ * - per cluster: eh, xh, yh, zh and rh (the radius); filled for every cluster with its weight exp(wh).
+ * - per event: xp, yp, zp; they can be combined with the others, or alone, in which case one histogram (collection
+ *   "event") is filled once per event.
+ *
+ * Every EventAction fills its own RunSummary (see Create()), on the thread that writes its events, so filling needs
+ * no locks. At the end of the run the master adds the histograms of all threads and writes them as a JSON file next
+ * to the output file (WriteReport()); analysis/SummaryReader.py reads it. With /summary/writeNtuple false the event
+ * ntuple is not written, so a spectrum-only run has no per event output at all.
+ *
+ * The definitions are shared by all threads. They are only changed by the master, between runs.
+ */
+class RunSummary {
+public:
+    /**
+     * @struct Event
+     * @brief The clustered event, as written to the ntuple by the EventAction.
+     *
+     * det is null in the dense layout, nphot and ncomp are null in the sparse layout (their values are zero).
+     */
+    struct Event {
+        G4double logWeight;
+        G4double xp, yp, zp;
+        const std::vector<G4double>* e;
+        const std::vector<G4double>* x;
+        const std::vector<G4double>* y;
+        const std::vector<G4double>* z;
+        const std::vector<G4double>* w;
+        const std::vector<G4int>* id;
+        const std::vector<G4int>* det;
+        const std::vector<G4double>* edet;
+        const std::vector<G4int>* ndet;
+        const std::vector<G4int>* nphot;
+        const std::vector<G4int>* ncomp;
+    };
+
+    static G4bool AddDefinition(const G4String& text);
+    static void ClearDefinitions();
+    static G4bool IsEnabled();
+    static void SetWriteNtuple(G4bool value) { fWriteNtuple = value; }
+    static G4bool GetWriteNtuple() { return fWriteNtuple; }
+
+    static RunSummary* Create();
+    static void ResetRun();
+    static void WriteReport(const G4String& fileName, G4int runID, G4int nEvents);
+
+    void Book(const std::vector<G4String>& collectionNames);
+    void Fill(const Event& event);
+
+private:
+    enum Quantity { kEdet, kNdet, kNphot, kNcomp, kEh, kXh, kYh, kZh, kRh, kXp, kYp, kZp };
+    enum Level { kEventLevel, kDetectorLevel, kClusterLevel };
+
+    struct Axis {
+        Quantity quantity;
+        G4int nBins;
+        G4double min;
+        G4double max;
+    };
+
+    struct Definition {
+        G4String text;
+        std::vector<Axis> axes;
+        Level level;
+    };
+
+    struct Histogram {
+        size_t definition;
+        G4String collection;
+        G4int slot;  // output slot of the collection, -1 for event level histograms
+        std::vector<G4double> sumWeights;
+        std::vector<G4double> sumWeights2;
+        G4double outside = 0.;  // weight of the entries outside the range
+        std::uint64_t entries = 0;
+    };
+
+    RunSummary() = default;
+
+    static G4double Value(Quantity quantity, const Event& event, size_t index);
+    void FillHistogram(Histogram& histogram, const Event& event, size_t index, G4double weight);
+
+    static std::vector<Definition> fDefinitions;
+    static G4bool fWriteNtuple;
+
+    G4String fBooking;  // the definitions and collections of the booked histograms
+    std::vector<Histogram> fHistograms;
+    std::vector<std::vector<size_t>> fDetectorHistograms;  // per output slot
+    std::vector<std::vector<size_t>> fClusterHistograms;   // per output slot
+    std::vector<size_t> fEventHistograms;
+};
+
+} // namespace G4Sim
+
+#endif
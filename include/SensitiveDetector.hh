@@ -4,6 +4,12 @@
 #include "G4VSensitiveDetector.hh"
 #include "G4THitsCollection.hh"
 #include "Hit.hh" // Include the Hit class
+#include "Cluster.hh"
+#include "HitClusterer.hh"
+#include "HitStore.hh"
+#include "PhaseTimers.hh"
+
+#include <vector>
 
 /**
  * @namespace G4Sim
@@ -19,6 +25,14 @@ namespace G4Sim {
  * The SensitiveDetector class is derived from the G4VSensitiveDetector class and is responsible for handling hits and energy deposits in the simulation.
  * It provides methods for initializing the detector, processing hits, and ending the event.
  * The class also includes a method to retrieve the total energy deposit.
+ *
+ * In streaming clustering mode no hits are stored. Each deposit is added to running clusters as the step happens,
+ * and at the end of the event only the merged clusters are available through GetClusters().
+ *
+ * In hit store mode the hits are not stored as Hit objects in a hits collection, but in a HitStore with one
+ * contiguous array per property. The store is cleared in Initialize and keeps its memory between events.
+ *
+ * The time spent in ProcessHits is added to the process_hits phase of the PhaseTimers of the tracking thread.
  * 
  * @note This class assumes the existence of a HitsCollection class and a Hit class.
  */
@@ -33,11 +47,32 @@ public:
 
     G4double GetTotalEnergyDeposit() const { return fTotalEnergyDeposit; }
 
+    // streaming clustering mode
+    void SetStreamingClustering(G4double spatialThreshold, G4double timeThreshold);
+    G4bool IsStreamingClustering() const { return fStreamingClustering; }
+    const std::vector<Cluster>& GetClusters() const { return fClusters; }
+
+    // hit store mode
+    void SetHitStore(G4bool value) { fUseHitStore = value; }
+    G4bool UsesHitStore() const { return fUseHitStore; }
+    const HitStore& GetHitStore() const { return fHitStore; }
+
 private:
     HitsCollection* fHitsCollection;
     //G4THitsCollection<Hit>* fHitsCollection;
-    G4double fTotalEnergyDeposit;
     G4int fHitsCollectionID;
+    G4double fTotalEnergyDeposit;
+
+    G4bool fStreamingClustering = false;
+    G4double fSpatialThreshold = 0.;
+    G4double fTimeThreshold = 0.;
+    HitClusterer fClusterer;
+    std::vector<Cluster> fClusters;
+
+    G4bool fUseHitStore = false;
+    HitStore fHitStore;
+
+    PhaseTimers* fTimers = nullptr;  // timers of the thread that owns the detector
 };
 
 } // namespace G4Sim
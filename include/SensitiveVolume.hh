@@ -0,0 +1,35 @@
+#ifndef SENSITIVE_VOLUME_HH
+#define SENSITIVE_VOLUME_HH
+
+#include "G4String.hh"
+#include "G4Types.hh"
+
+/**
+ * @namespace G4Sim
+ * @brief Namespace for the G4Sim library.
+/*/
+namespace G4Sim {
+
+/**
+ * @struct SensitiveVolume
+ * @brief Readout settings of an active volume as declared in the geometry JSON file.
+ *
+ * The DetectorConstruction fills one entry per active volume, in the order in which the volumes
+ * appear in the JSON file. The list is read-only once the geometry is built, so worker threads can
+ * use it to create their own sensitive detectors and to configure their own EventAction.
+ */
+struct SensitiveVolume {
+    G4String volumeName;       /**< Name of the logical volume. */
+    G4String collectionName;   /**< Name of the hits collection of the sensitive detector. */
+    G4double spatialThreshold; /**< Spatial threshold for clustering. */
+    G4double timeThreshold;    /**< Time threshold for clustering. */
+    G4bool streamingClustering; /**< Cluster deposits in the sensitive detector while tracking. */
+    G4bool hitStore;           /**< Store the hits in a HitStore instead of a hits collection. */
+    G4bool trigger;            /**< The volume declares a trigger energy window. */
+    G4double triggerMinEnergy; /**< Minimum energy of the trigger window. */
+    G4double triggerMaxEnergy; /**< Maximum energy of the trigger window, no upper limit if <= 0. */
+};
+
+} // namespace G4Sim
+
+#endif
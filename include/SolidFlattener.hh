@@ -0,0 +1,75 @@
+#ifndef SOLID_FLATTENER_HH
+#define SOLID_FLATTENER_HH
+
+#include "G4String.hh"
+#include "G4Types.hh"
+
+#include <vector>
+
+class G4VSolid;
+
+/**
+ * @namespace G4Sim
+ * @brief Namespace for the G4Sim library.
+/*/
+namespace G4Sim {
+
+/**
+ * @class SolidFlattener
+ * @brief Replaces a union or subtraction of coaxial, unrotated tubs by one G4Polycone or G4GenericPolycone.
+ *
+ * Every tubs is a rectangle [rMin, rMax] x [zMin, zMax] in the (r, z) plane, so the boolean solid is a region of
+ * rectangles that share the phi range of the tubs. The region is split on the grid of all r and z edges, and every
+ * cell is inside or outside after applying the components in order. If every z slab of the region is one r
+ * interval, overlapping the interval of the slab below, the solid is a G4Polycone; otherwise, if the outline of the
+ * cells is one simple polygon, a G4GenericPolycone. Regions with separate parts or holes in the (r, z) plane are not converted.
+ *
+ * Check() compares the new solid with the boolean solid at random points, with a fixed seed so that construction
+ * does not use the random engine of the run.
+ */
+class SolidFlattener {
+public:
+    SolidFlattener(G4double startPhi, G4double deltaPhi);
+    ~SolidFlattener() = default;
+
+    void Add(G4double rMin, G4double rMax, G4double zMin, G4double zMax, G4bool subtract);
+
+    G4VSolid* Build(const G4String& name);
+    G4bool Check(const G4VSolid* solid, const G4VSolid* reference, G4int nPoints);
+
+    // what Build() made, or why it made nothing
+    const G4String& GetDescription() const { return fDescription; }
+    // volume of the region, exact from the cells
+    G4double GetVolume() const;
+    // number of test points of the last Check() on which the solids disagree
+    G4int GetMismatches() const { return fMismatches; }
+
+    // edges closer than this are merged
+    static constexpr G4double kTolerance = 1e-6;  // mm
+
+private:
+    struct Component {
+        G4double rMin, rMax, zMin, zMax;
+        G4bool subtract;
+    };
+
+    void FillCells();
+    G4VSolid* BuildPolycone(const G4String& name);
+    G4VSolid* BuildGenericPolycone(const G4String& name);
+    G4bool IsInside(size_t i, size_t j) const { return fInside[j * (fREdges.size() - 1) + i]; }
+
+    G4double fStartPhi;
+    G4double fDeltaPhi;
+    std::vector<Component> fComponents;
+
+    std::vector<G4double> fREdges;
+    std::vector<G4double> fZEdges;
+    std::vector<G4bool> fInside;  // per cell, r index fastest
+
+    G4String fDescription;
+    G4int fMismatches = 0;
+};
+
+} // namespace G4Sim
+
+#endif
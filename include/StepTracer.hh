@@ -0,0 +1,115 @@
+#ifndef STEP_TRACER_HH
+#define STEP_TRACER_HH
+
+#include "G4String.hh"
+#include "G4Types.hh"
+
+#include <cstdint>
+#include <fstream>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class G4Event;
+class G4ParticleDefinition;
+class G4Step;
+class G4VProcess;
+
+/**
+ * @namespace G4Sim
+ * @brief Namespace for the G4Sim library.
+/*/
+namespace G4Sim {
+
+/**
+ * @struct StepRecord
+ * @brief One traced step, as stored in a step trace file.
+ *
+ * Positions are in mm, energies in MeV and the time in ns. The volume is the instance ID of the logical volume of the
+ * pre-step point and the process an index in the process table of the file, -1 if no process limited the step.
+ */
+struct StepRecord {
+    std::int32_t eventID;
+    std::int32_t trackID;
+    std::int32_t parentID;
+    std::int32_t pdgCode;
+    std::int16_t volume;
+    std::int16_t process;
+    float preX, preY, preZ;
+    float postX, postY, postZ;
+    float kineticEnergy;    /**< Kinetic energy at the post-step point. */
+    float energyDeposit;
+    float time;             /**< Global time at the post-step point. */
+};
+
+// analysis/StepTraceReader.py relies on this layout
+static_assert(sizeof(StepRecord) == 56, "StepRecord must be 56 bytes without padding");
+
+/**
+ * @class StepTracer
+ * @brief Writes the steps of selected events, volumes and particles to a binary file (.xst).
+ *
+ * The SteppingAction only calls the tracer when a file is set with /stepTrace/file, so tracing costs nothing when
+ * it is off. Steps are collected in a fixed size buffer that is written to the file when it is full and when the
+ * tracer is closed. Every thread writes its own file (name_t<thread>.xst). The format is:
+ *
+ *     header:  "XAMSSTP1", uint32 record size, uint32 reserved
+ *     records: StepRecord, 56 bytes each
+ *     footer:  uint32 nVolumes, per volume int32 instance ID, uint32 name length, name,
+ *              uint32 nProcesses, per process uint32 name length, name,
+ *              uint64 footer offset, "XAMSEND1"
+ *
+ * All numbers are little endian (checked at compile time, the records are written from memory).
+ * analysis/StepTraceReader.py reads the files with numpy.
+ */
+class StepTracer {
+public:
+    StepTracer() = default;
+    ~StepTracer();
+
+    void Open(const G4String& fileName);
+    void Close();
+    G4bool IsOpen() const { return fFile.is_open(); }
+
+    void SetBufferSize(size_t value) { fBufferSize = value; }
+    void SetEventRange(G4int first, G4int last) { fFirstEvent = first; fLastEvent = last; }
+    void AddVolume(const G4String& name) { fVolumeNames.push_back(name); fFiltersResolved = false; }
+    void AddParticle(const G4String& name) { fParticleNames.push_back(name); fFiltersResolved = false; }
+
+    void Trace(const G4Step* step);
+
+    static G4String MakeFileName(const G4String& fileName);
+
+private:
+    void ResolveFilters();
+    std::int16_t GetProcessIndex(const G4VProcess* process);
+    void Flush();
+
+    G4String fFileName;
+    std::ofstream fFile;
+    std::vector<StepRecord> fBuffer;
+    size_t fBufferSize = 65536;  // records
+    std::uint64_t fNRecords = 0;
+
+    // event filter, cached per event
+    G4int fFirstEvent = 0;
+    G4int fLastEvent = -1;  // no limit if < 0
+    const G4Event* fEvent = nullptr;
+    G4int fEventID = 0;
+    G4bool fEventSelected = false;
+
+    // volume and particle filters, empty means all
+    std::vector<G4String> fVolumeNames;
+    std::vector<G4String> fParticleNames;
+    G4bool fFiltersResolved = false;
+    std::vector<G4bool> fVolumeSelected;  // by logical volume instance ID
+    std::vector<const G4ParticleDefinition*> fParticles;
+    std::vector<std::pair<G4int, G4String>> fVolumeTable;  // instance ID and name of every logical volume
+
+    std::unordered_map<const G4VProcess*, std::int16_t> fProcessIndex;
+    std::vector<G4String> fProcessNames;
+};
+
+} // namespace G4Sim
+
+#endif
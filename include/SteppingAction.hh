@@ -5,7 +5,14 @@
 #include "G4ParticleTable.hh"
 #include "globals.hh"
 
+#include <memory>
+#include <utility>
+#include <vector>
+
 class G4LogicalVolume;
+class G4ParticleDefinition;
+class G4Track;
+class G4VPhysicalVolume;
 
 /// Stepping action class
 ///
@@ -17,6 +24,10 @@ class G4LogicalVolume;
 namespace G4Sim
 {
 class EventAction;
+class DetectorConstruction;
+class PhaseSpaceWriter;
+class StepTracer;
+class SteppingActionMessenger;
 
 /**
  * @class SteppingAction
@@ -24,21 +35,74 @@ class EventAction;
  *
  * This class inherits from G4UserSteppingAction and is responsible for defining the actions to be taken at each step of the simulation.
  * It is used in conjunction with the EventAction class to perform specific actions during the simulation.
+ *
+ * It applies the termination policies of the geometry (see TerminationPolicy): after each step the volume in which
+ * the step ended is looked up by the instance ID of its logical volume (the table is rebuilt at the start of every run,
+ * see ResolvePolicies()), and the track is killed if a condition of
+ * the policy holds. Volumes without a policy cost one table lookup per step.
+ *
+ * With importance biasing (see VolumeImportance) a biased particle that crosses into a volume of higher importance is
+ * split into copies with a proportionally lower weight, and one that crosses into a volume of lower importance plays
+ * Russian roulette: it survives with the ratio of the importances as probability, with its weight increased
+ * accordingly. Secondaries inherit the weight of their track, and the sensitive detectors store it with the hits.
+ *
+ * With /phaseSpace/record every particle that crosses into the chosen volume is written to a phase space file (see
+ * PhaseSpaceWriter) and, unless /phaseSpace/killAtSurface is false, killed at the surface.
+ *
+ * For debugging, the steps can be written to a binary trace file with /stepTrace/file (see StepTracer). The tracer
+ * only exists when it is used, and without a trace file it costs one pointer test per step.
  */
 class SteppingAction : public G4UserSteppingAction
 {
   public:
-    SteppingAction(EventAction* eventAction);
+    SteppingAction(EventAction* eventAction, const DetectorConstruction* detector = nullptr);
     ~SteppingAction();// override = default;
 
     // method from the base class
     void UserSteppingAction(const G4Step*) override;
-    void SetVerbosity(G4int level) { verbosityLevel = level; }  
-    void Print(const G4Step* step);
+
+    void SetPhaseSpace(const G4String& volumeName, const G4String& fileName);
+    void SetPhaseSpaceKill(G4bool value) { fPhaseSpaceKill = value; }
+
+    void SetStepTraceFile(const G4String& fileName);
+    StepTracer* GetStepTracer();
+
+    void ResolvePolicies();
 
   private:
+    /**
+     * @brief Termination policy of a volume, with the particles resolved.
+     */
+    struct VolumePolicy {
+      G4bool killOnEntry;
+      G4double maxTime;
+      G4double minKineticEnergy;
+      std::vector<std::pair<const G4ParticleDefinition*, G4double>> particleMinKineticEnergy;
+    };
+
+    G4bool IsTerminated(const VolumePolicy& policy, const G4Track* track) const;
+    void ApplyImportance(const G4Step* step);
+    G4double GetImportance(const G4VPhysicalVolume* volume) const;
+    void RecordPhaseSpace(const G4Step* step);
+
     EventAction* fEventAction;
-    G4int verbosityLevel=0;
+    const DetectorConstruction* fDetector = nullptr;
+
+    std::vector<VolumePolicy> fPolicies;
+    std::vector<G4int> fPolicyIndex;  // index in fPolicies by logical volume instance ID, -1 if none
+
+    std::vector<G4double> fImportance;  // importance by logical volume instance ID, 0 if none
+    std::vector<const G4ParticleDefinition*> fImportanceParticles;
+
+    G4String fPhaseSpaceVolumeName;
+    const G4LogicalVolume* fPhaseSpaceVolume = nullptr;  // resolved at the first step of a run
+    G4bool fPhaseSpaceKill = true;
+    std::unique_ptr<PhaseSpaceWriter> fPhaseSpaceWriter;
+
+    std::unique_ptr<StepTracer> fStepTracer;  // created by the first /stepTrace/ command
+    StepTracer* fActiveTracer = nullptr;      // fStepTracer once its file is open
+
+    SteppingActionMessenger* fMessenger;
 };
 
 } // namespace G4Sim
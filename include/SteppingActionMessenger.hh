@@ -0,0 +1,51 @@
+#ifndef STEPPING_ACTION_MESSENGER_H
+#define STEPPING_ACTION_MESSENGER_H 1
+
+#include "G4UImessenger.hh"
+#include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcommand.hh"
+#include "G4UIdirectory.hh"
+#include "globals.hh"
+
+/**
+ * @namespace G4Sim
+ * @brief Namespace for the G4Sim library.
+/*/
+namespace G4Sim {
+
+class SteppingAction;
+
+/**
+ * @class SteppingActionMessenger
+ * @brief A class responsible for handling user commands related to the stepping action.
+ *
+ * It provides the commands of the /phaseSpace/ directory that record a phase space, and of the /stepTrace/
+ * directory that trace steps to a file.
+ */
+class SteppingActionMessenger : public G4UImessenger {
+public:
+    SteppingActionMessenger(SteppingAction* steppingAction);
+    ~SteppingActionMessenger() override;
+
+    void SetNewValue(G4UIcommand* command, G4String newValue) override;
+
+private:
+    SteppingAction* fSteppingAction;
+
+    G4UIdirectory* fPhaseSpaceDirectory;
+    G4UIcommand* fRecordCmd;
+    G4UIcmdWithABool* fKillAtSurfaceCmd;
+
+    G4UIdirectory* fStepTraceDirectory;
+    G4UIcmdWithAString* fStepTraceFileCmd;
+    G4UIcommand* fStepTraceEventsCmd;
+    G4UIcmdWithAString* fStepTraceVolumeCmd;
+    G4UIcmdWithAString* fStepTraceParticleCmd;
+    G4UIcmdWithAnInteger* fStepTraceBufferSizeCmd;
+};
+
+} // namespace G4Sim
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef TERMINATION_POLICY_HH
+#define TERMINATION_POLICY_HH
+
+#include "G4String.hh"
+#include "G4Types.hh"
+
+#include <utility>
+#include <vector>
+
+class G4LogicalVolume;
+
+/**
+ * @namespace G4Sim
+ * @brief Namespace for the G4Sim library.
+/*/
+namespace G4Sim {
+
+/**
+ * @struct TerminationPolicy
+ * @brief Conditions under which tracks are killed in a volume, as declared in the geometry JSON file.
+ *
+ * The DetectorConstruction fills one entry per volume with a "termination" entry. Like the list of sensitive
+ * volumes it is read-only once the geometry is built, and the SteppingAction of every thread applies it.
+ * A track is killed when it ends a step in the volume and one of the conditions holds.
+ */
+struct TerminationPolicy {
+    G4String volumeName;              /**< Name of the logical volume. */
+    G4LogicalVolume* logicalVolume;   /**< The logical volume. */
+    G4bool killOnEntry;               /**< Kill every track in the volume. */
+    G4double maxTime;                 /**< Kill tracks with a later global time, no limit if <= 0. */
+    G4double minKineticEnergy;        /**< Kill tracks with a lower kinetic energy, for particles not listed below. */
+    std::vector<std::pair<G4String, G4double>> particleMinKineticEnergy; /**< Minimum kinetic energy per particle name. */
+};
+
+} // namespace G4Sim
+
+#endif
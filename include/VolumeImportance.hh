@@ -0,0 +1,32 @@
+#ifndef VOLUME_IMPORTANCE_HH
+#define VOLUME_IMPORTANCE_HH
+
+#include "G4String.hh"
+#include "G4Types.hh"
+
+class G4LogicalVolume;
+
+/**
+ * @namespace G4Sim
+ * @brief Namespace for the G4Sim library.
+/*/
+namespace G4Sim {
+
+/**
+ * @struct VolumeImportance
+ * @brief Importance of a volume for geometry importance biasing, as declared in the geometry JSON file.
+ *
+ * Volumes without an "importance" entry get the importance of their parent, and the world has importance 1 unless
+ * it declares one. The DetectorConstruction fills one entry per volume when at least one volume declares an
+ * importance, and the SteppingAction of every thread splits or plays Russian roulette with tracks that cross from
+ * one importance to another.
+ */
+struct VolumeImportance {
+    G4String volumeName;            /**< Name of the logical volume. */
+    G4LogicalVolume* logicalVolume; /**< The logical volume. */
+    G4double importance;            /**< Importance of the volume, > 0. */
+};
+
+} // namespace G4Sim
+
+#endif
@@ -4,6 +4,7 @@ import shutil
 import subprocess
 import datetime
 import argparse
+import glob
 import random
 
 class PathManager:
@@ -110,6 +111,12 @@ def generate_detector_configuration(detector_configuration):
         f"/detector/setGeometryFileName {detector_configuration['geometryFileName']}",
         f"/detector/setMaterialFileName {detector_configuration['materialFileName']}",
     ]
+    # optional directory of the geometry cache, shared by the jobs
+    if 'geometryCache' in detector_configuration:
+        commands.append(f"/detector/geometryCache {detector_configuration['geometryCache']}")
+    # boolean solids of tubs are replaced by polycones unless this is false
+    if 'flattenBooleans' in detector_configuration:
+        commands.append(f"/detector/flattenBooleans {str(detector_configuration['flattenBooleans']).lower()}")
     return "\n".join(commands)
 
 def generate_run_settings(run_settings, path_manager, job_id):
@@ -122,9 +129,96 @@ def generate_run_settings(run_settings, path_manager, job_id):
         f"/run/setOutputFileName {output_file_name}",
         f"/run/printProgress {run_settings['printProgress']}", 
     ]
+    # optional output format: root (default) or columnar
+    if 'outputFormat' in run_settings:
+        commands.append(f"/run/setOutputFormat {run_settings['outputFormat']}")
+    if 'outputCompression' in run_settings:
+        commands.append(f"/run/setOutputCompression {run_settings['outputCompression']}")
+    # optional layout of the per detector columns: dense (default) or sparse
+    if 'eventLayout' in run_settings:
+        commands.append(f"/run/setEventLayout {run_settings['eventLayout']}")
+    # optional per phase timing report next to the output file
+    if run_settings.get('timingReport', False):
+        commands.append("/run/timingReport true")
+    # optional directory of the physics table cache, shared by the jobs
+    if 'physicsTableCache' in run_settings:
+        commands.append(f"/run/physicsTableCache {run_settings['physicsTableCache']}")
     
     return "\n".join(commands)
 
+def generate_trigger_settings(trigger_settings):
+    """
+    Generate the event trigger commands based on the provided trigger_settings.
+
+    The windows are given per active volume in keV, e.g. {"LXe": [10, 2000]}; a single number is a minimum energy.
+    """
+    commands = []
+    for volume, window in trigger_settings.get('windows', {}).items():
+        if isinstance(window, (int, float)):
+            window = [window, 0]
+        commands.append(f"/event/trigger/window {volume} {window[0]} {window[1]} keV")
+    if 'coincidence' in trigger_settings:
+        commands.append(f"/event/trigger/coincidence {trigger_settings['coincidence']}")
+    if 'prescale' in trigger_settings:
+        commands.append(f"/event/trigger/prescale {trigger_settings['prescale']}")
+    return "\n".join(commands)
+
+def generate_phase_space_settings(phase_space_settings, path_manager, job_id):
+    """
+    Generate the phase space record and replay commands based on the provided phase_space_settings.
+
+    The recorded file is written to the output directory, one file per job (and per thread). The replayed files are
+    glob patterns, e.g. "output/run_1/ps_*.xps".
+    """
+    commands = []
+    if 'recordVolume' in phase_space_settings:
+        file_name = os.path.join(path_manager.output_dir, f"{phase_space_settings['recordFileName']}_{job_id}")
+        commands.append(f"/phaseSpace/record {phase_space_settings['recordVolume']} {file_name}")
+        if 'killAtSurface' in phase_space_settings:
+            commands.append(f"/phaseSpace/killAtSurface {str(phase_space_settings['killAtSurface']).lower()}")
+    for pattern in phase_space_settings.get('replayFiles', []):
+        for file_name in sorted(glob.glob(pattern)):
+            commands.append(f"/phaseSpace/replay/addFile {file_name}")
+    if 'reuse' in phase_space_settings:
+        commands.append(f"/phaseSpace/replay/reuse {phase_space_settings['reuse']}")
+    return "\n".join(commands)
+
+def generate_summary_settings(summary_settings):
+    """
+    Generate the run summary commands based on the provided summary_settings.
+
+    Every histogram is a string "quantity nBins min max", with up to three axes, e.g. "edet 200 0 2000". The
+    histograms are cleared first, so that a run of a manifest does not keep the histograms of the run before.
+    With "writeNtuple" false only the histograms are written.
+    """
+    commands = ["/summary/clear"]
+    for histogram in summary_settings.get('histograms', []):
+        commands.append(f"/summary/histogram {histogram}")
+    commands.append(f"/summary/writeNtuple {str(summary_settings.get('writeNtuple', True)).lower()}")
+    return "\n".join(commands)
+
+def generate_event_seeding(settings, event_offset):
+    """
+    Generate the per event seeding commands.
+
+    With "eventSeeding" (default true) every event is seeded from randomSeed and its global event number, so the
+    events do not depend on the number of jobs and threads.
+
+    Args:
+        settings (dict): The simulation settings.
+        event_offset (int): Global event number of the first event of the job.
+
+    Returns:
+        str: A string containing the seeding commands.
+    """
+    if not settings.get("eventSeeding", True):
+        return "/run/eventSeed 0"
+    commands = [
+        f"/run/eventSeed {settings['randomSeed']}",
+        f"/run/eventOffset {event_offset}"
+    ]
+    return "\n".join(commands)
+
 def generate_run_control(beam_on, random_seed1, random_seed2):
     """
     Generate the run section commands for the macro file.
@@ -161,6 +255,10 @@ def generate_mac_file(settings, path_manager, beam_on, random_seed1, job_id):
     gps_commands = generate_gps_settings(settings["gps_settings"])
     detector_commands = generate_detector_configuration(settings["detector_configuration"])
     run_commands = generate_run_settings(settings["run_settings"], path_manager, job_id)
+    trigger_commands = generate_trigger_settings(settings.get("trigger_settings", {}))
+    phase_space_commands = generate_phase_space_settings(settings.get("phase_space_settings", {}), path_manager, job_id)
+    summary_commands = generate_summary_settings(settings.get("summary_settings", {}))
+    seeding_commands = generate_event_seeding(settings, job_id * beam_on)
     run_section = generate_run_control(beam_on, random_seed1, random_seed1 + 1)
     
     # Combine all the sections into the final macro content
@@ -173,6 +271,10 @@ def generate_mac_file(settings, path_manager, beam_on, random_seed1, job_id):
         "/run/initialize",
         gps_commands,
         run_commands,
+        trigger_commands,
+        phase_space_commands,
+        summary_commands,
+        seeding_commands,
         run_section
     ])
 
@@ -183,7 +285,77 @@ def generate_mac_file(settings, path_manager, beam_on, random_seed1, job_id):
     
     return mac_file
 
-def submit_job(mac_file, path_manager, job_name="G4Job"):
+def generate_manifest(settings_list, path_manager, beam_on, num_jobs):
+    """
+    Generates a manifest that runs all jobs of all settings back to back in one G4XamsSim process.
+
+    The geometry and physics are initialized once, so all settings must share the detector configuration. The
+    settings of a run carry over to the next run, so every run sets its GPS, run, trigger, phase space and summary commands.
+
+    Args:
+        settings_list (list): The prepared settings, one per JSON file.
+        path_manager (PathManager): Path management instance.
+        beam_on (int): Number of events per settings, divided over the jobs.
+        num_jobs (int): Number of runs per settings.
+
+    Returns:
+        str: The path to the manifest file.
+    """
+    first = settings_list[0]
+    for settings in settings_list[1:]:
+        if settings["detector_configuration"] != first["detector_configuration"]:
+            raise ValueError("all settings of a manifest must use the same detector_configuration")
+
+    setup = [
+        f"/control/verbose {first['verbose']}",
+        f"/run/verbose {first['verbose']}",
+        f"/tracking/verbose {first['verbose']}",
+    ] + generate_detector_configuration(first["detector_configuration"]).split("\n")
+
+    runs = []
+    for settings in settings_list:
+        for job_id in range(num_jobs):
+            random_seed = settings["randomSeed"] + job_id * 10
+            sections = [
+                generate_gps_settings(settings["gps_settings"]),
+                generate_run_settings(settings["run_settings"], path_manager, job_id),
+                generate_trigger_settings(settings.get("trigger_settings", {})),
+                generate_phase_space_settings(settings.get("phase_space_settings", {}), path_manager, job_id),
+                generate_summary_settings(settings.get("summary_settings", {})),
+                generate_event_seeding(settings, job_id * (beam_on // num_jobs)),
+            ]
+            commands = [command for section in sections for command in section.split("\n") if command]
+            runs.append({
+                "name": f"{settings['run_settings']['outputFileName']}_{job_id}",
+                "commands": commands,
+                "seeds": [random_seed, random_seed + 1],
+                "beamOn": beam_on // num_jobs,
+            })
+
+    manifest_file = os.path.join(path_manager.jobs_dir, "manifest.json")
+    save_settings({"setup": setup, "runs": runs}, manifest_file)
+    return manifest_file
+
+def executable_arguments(mac_file, threads, processes=0):
+    """
+    Build the command line arguments of the G4XamsSim executable.
+
+    Args:
+        mac_file (str): The path to the macro file, or to a manifest (.json).
+        threads (int): Number of worker threads. With 0 the serial run manager is used.
+        processes (int, optional): Number of processes forked after initialization to execute a manifest.
+
+    Returns:
+        str: The arguments as a single string.
+    """
+    arguments = f"-m {mac_file}" if mac_file.endswith(".json") else mac_file
+    if processes > 0:
+        return f"{arguments} -f {processes}"
+    if threads > 0:
+        return f"{arguments} -t {threads}"
+    return arguments
+
+def submit_job(mac_file, path_manager, job_name="G4Job", threads=0, processes=0):
     """
     Submits a Geant4 job to the batch queue using a job submission system (e.g., SLURM, PBS).
     Modify this function according to the specifics of your batch system.
@@ -192,9 +364,10 @@ def submit_job(mac_file, path_manager, job_name="G4Job"):
     # shutil.move(mac_file, path_manager.jobs_dir)
 
     # Create a condor submit file
-    submit_file = os.path.join(path_manager.jobs_dir, f"submit_{os.path.basename(mac_file).replace('.mac', '.submit')}")
+    job_file_base = os.path.splitext(os.path.basename(mac_file))[0]
+    submit_file = os.path.join(path_manager.jobs_dir, f"submit_{job_file_base}.submit")
     log_file = os.path.join(path_manager.logs_dir, f"{job_name}.log")
-    script_file = os.path.join(path_manager.jobs_dir, f"submit_{os.path.basename(mac_file).replace('.mac', '.sh')}")
+    script_file = os.path.join(path_manager.jobs_dir, f"submit_{job_file_base}.sh")
 
     submit_content = f"""
 executable = {script_file}
@@ -207,6 +380,7 @@ log = {log_file}
 +UseOS                  = "el9"
 ## This job can run up to 4 hours. Can choose "express", "short", "medium", or "long".
 +JobCategory            = "short"
+request_cpus            = {max(threads, 1)}
 queue
     """
     with open(submit_file, 'w') as file:
@@ -217,7 +391,7 @@ queue
 source /user/z37/.bashrc
 conda activate g4
 cd {path_manager.jobs_dir}
-/user/z37/g4/G4XamsSim/build/G4XamsSim {mac_file}
+/user/z37/g4/G4XamsSim/build/G4XamsSim {executable_arguments(mac_file, threads, processes)}
 """
     with open(script_file, 'w') as file:
         file.write(script_content)
@@ -228,20 +402,22 @@ cd {path_manager.jobs_dir}
     # Submit the job
     subprocess.run(["condor_submit", submit_file])
 
-def run_simulation(mac_file, path_manager):
+def run_simulation(mac_file, path_manager, threads=0, processes=0):
     """
     Run the simulation using the specified macro file and path manager.
 
     Args:
         mac_file (str): The path to the macro file.
         path_manager (PathManager): An instance of the PathManager class.
+        threads (int): Number of worker threads. With 0 the serial run manager is used.
+        processes (int, optional): Number of processes forked after initialization to execute a manifest.
 
     Returns:
         None
     """
     executable = os.path.join(path_manager.project_base_dir, "build", "G4XamsSim")
     print(executable, mac_file)
-    subprocess.run([executable, mac_file])
+    subprocess.run([executable] + executable_arguments(mac_file, threads, processes).split())
 
 def parse_arguments():
     """
@@ -251,13 +427,16 @@ def parse_arguments():
         argparse.Namespace: Parsed command line arguments.
     """
     parser = argparse.ArgumentParser(description="Run Geant4 simulation with specified settings.")
-    parser.add_argument("-json", "--json_file", required=True, help="Path to the JSON settings file.")
+    parser.add_argument("-json", "--json_file", required=True, nargs="+", help="Path to the JSON settings file(s).")
     parser.add_argument("-n", "--beam_on", type=int, required=True, help="Number of events to simulate.")
     parser.add_argument("-o", "--output_dir", default=None, help="Optional output directory. Defaults to a parameter-based directory in '../output'.")
     parser.add_argument("-rundb", "--rundb_file", default="rundb.json", help="Path to the run database file.")
     parser.add_argument("-jobs", "--num_jobs", type=int, default=1, help="Number of jobs to submit.")
     parser.add_argument("--batch", action="store_true", help="Submit jobs to batch queue.")
     parser.add_argument("--base_dir", default="/user/z37/g4/G4XamsSim", help="Base directory of the project.")
+    parser.add_argument("-t", "--threads", type=int, default=0, help="Number of worker threads per job (0 = serial).")
+    parser.add_argument("--manifest", action="store_true", help="Run all jobs of all JSON files in one process (one initialization).")
+    parser.add_argument("-f", "--fork", type=int, default=0, help="With --manifest: run the jobs in this many processes forked after initialization.")
     return parser.parse_args()
 
 def initialize_paths(args):
@@ -272,27 +451,30 @@ def initialize_paths(args):
     """
     return PathManager(args.base_dir, args.output_dir)
 
-def prepare_settings(args, path_manager):
+def prepare_settings(args, path_manager, json_file, settings_name="settings.json"):
     """
     Prepare the simulation settings.
 
     Args:
         args (object): The command line arguments.
         path_manager (object): The path manager object.
+        json_file (str): The path to the JSON settings file.
+        settings_name (str, optional): The name of the copy of the settings in the output directory.
 
     Returns:
         dict: The prepared simulation settings.
     """
-    settings = load_settings(args.json_file)
+    settings = load_settings(json_file)
 
         # copy the geometry and material files to the output directory
     shutil.copy(settings["detector_configuration"]["geometryFileName"], path_manager.output_dir)
     shutil.copy(settings["detector_configuration"]["materialFileName"], path_manager.output_dir)
 
-    random_seed = random.randint(0, 1000000)
+    random_seed = random.randint(1, 1000000)  # 0 would switch off the per event seeding
     settings['randomSeed'] = random_seed
     settings['beamOn'] = args.beam_on
-    settings_file = os.path.join(path_manager.output_dir, "settings.json")
+    settings['settingsFile'] = settings_name
+    settings_file = os.path.join(path_manager.output_dir, settings_name)
 
     # replace the geometry and material file paths in the settings with the copied paths
     settings["detector_configuration"]["geometryFileName"] = os.path.join(path_manager.output_dir, os.path.basename(settings["detector_configuration"]["geometryFileName"]))
@@ -320,9 +502,9 @@ def execute_jobs(args, settings, path_manager):
     for job_id in range(args.num_jobs):
         mac_file = generate_mac_file(settings, path_manager, args.beam_on // args.num_jobs, settings["randomSeed"] + job_id * 10, job_id)
         if args.batch:
-            submit_job(mac_file, path_manager, f"job_{job_id}")
+            submit_job(mac_file, path_manager, f"job_{job_id}", args.threads)
         else:
-            run_simulation(mac_file, path_manager)
+            run_simulation(mac_file, path_manager, args.threads)
 
 def update_master_rundb(rundb, settings, path_manager, args):
     """
@@ -351,7 +533,7 @@ def update_master_rundb(rundb, settings, path_manager, args):
         "numEvents": args.beam_on,
         "numJobs": args.num_jobs,
         "randomSeed": settings["randomSeed"],
-        "settingsFile": "settings.json",
+        "settingsFile": settings["settingsFile"],
         "status": "active"
     }
     rundb['runs'].append(new_run)
@@ -389,12 +571,24 @@ def main():
     rundb = load_settings(args.rundb_file)
     # 3. Initialize the path manager
     path_manager = initialize_paths(args)
-    # 4. Prepare the simulation settings
-    settings = prepare_settings(args, path_manager)
-    # 5. Execute the simulation jobs
-    execute_jobs(args, settings, path_manager)
+    # 4. Prepare the simulation settings, one copy per JSON file
+    settings_list = []
+    for json_file in args.json_file:
+        settings_name = "settings.json" if len(args.json_file) == 1 else f"settings_{os.path.splitext(os.path.basename(json_file))[0]}.json"
+        settings_list.append(prepare_settings(args, path_manager, json_file, settings_name))
+    # 5. Execute the simulation jobs, in one process with --manifest
+    if args.manifest:
+        manifest_file = generate_manifest(settings_list, path_manager, args.beam_on, args.num_jobs)
+        if args.batch:
+            submit_job(manifest_file, path_manager, "manifest", args.threads, args.fork)
+        else:
+            run_simulation(manifest_file, path_manager, args.threads, args.fork)
+    else:
+        for settings in settings_list:
+            execute_jobs(args, settings, path_manager)
     # 6. Update the master configuration file
-    update_master_rundb(rundb, settings, path_manager, args)
+    for settings in settings_list:
+        update_master_rundb(rundb, settings, path_manager, args)
 
 if __name__ == "__main__":
     main()
@@ -5,33 +5,40 @@
 #include "RunAction.hh"
 #include "EventAction.hh"
 #include "SteppingAction.hh"
+#include "PhaseTimers.hh"
 
 namespace G4Sim
 {
 
-ActionInitialization::ActionInitialization()
-  : G4VUserActionInitialization()
+ActionInitialization::ActionInitialization(const DetectorConstruction* detector)
+  : G4VUserActionInitialization(), fDetector(detector)
 {
 }
 
 void ActionInitialization::BuildForMaster() const
 {
-  auto eventAction = new EventAction;
+  PhaseTimers::WatchInitialization();
+
+  auto eventAction = new EventAction(fDetector);
   SetUserAction(new RunAction(eventAction));
 }
 
 void ActionInitialization::Build() const
 {
+  // called on every thread before its run manager is initialized
+  PhaseTimers::WatchInitialization();
+
   SetUserAction(new PrimaryGeneratorAction);
 
-  auto eventAction = new EventAction();
+  auto eventAction = new EventAction(fDetector);
   SetUserAction(eventAction);
 
   auto runAction = new RunAction(eventAction);
   SetUserAction(runAction);
 
-  auto steppingAction = new SteppingAction(eventAction);
+  auto steppingAction = new SteppingAction(eventAction, fDetector);
   SetUserAction(steppingAction);
+  runAction->SetSteppingAction(steppingAction);
 }
 
 } // namespace G4FastSim
@@ -0,0 +1,72 @@
+#include "AnalysisManagerOutput.hh"
+
+#include "G4AnalysisManager.hh"
+
+/**
+ * @namespace G4Sim
+ * @brief Namespace for the G4Sim library.
+/*/
+namespace G4Sim {
+
+/**
+ * @brief Opens the ROOT file. Ntuple merging is enabled, so workers send their rows to the master.
+ */
+void AnalysisManagerOutput::OpenFile(const G4String& fileName) {
+    auto analysisManager = G4AnalysisManager::Instance();
+    analysisManager->SetDefaultFileType("root");
+    analysisManager->SetVerboseLevel(1);
+    analysisManager->SetNtupleMerging(true);
+    analysisManager->OpenFile(fileName);
+}
+
+/**
+ * @brief Books the ntuple, or reuses the ntuple booked in an earlier run of this thread.
+ */
+void AnalysisManagerOutput::CreateNtuple(const G4String& name, const G4String& title) {
+    auto analysisManager = G4AnalysisManager::Instance();
+    fNColumns = 0;
+    fBooked = analysisManager->GetNofNtuples() > 0;
+    if (fBooked) {
+        fNtupleId = analysisManager->GetFirstNtupleId();
+        return;
+    }
+    fNtupleId = analysisManager->CreateNtuple(name, title);
+}
+
+G4int AnalysisManagerOutput::CreateDColumn(const G4String& name) {
+    if (fBooked) return fNColumns++;
+    return G4AnalysisManager::Instance()->CreateNtupleDColumn(fNtupleId, name);
+}
+
+G4int AnalysisManagerOutput::CreateDColumn(const G4String& name, std::vector<G4double>& values) {
+    if (fBooked) return fNColumns++;
+    return G4AnalysisManager::Instance()->CreateNtupleDColumn(fNtupleId, name, values);
+}
+
+G4int AnalysisManagerOutput::CreateIColumn(const G4String& name, std::vector<G4int>& values) {
+    if (fBooked) return fNColumns++;
+    return G4AnalysisManager::Instance()->CreateNtupleIColumn(fNtupleId, name, values);
+}
+
+void AnalysisManagerOutput::FinishNtuple() {
+    if (fBooked) return;
+    G4AnalysisManager::Instance()->FinishNtuple(fNtupleId);
+}
+
+void AnalysisManagerOutput::FillDColumn(G4int column, G4double value) {
+    G4AnalysisManager::Instance()->FillNtupleDColumn(fNtupleId, column, value);
+}
+
+void AnalysisManagerOutput::AddRow() {
+    G4AnalysisManager::Instance()->AddNtupleRow(fNtupleId);
+}
+
+void AnalysisManagerOutput::Write() {
+    G4AnalysisManager::Instance()->Write();
+}
+
+void AnalysisManagerOutput::CloseFile() {
+    G4AnalysisManager::Instance()->CloseFile();
+}
+
+} // namespace G4Sim
@@ -0,0 +1,260 @@
+#include "ColumnarOutput.hh"
+
+#include "G4Exception.hh"
+#include "G4Threading.hh"
+#include "G4ios.hh"
+
+#include <cstring>
+
+#ifdef G4XAMSSIM_USE_ZSTD
+#include <zstd.h>
+#endif
+
+// the blocks are written from memory as they are, the format is little endian
+#if !defined(__BYTE_ORDER__) || __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "ColumnarOutput requires a little endian host"
+#endif
+
+/**
+ * @namespace G4Sim
+ * @brief Namespace for the G4Sim library.
+/*/
+namespace G4Sim {
+
+namespace {
+    const char kHeaderMagic[8] = {'X', 'A', 'M', 'S', 'C', 'O', 'L', '1'};
+    const char kFooterMagic[8] = {'X', 'A', 'M', 'S', 'E', 'N', 'D', '1'};
+    const int kZstdLevel = 3;
+}
+
+/**
+ * @brief Constructs a ColumnarOutput.
+ *
+ * @param chunkSize The number of rows per chunk.
+ * @param compression The compression of the blocks. Falls back to no compression if zstd is not available.
+ */
+ColumnarOutput::ColumnarOutput(size_t chunkSize, Compression compression)
+    : fChunkSize(chunkSize > 0 ? chunkSize : 1), fCompression(compression) {
+#ifndef G4XAMSSIM_USE_ZSTD
+    if (fCompression == kZstd) {
+        G4ExceptionDescription msg;
+        msg << "G4XamsSim was built without zstd, the columnar output is written uncompressed." << G4endl;
+        G4Exception("ColumnarOutput::ColumnarOutput()", "Output0001", JustWarning, msg);
+        fCompression = kNone;
+    }
+#endif
+}
+
+ColumnarOutput::~ColumnarOutput() {
+    if (fFile.is_open()) CloseFile();
+}
+
+/**
+ * @brief Returns the name of the file of this thread.
+ *
+ * A ".root" or ".xcol" extension is replaced by ".xcol", and worker threads add their thread ID, e.g.
+ * "out.root" becomes "out_t3.xcol" on worker 3 and "out.xcol" in a sequential run.
+ */
+G4String ColumnarOutput::MakeFileName(const G4String& fileName) {
+    G4String base = fileName;
+    for (const G4String extension : {".root", ".xcol"}) {
+        if (base.size() > extension.size() &&
+            base.compare(base.size() - extension.size(), extension.size(), extension) == 0) {
+            base = base.substr(0, base.size() - extension.size());
+        }
+    }
+    if (G4Threading::IsWorkerThread()) {
+        base += "_t" + std::to_string(G4Threading::G4GetThreadId());
+    }
+    return base + ".xcol";
+}
+
+void ColumnarOutput::OpenFile(const G4String& fileName) {
+    fFileName = MakeFileName(fileName);
+    fFile.open(fFileName, std::ios::binary | std::ios::trunc);
+    if (!fFile) {
+        G4ExceptionDescription msg;
+        msg << "Cannot open output file " << fFileName << G4endl;
+        G4Exception("ColumnarOutput::OpenFile()", "Output0002", FatalException, msg);
+    }
+    G4cout << "ColumnarOutput::OpenFile: writing " << fFileName << G4endl;
+
+    fPosition = 0;
+    fColumns.clear();
+    fRowsInChunk = 0;
+    fChunkOffsets.clear();
+    fChunkRows.clear();
+}
+
+void ColumnarOutput::CreateNtuple(const G4String&, const G4String&) {
+    // a file holds a single ntuple, its columns are created next
+    fColumns.clear();
+}
+
+G4int ColumnarOutput::CreateDColumn(const G4String& name) {
+    Column column;
+    column.name = name;
+    column.type = kDouble;
+    fColumns.push_back(column);
+    return static_cast<G4int>(fColumns.size()) - 1;
+}
+
+G4int ColumnarOutput::CreateDColumn(const G4String& name, std::vector<G4double>& values) {
+    Column column;
+    column.name = name;
+    column.type = kJaggedDouble;
+    column.doubleSource = &values;
+    column.offsets.push_back(0);
+    fColumns.push_back(column);
+    return static_cast<G4int>(fColumns.size()) - 1;
+}
+
+G4int ColumnarOutput::CreateIColumn(const G4String& name, std::vector<G4int>& values) {
+    Column column;
+    column.name = name;
+    column.type = kJaggedInt;
+    column.intSource = &values;
+    column.offsets.push_back(0);
+    fColumns.push_back(column);
+    return static_cast<G4int>(fColumns.size()) - 1;
+}
+
+void ColumnarOutput::FinishNtuple() {
+    for (auto& column : fColumns) {
+        if (column.type == kDouble) {
+            column.doubleValues.reserve(fChunkSize);
+        } else {
+            column.offsets.reserve(fChunkSize + 1);
+        }
+    }
+    WriteHeader();
+}
+
+void ColumnarOutput::FillDColumn(G4int column, G4double value) {
+    fColumns[column].value = value;
+}
+
+/**
+ * @brief Appends the current values of all columns as a row, and writes the chunk when it is full.
+ */
+void ColumnarOutput::AddRow() {
+    for (auto& column : fColumns) {
+        switch (column.type) {
+            case kDouble:
+                column.doubleValues.push_back(column.value);
+                break;
+            case kJaggedDouble:
+                column.doubleValues.insert(column.doubleValues.end(), column.doubleSource->begin(), column.doubleSource->end());
+                column.offsets.push_back(column.doubleValues.size());
+                break;
+            case kJaggedInt:
+                column.intValues.insert(column.intValues.end(), column.intSource->begin(), column.intSource->end());
+                column.offsets.push_back(column.intValues.size());
+                break;
+        }
+    }
+    if (++fRowsInChunk == fChunkSize) FlushChunk();
+}
+
+void ColumnarOutput::Write() {
+    if (fRowsInChunk > 0) FlushChunk();
+    fFile.flush();
+}
+
+/**
+ * @brief Writes the remaining rows and the footer with the chunk index, and closes the file.
+ */
+void ColumnarOutput::CloseFile() {
+    if (!fFile.is_open()) return;
+    if (fRowsInChunk > 0) FlushChunk();
+
+    std::uint64_t footerOffset = fPosition;
+    std::uint64_t nChunks = fChunkOffsets.size();
+    WriteRaw(&nChunks, sizeof(nChunks));
+    for (size_t i = 0; i < fChunkOffsets.size(); ++i) {
+        WriteRaw(&fChunkOffsets[i], sizeof(std::uint64_t));
+        WriteRaw(&fChunkRows[i], sizeof(std::uint64_t));
+    }
+    WriteRaw(&footerOffset, sizeof(footerOffset));
+    WriteRaw(kFooterMagic, sizeof(kFooterMagic));
+    fFile.close();
+
+    G4cout << "ColumnarOutput::CloseFile: " << fFileName << " has " << nChunks << " chunks" << G4endl;
+}
+
+void ColumnarOutput::WriteHeader() {
+    WriteRaw(kHeaderMagic, sizeof(kHeaderMagic));
+    std::uint32_t compression = fCompression;
+    std::uint32_t nColumns = static_cast<std::uint32_t>(fColumns.size());
+    WriteRaw(&compression, sizeof(compression));
+    WriteRaw(&nColumns, sizeof(nColumns));
+    for (const auto& column : fColumns) {
+        std::uint32_t type = column.type;
+        std::uint32_t length = static_cast<std::uint32_t>(column.name.size());
+        WriteRaw(&type, sizeof(type));
+        WriteRaw(&length, sizeof(length));
+        WriteRaw(column.name.data(), length);
+        Pad();
+    }
+}
+
+void ColumnarOutput::FlushChunk() {
+    fChunkOffsets.push_back(fPosition);
+    fChunkRows.push_back(fRowsInChunk);
+
+    std::uint64_t nRows = fRowsInChunk;
+    WriteRaw(&nRows, sizeof(nRows));
+    for (auto& column : fColumns) {
+        if (column.type != kDouble) {
+            WriteBlock(column.offsets.data(), column.offsets.size() * sizeof(std::uint64_t));
+        }
+        if (column.type == kJaggedInt) {
+            WriteBlock(column.intValues.data(), column.intValues.size() * sizeof(std::int32_t));
+        } else {
+            WriteBlock(column.doubleValues.data(), column.doubleValues.size() * sizeof(G4double));
+        }
+
+        // the buffers keep their capacity for the next chunk
+        column.doubleValues.clear();
+        column.intValues.clear();
+        if (column.type != kDouble) {
+            column.offsets.clear();
+            column.offsets.push_back(0);
+        }
+    }
+    fRowsInChunk = 0;
+}
+
+void ColumnarOutput::WriteBlock(const void* data, std::uint64_t size) {
+    const void* stored = data;
+    std::uint64_t storedSize = size;
+
+#ifdef G4XAMSSIM_USE_ZSTD
+    if (fCompression == kZstd && size > 0) {
+        fCompressBuffer.resize(ZSTD_compressBound(size));
+        size_t compressedSize = ZSTD_compress(fCompressBuffer.data(), fCompressBuffer.size(), data, size, kZstdLevel);
+        if (!ZSTD_isError(compressedSize) && compressedSize < size) {
+            stored = fCompressBuffer.data();
+            storedSize = compressedSize;
+        }
+    }
+#endif
+
+    WriteRaw(&size, sizeof(size));
+    WriteRaw(&storedSize, sizeof(storedSize));
+    WriteRaw(stored, storedSize);
+    Pad();
+}
+
+void ColumnarOutput::WriteRaw(const void* data, size_t size) {
+    fFile.write(static_cast<const char*>(data), size);
+    fPosition += size;
+}
+
+void ColumnarOutput::Pad() {
+    static const char zeros[8] = {0};
+    size_t padding = (8 - fPosition % 8) % 8;
+    if (padding > 0) WriteRaw(zeros, padding);
+}
+
+} // namespace G4Sim
@@ -20,15 +20,18 @@
 #include "DetectorConstructionMessenger.hh"
 #include "Materials.hh"
 #include "SensitiveDetector.hh"
-#include "EventAction.hh"
+#include "PhaseTimers.hh"
+#include "GeometryCache.hh"
+#include "SolidFlattener.hh"
 #include "G4Material.hh"
 #include "G4SDManager.hh"
-#include "G4RunManager.hh"
 
 
 #include "nlohmann/json.hpp"
+#include <cmath>
 #include <fstream>
 #include <iostream>
+#include <sstream>
 
 using namespace G4Sim;
 using json = nlohmann::json;
@@ -57,10 +60,50 @@ DetectorConstruction::~DetectorConstruction() {}
  * @brief Constructs the physical volume of the detector.
  * 
  * This function loads the geometry from a JSON file and constructs the physical volume of the detector.
+ * With a geometry cache directory the geometry is loaded from the cache when it has an entry for the same files and
+ * settings; otherwise it is built and stored in the cache. The time spent here is added to the construct phase of
+ * the PhaseTimers.
  * 
  * @return The constructed physical volume of the detector.
  */
 G4VPhysicalVolume* DetectorConstruction::Construct()
+{
+    PhaseTimer timer(PhaseTimers::Instance(), PhaseTimers::kConstruct);
+
+    if (fGeometryCacheDirectory.empty()) return BuildGeometry();
+    if (!GeometryCache::IsAvailable()) {
+        G4cerr << "DetectorConstruction::Construct: Warning: built without GDML support, the geometry cache is not used" << G4endl;
+        return BuildGeometry();
+    }
+
+    // the key covers everything that changes the constructed geometry or its metadata
+    std::ostringstream settings;
+    settings << "streamingClustering=" << fStreamingClustering << " hitStore=" << fHitStore
+             << " checkOverlaps=" << fCheckOverlaps << " flattenBooleans=" << fFlattenBooleans;
+    GeometryCache cache(fGeometryCacheDirectory, GeometryCache::Hash({geoFileName, matFileName}, settings.str()));
+
+    if (cache.Contains()) {
+        json metadata;
+        fWorldPhysical = cache.Load(metadata);
+        if (fWorldPhysical) {
+            RestoreCacheMetadata(metadata);
+            G4cout << "DetectorConstruction::Construct: Geometry loaded from the cache: " << cache.GetGdmlFileName() << G4endl;
+            return fWorldPhysical;
+        }
+        G4cerr << "DetectorConstruction::Construct: Warning: cannot read " << cache.GetGdmlFileName() << ", building the geometry" << G4endl;
+    }
+
+    BuildGeometry();
+    cache.Store(fWorldPhysical, MakeCacheMetadata());
+    return fWorldPhysical;
+}
+
+/**
+ * @brief Defines the materials and builds the geometry from the JSON files.
+ *
+ * @return The world volume.
+ */
+G4VPhysicalVolume* DetectorConstruction::BuildGeometry()
 {
     // construct materials
     fMaterials = new Materials(matFileName);
@@ -74,6 +117,107 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
     return fWorldPhysical;
 }
 
+/**
+ * @brief Returns the settings of the geometry that GDML does not hold, for the geometry cache.
+ *
+ * Quantities are stored in Geant4 internal units.
+ */
+json DetectorConstruction::MakeCacheMetadata() const {
+    json metadata;
+
+    metadata["sensitiveVolumes"] = json::array();
+    for (const SensitiveVolume& sensitiveVolume : fSensitiveVolumes) {
+        metadata["sensitiveVolumes"].push_back({
+            {"volumeName", sensitiveVolume.volumeName},
+            {"collectionName", sensitiveVolume.collectionName},
+            {"spatialThreshold", sensitiveVolume.spatialThreshold},
+            {"timeThreshold", sensitiveVolume.timeThreshold},
+            {"streamingClustering", sensitiveVolume.streamingClustering},
+            {"hitStore", sensitiveVolume.hitStore},
+            {"trigger", sensitiveVolume.trigger},
+            {"triggerMinEnergy", sensitiveVolume.triggerMinEnergy},
+            {"triggerMaxEnergy", sensitiveVolume.triggerMaxEnergy}});
+    }
+
+    metadata["terminationPolicies"] = json::array();
+    for (const TerminationPolicy& policy : fTerminationPolicies) {
+        json particleMinKineticEnergy = json::array();
+        for (const auto& particleEnergy : policy.particleMinKineticEnergy) {
+            particleMinKineticEnergy.push_back({particleEnergy.first, particleEnergy.second});
+        }
+        metadata["terminationPolicies"].push_back({
+            {"volumeName", policy.volumeName},
+            {"killOnEntry", policy.killOnEntry},
+            {"maxTime", policy.maxTime},
+            {"minKineticEnergy", policy.minKineticEnergy},
+            {"particleMinKineticEnergy", particleMinKineticEnergy}});
+    }
+
+    metadata["importances"] = json::array();
+    for (const VolumeImportance& volumeImportance : fVolumeImportances) {
+        metadata["importances"].push_back({
+            {"volumeName", volumeImportance.volumeName},
+            {"importance", volumeImportance.importance}});
+    }
+    metadata["importanceParticles"] = json::array();
+    for (const G4String& particle : fImportanceParticles) metadata["importanceParticles"].push_back(particle);
+
+    return metadata;
+}
+
+/**
+ * @brief Restores the volume maps and the settings of the geometry after it is loaded from the cache.
+ *
+ * @param metadata The metadata written by MakeCacheMetadata().
+ */
+void DetectorConstruction::RestoreCacheMetadata(const json& metadata) {
+    fWorldLogical = fWorldPhysical->GetLogicalVolume();
+    for (G4LogicalVolume* logicalVolume : *G4LogicalVolumeStore::GetInstance()) {
+        logicalVolumeMap[logicalVolume->GetName()] = logicalVolume;
+    }
+    for (G4VPhysicalVolume* physicalVolume : *G4PhysicalVolumeStore::GetInstance()) {
+        physicalVolumeMap[physicalVolume->GetName()] = physicalVolume;
+    }
+
+    fSensitiveVolumes.clear();
+    for (const auto& entry : metadata["sensitiveVolumes"]) {
+        fSensitiveVolumes.push_back({entry["volumeName"].get<std::string>(),
+                                     entry["collectionName"].get<std::string>(),
+                                     entry["spatialThreshold"].get<double>(),
+                                     entry["timeThreshold"].get<double>(),
+                                     entry["streamingClustering"].get<bool>(),
+                                     entry["hitStore"].get<bool>(),
+                                     entry["trigger"].get<bool>(),
+                                     entry["triggerMinEnergy"].get<double>(),
+                                     entry["triggerMaxEnergy"].get<double>()});
+    }
+
+    fTerminationPolicies.clear();
+    for (const auto& entry : metadata["terminationPolicies"]) {
+        TerminationPolicy policy;
+        policy.volumeName = entry["volumeName"].get<std::string>();
+        policy.logicalVolume = GetLogicalVolume(policy.volumeName);
+        policy.killOnEntry = entry["killOnEntry"].get<bool>();
+        policy.maxTime = entry["maxTime"].get<double>();
+        policy.minKineticEnergy = entry["minKineticEnergy"].get<double>();
+        for (const auto& particleEnergy : entry["particleMinKineticEnergy"]) {
+            policy.particleMinKineticEnergy.emplace_back(particleEnergy[0].get<std::string>(), particleEnergy[1].get<double>());
+        }
+        if (policy.logicalVolume) fTerminationPolicies.push_back(policy);
+    }
+
+    fVolumeImportances.clear();
+    fImportanceParticles.clear();
+    for (const auto& entry : metadata["importances"]) {
+        G4String volumeName = entry["volumeName"].get<std::string>();
+        G4LogicalVolume* logicalVolume = GetLogicalVolume(volumeName);
+        if (logicalVolume) fVolumeImportances.push_back({volumeName, logicalVolume, entry["importance"].get<double>()});
+    }
+    for (const auto& particle : metadata["importanceParticles"]) {
+        fImportanceParticles.push_back(particle.get<std::string>());
+    }
+}
+
 /**
  * @brief Sets the geometry file name.
  * 
@@ -106,6 +250,13 @@ void DetectorConstruction::LoadGeometryFromJson(const std::string& geoFileName)
 
     json geometryJson;
     inputFile >> geometryJson;
+    fNBooleanVolumes = 0;
+    fNFlattenedVolumes = 0;
+    // the settings of a previous geometry (/run/reinitializeGeometry) point at deleted volumes
+    fSensitiveVolumes.clear();
+    fTerminationPolicies.clear();
+    fVolumeImportances.clear();
+    fImportanceParticles.clear();
 
     // First construct the world volume
     G4Material* worldMaterial = G4Material::GetMaterial("G4_AIR");
@@ -116,6 +267,14 @@ void DetectorConstruction::LoadGeometryFromJson(const std::string& geoFileName)
 
     // Store the world volume in the logical volume map
     logicalVolumeMap["World"] = fWorldLogical;
+    SetTerminationPolicy(geometryJson["world"], fWorldLogical);
+
+    // Importance of the volumes for importance biasing. Volumes without an importance inherit it from their parent.
+    G4bool importanceBiasing = geometryJson["world"].contains("importance");
+    std::vector<VolumeImportance> importances;
+    std::map<G4String, G4double> importanceMap;
+    importanceMap["World"] = importanceBiasing ? geometryJson["world"]["importance"].get<double>() : 1.0;
+    importances.push_back({"World", fWorldLogical, importanceMap["World"]});
 
     // Now construct other volumes
     for (const auto& volume : geometryJson["volumes"]) {
@@ -125,14 +284,28 @@ void DetectorConstruction::LoadGeometryFromJson(const std::string& geoFileName)
         if (logVol) {
             logicalVolumeMap[volume["name"]] = logVol;  // Store logical volume
 
-            // If the volume is marked as active, make it a sensitive detector
+            G4String parentName = volume.contains("parent") ? volume["parent"].get<std::string>() : "World";
+            G4double importance = importanceMap.count(parentName) ? importanceMap[parentName] : 1.0;
+            if (volume.contains("importance")) {
+                importance = volume["importance"].get<double>();
+                importanceBiasing = true;
+            }
+            if (importance <= 0.) {
+                G4cerr << "DetectorConstruction::LoadGeometryFromJson: Error: importance of " << volume["name"].get<std::string>()
+                       << " must be positive" << G4endl;
+                exit(-1);
+            }
+            importanceMap[volume["name"].get<std::string>()] = importance;
+            importances.push_back({volume["name"].get<std::string>(), logVol, importance});
+
+            // If the volume is marked as active, register it for a sensitive detector. The detectors
+            // themselves are created per thread in ConstructSDandField.
             G4String name = volume["name"].get<std::string>();
             if (volume.contains("active") && volume["active"].get<bool>()) {
-                G4cout << "Making volume sensitive: " << name << G4endl;
-                MakeVolumeSensitive(name, name + "Collection");
-
                 G4double spatialThreshold = 10.0 * mm;  // default
                 G4double timeThreshold = 100.0 * ns;    // default
+                G4bool streaming = fStreamingClustering;
+                G4bool hitStore = fHitStore;
 
                 if (volume.contains("clustering")) {
                     if (volume["clustering"].contains("spatialThreshold")) {
@@ -141,10 +314,31 @@ void DetectorConstruction::LoadGeometryFromJson(const std::string& geoFileName)
                     if (volume["clustering"].contains("timeThreshold")) {
                         timeThreshold = volume["clustering"]["timeThreshold"].get<double>() * ns;
                     }
+                    if (volume["clustering"].contains("streaming")) {
+                        streaming = volume["clustering"]["streaming"].get<bool>();
+                    }
+                    if (volume["clustering"].contains("hitStore")) {
+                        hitStore = volume["clustering"]["hitStore"].get<bool>();
+                    }
+                }
+
+                // optional energy window of the event trigger, in keV
+                G4bool trigger = false;
+                G4double triggerMinEnergy = 0.;
+                G4double triggerMaxEnergy = 0.;
+                if (volume.contains("trigger")) {
+                    trigger = true;
+                    if (volume["trigger"].contains("minEnergy")) {
+                        triggerMinEnergy = volume["trigger"]["minEnergy"].get<double>() * keV;
+                    }
+                    if (volume["trigger"].contains("maxEnergy")) {
+                        triggerMaxEnergy = volume["trigger"]["maxEnergy"].get<double>() * keV;
+                    }
                 }
 
-                // Store the thresholds in the map
-                fClusteringParameters[name] = std::make_pair(spatialThreshold, timeThreshold);
+                G4cout << "Registering sensitive volume: " << name << G4endl;
+                fSensitiveVolumes.push_back({name, name + "Collection", spatialThreshold, timeThreshold, streaming, hitStore,
+                                             trigger, triggerMinEnergy, triggerMaxEnergy});
             }
         
             // create the Physical Volume
@@ -154,35 +348,61 @@ void DetectorConstruction::LoadGeometryFromJson(const std::string& geoFileName)
         }
     }
 
-    G4cout << "Setting clustering parameters in EventAction." << G4endl;
-    EventAction::SetClusteringParameters(fClusteringParameters);
+    if (fNBooleanVolumes > 0) {
+        G4cout << "DetectorConstruction::LoadGeometryFromJson: " << fNFlattenedVolumes << " of " << fNBooleanVolumes
+               << " boolean volumes replaced by polycones" << G4endl;
+    }
+
+    if (importanceBiasing) {
+        fVolumeImportances = importances;
+        fImportanceParticles = {"gamma"};
+        if (geometryJson.contains("importanceParticles")) {
+            fImportanceParticles.clear();
+            for (const auto& particle : geometryJson["importanceParticles"]) {
+                fImportanceParticles.push_back(particle.get<std::string>());
+            }
+        }
+        for (const auto& volumeImportance : fVolumeImportances) {
+            G4cout << "DetectorConstruction::LoadGeometryFromJson: importance of " << volumeImportance.volumeName
+                   << " = " << volumeImportance.importance << G4endl;
+        }
+    }
+}
+
+/**
+ * @brief Constructs the sensitive detectors.
+ *
+ * Geant4 calls this function on every worker thread (and on the master in sequential mode), so each
+ * thread gets its own SensitiveDetector instances for the active volumes found in the geometry file.
+ */
+void DetectorConstruction::ConstructSDandField()
+{
+    for (const auto& sensitiveVolume : fSensitiveVolumes) {
+        G4cout << "Making volume sensitive: " << sensitiveVolume.volumeName << G4endl;
+        MakeVolumeSensitive(sensitiveVolume);
+    }
 }
 
 /**
  * Makes a volume sensitive by assigning a sensitive detector to it.
  * 
- * @param volumeName The name of the volume to make sensitive.
- * @param collectionName The name of the collection associated with the sensitive detector.
+ * @param sensitiveVolume The readout settings of the volume: its name, the name of the hits collection and
+ *                        the clustering mode of the sensitive detector.
  */
-void DetectorConstruction::MakeVolumeSensitive(const G4String& volumeName, const G4String& collectionName) {
-    G4SDManager* sdManager = G4SDManager::GetSDMpointer();
-
-    // Create a new sensitive detector
-    auto* sensitiveDetector = new G4Sim::SensitiveDetector(volumeName, collectionName);
-    sdManager->AddNewDetector(sensitiveDetector);
-
-    // Assign the sensitive detector to the corresponding logical volume
+void DetectorConstruction::MakeVolumeSensitive(const SensitiveVolume& sensitiveVolume) {
+    const G4String& volumeName = sensitiveVolume.volumeName;
+    // Assign a new sensitive detector to the corresponding logical volume
     G4LogicalVolume* logicalVolume = GetLogicalVolume(volumeName);
     if (logicalVolume) {
-        logicalVolume->SetSensitiveDetector(sensitiveDetector);
-        G4cout << "Assigned sensitive detector to volume: " << volumeName << G4endl;
-
-        // Register the hits collection name with EventAction
-        auto* eventAction = const_cast<EventAction*>(dynamic_cast<const EventAction*>(G4RunManager::GetRunManager()->GetUserEventAction()));
-
-        if (eventAction) {
-            eventAction->AddHitsCollectionName(collectionName);
+        auto* sensitiveDetector = new G4Sim::SensitiveDetector(volumeName, sensitiveVolume.collectionName);
+        if (sensitiveVolume.streamingClustering) {
+            sensitiveDetector->SetStreamingClustering(sensitiveVolume.spatialThreshold, sensitiveVolume.timeThreshold);
+        } else if (sensitiveVolume.hitStore) {
+            sensitiveDetector->SetHitStore(true);
         }
+        G4SDManager::GetSDMpointer()->AddNewDetector(sensitiveDetector);
+        SetSensitiveDetector(logicalVolume, sensitiveDetector);
+        G4cout << "Assigned sensitive detector to volume: " << volumeName << G4endl;
     } else {
         G4cerr << "Error: Logical volume " << volumeName << " not found!" << G4endl;
     }
@@ -222,7 +442,7 @@ G4LogicalVolume* DetectorConstruction::ConstructVolume(const json& volumeDef) {
                 unionSolid = new G4UnionSolid(name, unionSolid, solid, rotation, position);
             }
         }
-        logicalVolume = new G4LogicalVolume(unionSolid, material, name);
+        logicalVolume = new G4LogicalVolume(FlattenSolid(volumeDef, unionSolid), material, name);
     // if shape is 'subtraction'
     } else if (volumeDef["shape"].get<std::string>() == "subtraction"){
         G4VSolid* subtractionSolid = nullptr;
@@ -242,7 +462,7 @@ G4LogicalVolume* DetectorConstruction::ConstructVolume(const json& volumeDef) {
                 subtractionSolid = new G4SubtractionSolid(name, subtractionSolid, solid, rotation, position);
             }
         }
-        logicalVolume = new G4LogicalVolume(subtractionSolid, material, name);	
+        logicalVolume = new G4LogicalVolume(FlattenSolid(volumeDef, subtractionSolid), material, name);
     // if shape is 'tubs' or 'box'
     } else {
         G4VSolid* solid = CreateSolid(volumeDef);
@@ -251,10 +471,147 @@ G4LogicalVolume* DetectorConstruction::ConstructVolume(const json& volumeDef) {
 
     // Set the attributes of the logical volume, like visibility, color, transparency, etc.
     SetAttributes(volumeDef, logicalVolume);
+    // Kill conditions for tracks in the volume
+    SetTerminationPolicy(volumeDef, logicalVolume);
  
     return logicalVolume;
 }
 
+/**
+ * @brief Replaces a union or subtraction of coaxial, unrotated tubs by a polycone with the same shape.
+ *
+ * All components must be tubs with the same phi range. The placement of the first component is ignored, as in
+ * ConstructVolume(); the others must be on its axis (x = y = 0) and not rotated. The polycone is compared with the
+ * boolean solid at random points and only used if they agree everywhere. Every boolean volume is reported, with
+ * the reason when it is kept.
+ *
+ * @param volumeDef The JSON object containing the volume definition.
+ * @param booleanSolid The boolean solid made from the components.
+ * @return The polycone, or the boolean solid if it cannot be replaced.
+ */
+G4VSolid* DetectorConstruction::FlattenSolid(const json& volumeDef, G4VSolid* booleanSolid) {
+    const G4int nCheckPoints = 100000;
+    G4String name = volumeDef["name"].get<std::string>();
+    G4String shape = volumeDef["shape"].get<std::string>();
+    fNBooleanVolumes++;
+    if (!fFlattenBooleans || (volumeDef.contains("flatten") && !volumeDef["flatten"].get<bool>())) return booleanSolid;
+
+    const json& components = volumeDef["components"];
+    G4String reason;
+    G4double startPhi = 0.;
+    G4double deltaPhi = 0.;
+    for (size_t k = 0; k < components.size() && reason.empty(); ++k) {
+        const json& component = components[k];
+        if (component["shape"].get<std::string>() != "tubs") {
+            reason = "component " + std::to_string(k) + " is not a tubs";
+            break;
+        }
+        G4double componentStartPhi = component["dimensions"]["startAngle"].get<double>() * deg;
+        G4double componentDeltaPhi = component["dimensions"]["spanningAngle"].get<double>() * deg;
+        if (k == 0) {
+            startPhi = componentStartPhi;
+            deltaPhi = componentDeltaPhi;
+        } else if (std::abs(componentStartPhi - startPhi) > 1e-9 || std::abs(componentDeltaPhi - deltaPhi) > 1e-9) {
+            reason = "component " + std::to_string(k) + " has another phi range";
+        }
+        if (k == 0) continue;
+        G4RotationMatrix* rotation = GetRotationMatrix(component);
+        if (rotation && !rotation->isIdentity()) reason = "component " + std::to_string(k) + " is rotated";
+        delete rotation;
+        if (std::abs(component["placement"]["x"].get<double>()) > SolidFlattener::kTolerance ||
+            std::abs(component["placement"]["y"].get<double>()) > SolidFlattener::kTolerance) {
+            reason = "component " + std::to_string(k) + " is not on the axis";
+        }
+    }
+
+    SolidFlattener flattener(startPhi, deltaPhi);
+    G4VSolid* solid = nullptr;
+    if (reason.empty()) {
+        for (size_t k = 0; k < components.size(); ++k) {
+            const json& component = components[k];
+            G4double rMin = component["dimensions"]["rMin"].get<double>() * mm;
+            G4double rMax = component["dimensions"]["rMax"].get<double>() * mm;
+            G4double halfZ = component["dimensions"]["z"].get<double>() * mm / 2;
+            G4double z = k == 0 ? 0. : component["placement"]["z"].get<double>() * mm;
+            flattener.Add(rMin, rMax, z - halfZ, z + halfZ, shape == "subtraction" && k > 0);
+        }
+        solid = flattener.Build(name);
+        if (!solid) reason = flattener.GetDescription();
+    }
+    if (!solid) {
+        G4cout << "DetectorConstruction::FlattenSolid: " << name << ": " << shape << " kept, " << reason << G4endl;
+        return booleanSolid;
+    }
+
+    if (!flattener.Check(solid, booleanSolid, nCheckPoints)) {
+        G4ExceptionDescription msg;
+        msg << "The " << flattener.GetDescription() << " of " << name << " differs from the " << shape << " at "
+            << flattener.GetMismatches() << " of " << nCheckPoints << " test points, the " << shape << " is kept." << G4endl;
+        G4Exception("DetectorConstruction::FlattenSolid()", "Geometry0001", JustWarning, msg);
+        delete solid;
+        return booleanSolid;
+    }
+
+    fNFlattenedVolumes++;
+    G4cout << "DetectorConstruction::FlattenSolid: " << name << ": " << shape << " of " << components.size()
+           << " tubs replaced by a " << flattener.GetDescription() << ", volume " << flattener.GetVolume() / cm3
+           << " cm3, 0 of " << nCheckPoints << " test points differ" << G4endl;
+    return solid;
+}
+
+/**
+ * @brief Registers the termination policy of a volume, if the JSON definition has one.
+ *
+ * The "termination" entry of a volume can contain:
+ * - "killOnEntry": kill every track that enters the volume or is created in it.
+ * - "minKineticEnergy": kill tracks below this kinetic energy (keV). Either a number for all particles, or an
+ *   object with the energy per particle name, where "default" applies to the other particles.
+ * - "maxTime": kill tracks with a later global time (ns).
+ *
+ * The policies are applied by the SteppingAction. Energy that a killed track still carries is not deposited, and
+ * killed positrons do not annihilate, so policies are meant for passive volumes.
+ *
+ * @param volumeDef The JSON object containing the volume definition.
+ * @param logicalVolume The logical volume.
+ */
+void DetectorConstruction::SetTerminationPolicy(const json& volumeDef, G4LogicalVolume* logicalVolume) {
+    if (!volumeDef.contains("termination")) return;
+    const json& terminationDef = volumeDef["termination"];
+
+    TerminationPolicy policy;
+    policy.volumeName = logicalVolume->GetName();
+    policy.logicalVolume = logicalVolume;
+    policy.killOnEntry = terminationDef.contains("killOnEntry") && terminationDef["killOnEntry"].get<bool>();
+    policy.maxTime = 0.;
+    if (terminationDef.contains("maxTime")) {
+        policy.maxTime = terminationDef["maxTime"].get<double>() * ns;
+    }
+    policy.minKineticEnergy = 0.;
+    if (terminationDef.contains("minKineticEnergy")) {
+        const json& energyDef = terminationDef["minKineticEnergy"];
+        if (energyDef.is_number()) {
+            policy.minKineticEnergy = energyDef.get<double>() * keV;
+        } else {
+            for (const auto& item : energyDef.items()) {
+                if (item.key() == "default") {
+                    policy.minKineticEnergy = item.value().get<double>() * keV;
+                } else {
+                    policy.particleMinKineticEnergy.emplace_back(item.key(), item.value().get<double>() * keV);
+                }
+            }
+        }
+    }
+
+    if (volumeDef.contains("active") && volumeDef["active"].get<bool>()) {
+        G4cerr << "DetectorConstruction::SetTerminationPolicy: Warning: " << policy.volumeName
+               << " is active, killed tracks do not deposit their remaining energy" << G4endl;
+    }
+
+    G4cout << "DetectorConstruction::SetTerminationPolicy: " << policy.volumeName << " killOnEntry = " << policy.killOnEntry
+           << " maxTime = " << policy.maxTime / ns << " ns minKineticEnergy = " << policy.minKineticEnergy / keV << " keV" << G4endl;
+    fTerminationPolicies.push_back(policy);
+}
+
 /**
  * @brief Sets the attributes of a given logical volume based on the provided JSON definition.
  *
@@ -31,12 +31,40 @@ DetectorConstructionMessenger::DetectorConstructionMessenger(DetectorConstructio
     fMaterialFileNameCmd->SetGuidance("Set the material JSON file name.");
     fMaterialFileNameCmd->SetParameterName("matFileName", false);
     fMaterialFileNameCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    fStreamingClusteringCmd = new G4UIcmdWithABool("/detector/streamingClustering", this);
+    fStreamingClusteringCmd->SetGuidance("Cluster deposits in the sensitive detectors while tracking, instead of storing all hits.");
+    fStreamingClusteringCmd->SetGuidance("Applies to active volumes without a 'streaming' entry in their clustering settings.");
+    fStreamingClusteringCmd->SetParameterName("streaming", false);
+    fStreamingClusteringCmd->AvailableForStates(G4State_PreInit);
+
+    fHitStoreCmd = new G4UIcmdWithABool("/detector/useHitStore", this);
+    fHitStoreCmd->SetGuidance("Store the hits of the sensitive detectors in per-property arrays instead of a hits collection.");
+    fHitStoreCmd->SetGuidance("Applies to active volumes without a 'hitStore' entry in their clustering settings.");
+    fHitStoreCmd->SetParameterName("hitStore", false);
+    fHitStoreCmd->AvailableForStates(G4State_PreInit);
+
+    fGeometryCacheCmd = new G4UIcmdWithAString("/detector/geometryCache", this);
+    fGeometryCacheCmd->SetGuidance("Store the constructed geometry in this directory (GDML plus metadata), keyed by a hash");
+    fGeometryCacheCmd->SetGuidance("of the geometry and material files, and load it from there in later jobs.");
+    fGeometryCacheCmd->SetParameterName("directory", false);
+    fGeometryCacheCmd->AvailableForStates(G4State_PreInit);
+
+    fFlattenBooleansCmd = new G4UIcmdWithABool("/detector/flattenBooleans", this);
+    fFlattenBooleansCmd->SetGuidance("Replace unions and subtractions of coaxial, unrotated tubs by an equivalent polycone (default true).");
+    fFlattenBooleansCmd->SetGuidance("Volumes with \"flatten\": false in the geometry file are always kept as they are.");
+    fFlattenBooleansCmd->SetParameterName("flatten", false);
+    fFlattenBooleansCmd->AvailableForStates(G4State_PreInit);
 }
 
 
 DetectorConstructionMessenger::~DetectorConstructionMessenger() {
     delete fGeometryFileNameCmd;
     delete fMaterialFileNameCmd;
+    delete fStreamingClusteringCmd;
+    delete fHitStoreCmd;
+    delete fGeometryCacheCmd;
+    delete fFlattenBooleansCmd;
 }
 
 /**
@@ -54,6 +82,14 @@ void DetectorConstructionMessenger::SetNewValue(G4UIcommand* command, G4String n
         fDetectorConstruction->SetGeometryFileName(newValue);
     } else if (command == fMaterialFileNameCmd) {
         fDetectorConstruction->SetMaterialFileName(newValue);
+    } else if (command == fStreamingClusteringCmd) {
+        fDetectorConstruction->SetStreamingClustering(fStreamingClusteringCmd->GetNewBoolValue(newValue));
+    } else if (command == fHitStoreCmd) {
+        fDetectorConstruction->SetHitStore(fHitStoreCmd->GetNewBoolValue(newValue));
+    } else if (command == fGeometryCacheCmd) {
+        fDetectorConstruction->SetGeometryCacheDirectory(newValue);
+    } else if (command == fFlattenBooleansCmd) {
+        fDetectorConstruction->SetFlattenBooleans(fFlattenBooleansCmd->GetNewBoolValue(newValue));
     }
 }
 
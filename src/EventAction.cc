@@ -1,6 +1,8 @@
 #include "EventAction.hh"
 #include "EventActionMessenger.hh"	
 #include "RunAction.hh"
+#include "DetectorConstruction.hh"
+#include "SensitiveDetector.hh"
 
 #include "G4Event.hh"
 #include "G4RunManager.hh"
@@ -13,6 +15,12 @@
 #include "G4SDManager.hh"
 #include "Hit.hh"
 #include "G4SystemOfUnits.hh"
+#include "G4EmProcessSubType.hh"
+#include "G4Threading.hh"
+#include "EventPipeline.hh"
+#include "EventSeeder.hh"
+
+#include <cmath>
 
 
 /**
@@ -21,40 +29,87 @@
 /*/
 namespace G4Sim {
 
-//std::mutex EventAction::mtx;
-
-EventAction::EventAction() : G4UserEventAction(),
+EventAction::EventAction(const DetectorConstruction* detector) : G4UserEventAction(),
       fSpatialThreshold(2.5 * cm),  // Default values
-      fTimeThreshold(5.0 * ns)
+      fTimeThreshold(5.0 * ns),
+      fDetector(detector)
 {
   // set printing per each event
   G4RunManager::GetRunManager()->SetPrintProgress(1);
 
+  // the EventAction is constructed on the thread that uses it
+  fTimers = PhaseTimers::Instance();
+  fSummary = RunSummary::Create();
+
   fMessenger = new EventActionMessenger(this);
 }
 
 EventAction::~EventAction() {
+  delete fPipeline;
   delete fMessenger;
 }
 
 
 /**
- * @brief Adds a hits collection name to the EventAction.
- * 
- * This function adds the specified hits collection name to the EventAction's list of hits collection names.
- * 
- * @param name The name of the hits collection to be added.
+ * @brief Builds the readout plan of this thread from the sensitive volumes of the detector construction.
+ *
+ * This function is called at the beginning of each run by the RunAction of the same thread, after the sensitive
+ * detectors of the thread have been constructed. For every active volume it resolves the hits collection ID or the
+ * sensitive detector, and copies the clustering thresholds. The list of sensitive volumes is only read, so all
+ * threads can configure themselves from the shared DetectorConstruction.
+ *
+ * Volumes without a hits collection or sensitive detector on this thread (e.g. on the master of a multithreaded
+ * run) keep their output slot but are skipped at the end of each event.
  */
-void EventAction::AddHitsCollectionName(const G4String& name) {
-    G4cout << "EventAction::AddHitsCollectionName: " << name << G4endl;
-    fHitsCollectionNames.push_back(name);
+void EventAction::ConfigureReadout() {
+    fReadoutPlan.clear();
+    if (!fDetector) return;
+
+    G4SDManager* sdManager = G4SDManager::GetSDMpointer();
+    const auto& sensitiveVolumes = fDetector->GetSensitiveVolumes();
+    for (size_t i = 0; i < sensitiveVolumes.size(); ++i) {
+        const SensitiveVolume& sensitiveVolume = sensitiveVolumes[i];
+
+        ReadoutEntry entry;
+        entry.collectionName = sensitiveVolume.collectionName;
+        entry.mode = kNoReadout;
+        entry.hcID = -1;
+        entry.sensitiveDetector = dynamic_cast<const SensitiveDetector*>(
+            sdManager->FindSensitiveDetector(sensitiveVolume.volumeName, false));
+        entry.spatialThreshold = sensitiveVolume.spatialThreshold;
+        entry.timeThreshold = sensitiveVolume.timeThreshold;
+        entry.detectorIndex = static_cast<G4int>(i);
+        entry.outputSlot = i;
+
+        if (entry.sensitiveDetector) {
+            if (entry.sensitiveDetector->IsStreamingClustering()) {
+                entry.mode = kStreaming;
+            } else if (entry.sensitiveDetector->UsesHitStore()) {
+                entry.mode = kHitStore;
+            } else {
+                entry.hcID = sdManager->GetCollectionID(sensitiveVolume.collectionName);
+                if (entry.hcID >= 0) entry.mode = kHitsCollection;
+            }
+        }
+
+        G4cout << "EventAction::ConfigureReadout: " << entry.collectionName << " slot = " << entry.outputSlot
+               << " mode = " << entry.mode << G4endl;
+        fReadoutPlan.push_back(entry);
+    }
+
+    fTrigger.Configure(sensitiveVolumes);
+
+    std::vector<G4String> collectionNames;
+    for (const ReadoutEntry& entry : fReadoutPlan) collectionNames.push_back(entry.collectionName);
+    fSummary->Book(collectionNames);
 }
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 /**
  * @brief This function is called at the beginning of each event.
  * 
- * It resets variables and retrieves information about the primary vertex of the event.
+ * It resets variables and retrieves information about the primary vertex of the event, including the weight of
+ * the primary.
  * 
  * @param event Pointer to the G4Event object representing the current event.
  */
@@ -63,11 +118,15 @@ void EventAction::BeginOfEventAction(const G4Event* event)
   if (verbosityLevel > 0)
     G4cout << "EventAction::BeginOfEventAction..... NEXT" << G4endl;	
 
+  fTimers->BeginEvent();
+
   // Reset variables
   ResetVariables();
 
   //G4cout<<"EventAction::BeginOfEventAction next event...."<<G4endl;
   G4PrimaryVertex* primaryVertex = event->GetPrimaryVertex();
+  if (!primaryVertex) return;  // a replayed phase space that ran out of events
+  fLogWeight = std::log(primaryVertex->GetWeight() * primaryVertex->GetPrimary()->GetWeight());
   fXp = primaryVertex->GetPosition().x();
   fYp = primaryVertex->GetPosition().y();
   fZp = primaryVertex->GetPosition().z();
@@ -99,14 +158,28 @@ void EventAction::BeginOfEventAction(const G4Event* event)
  * - fY: Vector of Y positions.
  * - fZ: Vector of Z positions.
  * - fW: Vector of weights.
+ * - fTriggered: Trigger flag of the event.
+ *
+ * The per cluster and per detector vectors are cleared by ClearOutput() when the event is analyzed, because with
+ * the pipeline they belong to the consumer thread.
  */
 void EventAction::ResetVariables() {
   fLogWeight = 0.0;
+  fLogTriggerWeight = 0.0;
   fEventType = 0;
   fXp = 0.0;
   fYp = 0.0;
   fZp = 0.0;
+  fTriggered = 1;
+}
 
+/**
+ * @brief Clears the per cluster output vectors, and resets the per detector vectors.
+ *
+ * In the dense layout the per detector vectors get one zero slot per active volume, in the sparse layout they are
+ * emptied. nphot and ncomp are not used in the sparse layout.
+ */
+void EventAction::ClearOutput() {
   // cluster information
   fE.clear();
   fX.clear();
@@ -115,11 +188,16 @@ void EventAction::ResetVariables() {
   fW.clear();
   fID.clear();
   // detector information
-  fEdet.clear();
-  fNdet.clear();
-  fNphot.clear();
-  fNcomp.clear();
-
+  if (fSparseLayout) {
+    fDet.clear();
+    fEdet.clear();
+    fNdet.clear();
+    return;
+  }
+  fEdet.assign(fReadoutPlan.size(), 0.);
+  fNdet.assign(fReadoutPlan.size(), 0);
+  fNphot.assign(fReadoutPlan.size(), 0);
+  fNcomp.assign(fReadoutPlan.size(), 0);
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -128,68 +206,245 @@ void EventAction::ResetVariables() {
  * @brief This function is called at the end of each event in the simulation.
  * It analyzes the hits and clusters, fills the analysis manager's ntuple with relevant data,
  * and updates the event ID and other variables.
+ *
+ * With the pipeline the event is only copied into an EventRecord here. Clustering and output then happen on the
+ * consumer thread in ProcessRecord(), while this thread continues with the next event.
  * 
  * @param event Pointer to the current G4Event object.
  */
 void EventAction::EndOfEventAction(const G4Event* event)
 {
+  const G4Event* currentEvent = G4EventManager::GetEventManager()->GetConstCurrentEvent();
+  fEventID = EventSeeder::Instance()->GetEventNumber(currentEvent->GetEventID());
+
+  if (event->IsAborted()) {
+    fTimers->EndEvent();
+    return;
+  }
+
+  // the trigger uses the raw energy per volume, so rejected events are never clustered
+  EventTrigger::Decision decision = ApplyTrigger();
+  if (decision == EventTrigger::kReject) {
+    fTimers->EndEvent();
+    return;
+  }
+  if (decision == EventTrigger::kPrescaled) {
+    fLogTriggerWeight = std::log(static_cast<G4double>(fTrigger.GetPrescale()));
+    fLogWeight += fLogTriggerWeight;
+    fTriggered = 0;
+  }
+
+  if (fPipeline && fPipeline->IsRunning()) {
+    if(verbosityLevel>0) G4cout << "EventAction::EndOfEventAction..... Hand event to the pipeline...." << G4endl;
+    FillRecord(event, fPipeline->NextRecord());
+    fPipeline->Commit();
+    fTimers->EndEvent();
+    return;
+  }
+
   if(verbosityLevel>0) G4cout << "EventAction::EndOfEventAction..... Analyze hits and cluster...." << G4endl;
-  AnalyzeHits(event);
+  {
+    PhaseTimer timer(fTimers, PhaseTimers::kClustering);
+    AnalyzeHits(event);
+  }
 
-  const G4Event* currentEvent = G4EventManager::GetEventManager()->GetConstCurrentEvent();
-  fEventID = currentEvent->GetEventID();
-  
   if(verbosityLevel<0) G4cout << "EventAction::EndOfEventAction..... Fill ntuple...." << G4endl;
-  // Get analysis manager
-  auto analysisManager = G4AnalysisManager::Instance();
-  //std::lock_guard<std::mutex> lock(mtx);
-  
-  // get the energy depositis in keV
-  analysisManager->FillNtupleDColumn(0, 0, fEventID);
-  analysisManager->FillNtupleDColumn(0, 1, fLogWeight);
-  analysisManager->FillNtupleDColumn(0, 2, fEventType);
-  analysisManager->FillNtupleDColumn(0, 3, fXp);
-  analysisManager->FillNtupleDColumn(0, 4, fYp);
-  analysisManager->FillNtupleDColumn(0, 5, fZp);
-
-  analysisManager->AddNtupleRow(0);
+  {
+    PhaseTimer timer(fTimers, PhaseTimers::kOutput);
+    WriteRow(fEventID, fLogWeight, fEventType, fXp, fYp, fZp, fTriggered);
+  }
 
+  fTimers->EndEvent();
   if(verbosityLevel>0) G4cout << "EventAction::EndOfEventAction: Done...." << G4endl;	
 
 }
 
-G4double EventAction::CalculateDistance(const G4ThreeVector& pos1, const G4ThreeVector& pos2) {
-    return (pos1 - pos2).mag();
+/**
+ * @brief Applies the trigger to the raw energy deposit of every active volume in the current event.
+ *
+ * The sensitive detectors sum the energy of all their steps, in every readout mode. Volumes without a sensitive
+ * detector on this thread count as zero energy.
+ *
+ * @return The decision of the trigger.
+ */
+EventTrigger::Decision EventAction::ApplyTrigger() {
+  if (!fTrigger.IsActive()) return EventTrigger::kAccept;
+
+  fTriggerEnergies.assign(fReadoutPlan.size(), 0.);
+  for (const ReadoutEntry& entry : fReadoutPlan) {
+    if (entry.sensitiveDetector) fTriggerEnergies[entry.outputSlot] = entry.sensitiveDetector->GetTotalEnergyDeposit();
+  }
+  return fTrigger.Evaluate(fTriggerEnergies);
 }
 
-//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+/**
+ * @brief Fills the run summary, then fills the event level columns and adds the row to the output.
+ */
+void EventAction::WriteRow(G4int eventID, G4double logWeight, G4int eventType, G4double xp, G4double yp, G4double zp,
+                           G4int trigger) {
+  fSummary->Fill({logWeight, xp, yp, zp, &fE, &fX, &fY, &fZ, &fW, &fID, fSparseLayout ? &fDet : nullptr, &fEdet,
+                  &fNdet, fSparseLayout ? nullptr : &fNphot, fSparseLayout ? nullptr : &fNcomp});
 
-G4double EventAction::CalculateTimeDifference(G4double time1, G4double time2) {
-    return std::fabs(time1 - time2);
+  // the master of a multithreaded run may have no output, and a spectrum-only run has none at all
+  if (!fOutput) return;
+
+  // get the energy depositis in keV
+  fOutput->FillDColumn(0, eventID);
+  fOutput->FillDColumn(1, logWeight);
+  fOutput->FillDColumn(2, eventType);
+  fOutput->FillDColumn(3, xp);
+  fOutput->FillDColumn(4, yp);
+  fOutput->FillDColumn(5, zp);
+  fOutput->FillDColumn(6, trigger);
+
+  fOutput->AddRow();
 }
 
-//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+/**
+ * @brief Starts the pipeline for this run, if it is enabled and the output allows it.
+ *
+ * The consumer thread writes to the output, so the G4AnalysisManager, which only works on the thread that owns
+ * it, cannot be used with the pipeline. In that case the events are processed synchronously. The master of a
+ * multithreaded run processes no events and does not start a pipeline.
+ */
+void EventAction::StartPipeline() {
+  if (!fUsePipeline) return;
+  if (G4Threading::IsMultithreadedApplication() && G4Threading::IsMasterThread()) return;
+  if (fOutput && fOutput->IsThreadLocal()) {
+    G4ExceptionDescription msg;
+    msg << "The event pipeline requires the columnar output, events are processed synchronously." << G4endl;
+    G4Exception("EventAction::StartPipeline()", "MyCode0002", JustWarning, msg);
+    return;
+  }
+
+  if (!fConsumerTimers) fConsumerTimers = PhaseTimers::Create("pipeline " + std::to_string(G4Threading::G4GetThreadId()));
+  if (!fPipeline) {
+    fPipeline = new EventPipeline(fPipelineBatchSize, [this](const EventRecord& record) { ProcessRecord(record); });
+  }
+  fPipeline->Start();
+}
+
+/**
+ * @brief Processes all events that are still in the pipeline and stops its thread.
+ *
+ * Must be called before the output is written at the end of the run.
+ */
+void EventAction::StopPipeline() {
+  if (fPipeline) fPipeline->Stop();
+}
+
+/**
+ * @brief Copies the event into a record for the pipeline.
+ *
+ * For every entry of the readout plan the deposits needed for clustering are copied from the hits collection or
+ * the hit store. Detectors in streaming clustering mode contribute their clusters.
+ *
+ * @param event The current event.
+ * @param record The record to fill.
+ */
+void EventAction::FillRecord(const G4Event* event, EventRecord& record) {
+  record.Clear(fReadoutPlan.size());
+  record.eventID = fEventID;
+  record.logWeight = fLogWeight;
+  record.logTriggerWeight = fLogTriggerWeight;
+  record.eventType = fEventType;
+  record.xp = fXp;
+  record.yp = fYp;
+  record.zp = fZp;
+  record.trigger = fTriggered;
+
+  G4HCofThisEvent* HCE = event->GetHCofThisEvent();
+  for (size_t i = 0; i < fReadoutPlan.size(); ++i) {
+    const ReadoutEntry& entry = fReadoutPlan[i];
+    switch (entry.mode) {
+      case kStreaming:
+        record.clusters[i] = entry.sensitiveDetector->GetClusters();
+        break;
+
+      case kHitStore: {
+        const HitStore& hitStore = entry.sensitiveDetector->GetHitStore();
+        for (size_t j = 0; j < hitStore.GetSize(); ++j) {
+          record.AddDeposit(hitStore.GetX()[j], hitStore.GetY()[j], hitStore.GetZ()[j], hitStore.GetTime()[j],
+                            hitStore.GetEnergyDeposit()[j], hitStore.GetProcessID()[j], hitStore.GetWeight()[j]);
+        }
+        break;
+      }
+
+      case kHitsCollection: {
+        auto* hitsCollection = HCE ? static_cast<HitsCollection*>(HCE->GetHC(entry.hcID)) : nullptr;
+        if (!hitsCollection) break;
+        for (const Hit* hit : *hitsCollection->GetVector()) {
+          record.AddDeposit(hit->position.x(), hit->position.y(), hit->position.z(), hit->time,
+                            hit->energyDeposit, hit->processID, hit->weight);
+        }
+        break;
+      }
+
+      case kNoReadout:
+        break;
+    }
+    record.EndEntry();
+  }
+}
+
+/**
+ * @brief Clusters the deposits of a record and writes the event to the output.
+ *
+ * Runs on the consumer thread of the pipeline. It uses the clustering engine and output vectors of this
+ * EventAction, which the tracking thread does not touch while the pipeline is running.
+ *
+ * @param record The record of the event.
+ */
+void EventAction::ProcessRecord(const EventRecord& record) {
+  // the consumer thread is new in every run, its timers are kept by this EventAction
+  PhaseTimers* timers = PhaseTimers::IsEnabled() ? fConsumerTimers : nullptr;
+
+  {
+    PhaseTimer clusteringTimer(timers, PhaseTimers::kClustering);
+    ClearOutput();
+
+    for (size_t i = 0; i < fReadoutPlan.size(); ++i) {
+      const ReadoutEntry& entry = fReadoutPlan[i];
+      if (entry.mode == kStreaming) {
+        FillClusters(record.clusters[i], entry, record.logTriggerWeight);
+        continue;
+      }
+
+      size_t begin = record.depositBegin[i];
+      size_t nDeposits = record.depositBegin[i + 1] - begin;
+      fClusters.clear();
+      ClusterDeposits(nDeposits, record.x.data() + begin, record.y.data() + begin, record.z.data() + begin,
+                      record.time.data() + begin, record.energyDeposit.data() + begin, record.processID.data() + begin,
+                      record.weight.data() + begin, entry.spatialThreshold, entry.timeThreshold, fClusters,
+                      entry.detectorIndex);
+      FillClusters(fClusters, entry, record.logTriggerWeight);
+    }
+  }
+
+  {
+    PhaseTimer outputTimer(timers, PhaseTimers::kOutput);
+    WriteRow(record.eventID, record.logWeight, record.eventType, record.xp, record.yp, record.zp, record.trigger);
+  }
+  if (timers) timers->EndEvent();
+}
 
 /**
  * @brief Analyzes the hits in the given event and clusters them based on spatial and time thresholds.
  * 
- * This function retrieves the hits collections from the event, processes each collection to extract hits,
- * and then clusters these hits using predefined spatial and time thresholds. The resulting clusters are
- * stored in a vector for further analysis or output.
+ * The function walks through the readout plan that was built at the start of the run. For each entry the hits
+ * are taken from the hits collection of the event, from the HitStore of the sensitive detector, or, for detectors
+ * in streaming clustering mode, the clusters made during tracking are taken directly. The clusters are written
+ * into the per cluster vectors, and the per detector sums into the output slot of the entry.
  * 
- * @param event Pointer to the G4Event object containing the hits to be analyzed.
+ * All buffers keep their capacity between events, so after the first events no memory is allocated here.
  * 
- * The function performs the following steps:
- * 1. Retrieves the hits collections from the event.
- * 2. Iterates over each hits collection specified in `fHitsCollectionNames`.
- * 3. For each collection, retrieves the hits and stores them in a temporary vector.
- * 4. Retrieves the spatial and time thresholds for clustering from a configuration file or predefined map.
- * 5. Clusters the hits based on the retrieved thresholds.
- * 6. Merges the clusters from all collections into a single vector `allClusters`.
+ * @param event Pointer to the G4Event object containing the hits to be analyzed.
  * 
  * If no hits collection is found for the event, a warning is issued.
  */
 void EventAction::AnalyzeHits(const G4Event* event) {
+    ClearOutput();
+
     G4HCofThisEvent* HCE = event->GetHCofThisEvent();
     if (!HCE) {
         G4ExceptionDescription msg;
@@ -198,59 +453,77 @@ void EventAction::AnalyzeHits(const G4Event* event) {
         return;
     }
 
-    std::vector<Cluster> allClusters;
+    for (const ReadoutEntry& entry : fReadoutPlan) {
+        switch (entry.mode) {
+            case kStreaming:
+                // Clusters were made while tracking.
+                FillClusters(entry.sensitiveDetector->GetClusters(), entry, fLogTriggerWeight);
+                break;
+
+            case kHitStore: {
+                const HitStore& hitStore = entry.sensitiveDetector->GetHitStore();
+                if (verbosityLevel > 0) G4cout << "Hit store: " << entry.collectionName << " has " << hitStore.GetSize() << " hits." << G4endl;
+
+                fClusters.clear();
+                ClusterHits(hitStore, entry.spatialThreshold, entry.timeThreshold, fClusters, entry.detectorIndex);
+                FillClusters(fClusters, entry, fLogTriggerWeight);
+                break;
+            }
 
-    // Loop over hits collections.
-    for (size_t i = 0; i < fHitsCollectionNames.size(); ++i) {
-        G4int hcID = G4SDManager::GetSDMpointer()->GetCollectionID(fHitsCollectionNames[i]);
-        auto* fHitsCollection = static_cast<HitsCollection*>(HCE->GetHC(hcID));
-        if (!fHitsCollection) continue;
+            case kHitsCollection: {
+                auto* hitsCollection = static_cast<HitsCollection*>(HCE->GetHC(entry.hcID));
+                if (!hitsCollection) break;
+                if (verbosityLevel > 0) G4cout << "Hits Collection: " << entry.collectionName << " has " << hitsCollection->entries() << " hits." << G4endl;
 
-        G4int n_hit = fHitsCollection->entries();
-        if (verbosityLevel > 0) G4cout << "Hits Collection: " << fHitsCollectionNames[i] << " has " << n_hit << " hits." << G4endl;
+                fClusters.clear();
+                ClusterHits(*hitsCollection->GetVector(), entry.spatialThreshold, entry.timeThreshold, fClusters, entry.detectorIndex);
+                FillClusters(fClusters, entry, fLogTriggerWeight);
+                break;
+            }
 
-        std::vector<Hit*> collectionHits;
-        for (G4int j = 0; j < n_hit; ++j) {
-            Hit* hit = (*fHitsCollection)[j];
-            collectionHits.push_back(hit);
+            case kNoReadout:
+                break;
         }
+    }
+}
 
-        // Get clustering parameters for this collection from the config file or a predefined map.
-        G4double spatialThreshold = GetSpatialThreshold(fHitsCollectionNames[i]) * mm;
-        G4double timeThreshold = GetTimeThreshold(fHitsCollectionNames[i]) * ns;
-
-        // Cluster hits for this collection.
-        std::vector<Cluster> clusters;
-        ClusterHits(collectionHits, spatialThreshold, timeThreshold, clusters, static_cast<int>(i)); // Add collection ID here.
-        allClusters.insert(allClusters.end(), clusters.begin(), clusters.end());
-    
-        // Use `allClusters` for further analysis or output.
-        G4double edet = 0.0;
-        G4int nclus = 0;
-        G4int ncomp = 0;
-        G4int nphot = 0;
-
-        for (auto& cluster : clusters) {
+/**
+ * @brief Writes the clusters of one active volume to the output vectors.
+ *
+ * Clusters without energy are skipped. The per detector energy sum and number of clusters go into the output slot,
+ * or, in the sparse layout, are appended if the volume has clusters.
+ *
+ * @param clusters The clusters of the active volume.
+ * @param entry The readout plan entry of the active volume.
+ * @param logTriggerWeight The logarithm of the prescale weight of the event, added to the weight of every cluster.
+ */
+void EventAction::FillClusters(const std::vector<Cluster>& clusters, const ReadoutEntry& entry, G4double logTriggerWeight) {
+    G4double edet = 0.0;
+    G4int nclus = 0;
 
-          if (cluster.energyDeposit > 0*eV) {
+    for (const auto& cluster : clusters) {
+        if (cluster.energyDeposit > 0*eV) {
             nclus++;
             edet += cluster.energyDeposit / keV;
-            //G4cout << "cluster: " << nclus << " edep: " << cluster.energyDeposit / keV << " keV" << G4endl;
             fE.push_back(cluster.energyDeposit / keV);
             fX.push_back(cluster.position.x());
             fY.push_back(cluster.position.y());
             fZ.push_back(cluster.position.z());
-            fID.push_back(cluster.collectionID);
-            fW.push_back(fLogWeight);
-          }
+            fID.push_back(entry.detectorIndex);
+            fW.push_back(std::log(cluster.weight) + logTriggerWeight);
         }
-        //G4cout << "Total energy deposit: " << edet << " keV" << G4endl;
+    }
+
+    if (fSparseLayout) {
+        if (nclus == 0) return;
+        fDet.push_back(entry.detectorIndex);
         fEdet.push_back(edet);
         fNdet.push_back(nclus);
-        fNphot.push_back(ncomp);
-        fNcomp.push_back(nphot);
+        return;
     }
-  }
+    fEdet[entry.outputSlot] = edet;
+    fNdet[entry.outputSlot] = nclus;
+}
 
 /**
  * @brief Clusters hits based on spatial and temporal thresholds.
@@ -258,7 +531,8 @@ void EventAction::AnalyzeHits(const G4Event* event) {
  * This function processes a list of hits, normalizes their times relative to the start of the event,
  * and clusters them based on spatial and temporal thresholds. It first identifies cluster seeds based
  * on the process type (e.g., Compton or photoelectric), then clusters the remaining hits, and finally
- * merges clusters that are close together.
+ * merges clusters that are close together. The work is done by the HitClusterer, which looks up nearby
+ * clusters on a grid, so the cost grows roughly linearly with the number of hits.
  *
  * @param hits A vector of pointers to Hit objects to be clustered.
  * @param spatialThreshold The maximum spatial distance between hits to be considered part of the same cluster.
@@ -283,20 +557,12 @@ void EventAction::ClusterHits(std::vector<Hit*>& hits, G4double spatialThreshold
         hit->time -= startTime;
     }
 
-    // Find cluster seeds based on the process (e.g., Compton or photoelectric).
-    G4int ncomp = 0;
-    G4int nphot = 0;
+    fClusterer.Reset(spatialThreshold, timeThreshold);
 
+    // Cluster seeds based on the process (e.g., Compton or photoelectric).
     for (auto& hit : hits) {
-        G4String process = hit->processType;
-        G4int trackID = hit->trackID;
-
-        G4bool isRelevantProcess = (process == "compt" || process == "phot");
-
-        if (process == "compt") ncomp++;
-        if (process == "phot") nphot++;
-        if (isRelevantProcess) {
-            clusters.push_back(Cluster{hit->position, hit->energyDeposit, hit->time, {hit}, collectionID});
+        if (hit->processID == fComptonScattering || hit->processID == fPhotoElectricEffect) {
+            fClusterer.AddSeed(hit->position, hit->energyDeposit, hit->time, hit->weight);
             hit->used = true;
         }
     }
@@ -304,74 +570,59 @@ void EventAction::ClusterHits(std::vector<Hit*>& hits, G4double spatialThreshold
     // Cluster the remaining hits.
     for (auto& hit : hits) {
         if (hit->used) continue;
-
-        bool addedToCluster = false;
-        for (auto& cluster : clusters) {
-            if (cluster.collectionID != collectionID) continue;  // Ensure we only cluster within the same collection.
-
-            if (CalculateDistance(hit->position, cluster.position) < spatialThreshold &&
-                CalculateTimeDifference(hit->time, cluster.time) < timeThreshold) {
-
-                G4double energyDeposit = hit->energyDeposit;
-                if (energyDeposit > 0 * eV) {
-                    G4int clusterSize = cluster.hits.size();
-                    cluster.position = (cluster.position * clusterSize + hit->position) / (clusterSize + 1);
-                    cluster.energyDeposit += energyDeposit;
-                    cluster.time = (cluster.time * clusterSize + hit->time) / (clusterSize + 1);
-                    cluster.hits.push_back(hit);
-                    addedToCluster = true;
-                    break;
-                }
-            }
-        }
-        if (!addedToCluster) {
-            clusters.push_back(Cluster{hit->position, hit->energyDeposit, hit->time, {hit}, collectionID});
-        }
+        fClusterer.AddHit(hit->position, hit->energyDeposit, hit->time, hit->weight);
     }
 
     // Merge clusters that are close together.
-    for (size_t i = 0; i < clusters.size(); ++i) {
-        for (size_t j = i + 1; j < clusters.size();) {
-            if (clusters[i].collectionID != clusters[j].collectionID) {
-                ++j;
-                continue;
-            }
-            if (CalculateDistance(clusters[i].position, clusters[j].position) < spatialThreshold &&
-                CalculateTimeDifference(clusters[i].time, clusters[j].time) < timeThreshold) {
-
-                // Merge cluster j into cluster i.
-                G4int totalHits = clusters[i].hits.size() + clusters[j].hits.size();
-                clusters[i].position = (clusters[i].position * clusters[i].hits.size() + clusters[j].position * clusters[j].hits.size()) / totalHits;
-                clusters[i].energyDeposit += clusters[j].energyDeposit;
-                clusters[i].time = (clusters[i].time * clusters[i].hits.size() + clusters[j].time * clusters[j].hits.size()) / totalHits;
-                clusters[i].hits.insert(clusters[i].hits.end(), clusters[j].hits.begin(), clusters[j].hits.end());
-
-                clusters.erase(clusters.begin() + j);
-            } else {
-                ++j;
-            }
-        }
-    }
+    fClusterer.MergeClusters();
+    fClusterer.GetClusters(clusters, collectionID);
 }
 
-G4double EventAction::GetSpatialThreshold(const G4String& collectionName) {
-    if (fClusteringParameters.find(collectionName) != fClusteringParameters.end()) {
-        return fClusteringParameters[collectionName].first;
-    }
-    return 10.0 * mm;  // default value if not found
+/**
+ * @brief Clusters the hits of a HitStore based on spatial and temporal thresholds.
+ *
+ * Same clustering as for a vector of hits, but the hit properties are read from the contiguous arrays of the
+ * store.
+ *
+ * @param hits The hit store of a sensitive detector.
+ * @param spatialThreshold The maximum spatial distance between hits to be considered part of the same cluster.
+ * @param timeThreshold The maximum time difference between hits to be considered part of the same cluster.
+ * @param clusters A vector of Cluster objects where the resulting clusters will be stored.
+ * @param collectionID An identifier for the collection of hits being processed.
+ */
+void EventAction::ClusterHits(const HitStore& hits, G4double spatialThreshold, G4double timeThreshold, std::vector<Cluster>& clusters, int collectionID) {
+    ClusterDeposits(hits.GetSize(), hits.GetX(), hits.GetY(), hits.GetZ(), hits.GetTime(), hits.GetEnergyDeposit(),
+                    hits.GetProcessID(), hits.GetWeight(), spatialThreshold, timeThreshold, clusters, collectionID);
 }
 
-G4double EventAction::GetTimeThreshold(const G4String& collectionName) {
-    if (fClusteringParameters.find(collectionName) != fClusteringParameters.end()) {
-        return fClusteringParameters[collectionName].second;
-    }
-    return 100.0 * ns;  // default value if not found
-}
+/**
+ * @brief Clusters deposits that are given as arrays, one per property.
+ *
+ * The arrays are not modified: the normalized times are computed on the fly, and the seeds are recognized
+ * from the process array instead of being flagged as used (see HitClusterer::ClusterDeposits). The result is the
+ * same as for ClusterHits() on a vector of hits with the same deposits.
+ *
+ * @param nDeposits The number of deposits.
+ * @param x, y, z The position of the deposits.
+ * @param time The global time of the deposits.
+ * @param energyDeposit The deposited energy.
+ * @param processID The process sub type that defined the step.
+ * @param weight The track weight of the deposits.
+ * @param spatialThreshold The maximum spatial distance between hits to be considered part of the same cluster.
+ * @param timeThreshold The maximum time difference between hits to be considered part of the same cluster.
+ * @param clusters A vector of Cluster objects where the resulting clusters will be stored.
+ * @param collectionID An identifier for the collection of hits being processed.
+ */
+void EventAction::ClusterDeposits(size_t nDeposits, const G4double* x, const G4double* y, const G4double* z,
+                                  const G4double* time, const G4double* energyDeposit, const G4int* processID,
+                                  const G4double* weight, G4double spatialThreshold, G4double timeThreshold,
+                                  std::vector<Cluster>& clusters, int collectionID) {
 
-std::map<G4String, std::pair<G4double, G4double>> EventAction::fClusteringParameters;
+    if (nDeposits == 0) return;  // No hits, nothing to do.
 
-void EventAction::SetClusteringParameters(const std::map<G4String, std::pair<G4double, G4double>>& params) {
-    fClusteringParameters = params;
+    // Normalize the times, add the seeds (Compton and photoelectric) and the remaining hits, and merge.
+    fClusterer.ClusterDeposits(nDeposits, x, y, z, time, energyDeposit, processID, spatialThreshold, timeThreshold, weight);
+    fClusterer.GetClusters(clusters, collectionID);
 }
 
 
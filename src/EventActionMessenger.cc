@@ -3,6 +3,9 @@
 #include "G4UIcmdWithADoubleAndUnit.hh"
 #include "G4UImanager.hh"
 #include "G4UnitsTable.hh"
+#include "G4UIparameter.hh"
+
+#include <sstream>
 
 /**
  * @class EventActionMessenger
@@ -10,7 +13,8 @@
  * @brief Messenger class for EventAction.
  * 
  * This class is responsible for handling user commands related to EventAction.
- * It provides commands to set the spatial and time thresholds for clustering.
+ * It provides commands to set the spatial and time thresholds for clustering, the event pipeline and the event
+ * trigger.
  */
 namespace G4Sim {
 
@@ -37,11 +41,63 @@ EventActionMessenger::EventActionMessenger(EventAction* eventAction)
     fTimeThresholdCmd->SetRange("TimeThreshold>=0.");
     fTimeThresholdCmd->SetUnitCategory("Time");
     fTimeThresholdCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    // Commands for the pipelined post-processing
+    fPipelineCmd = new G4UIcmdWithABool("/event/pipeline", this);
+    fPipelineCmd->SetGuidance("Cluster and write events on a dedicated thread, while tracking continues.");
+    fPipelineCmd->SetGuidance("Requires the columnar output (/run/setOutputFormat columnar).");
+    fPipelineCmd->SetParameterName("pipeline", false);
+    fPipelineCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    fPipelineBatchSizeCmd = new G4UIcmdWithAnInteger("/event/pipelineBatchSize", this);
+    fPipelineBatchSizeCmd->SetGuidance("Set the number of events per batch of the pipeline. At most two batches are in memory.");
+    fPipelineBatchSizeCmd->SetParameterName("batchSize", false);
+    fPipelineBatchSizeCmd->SetRange("batchSize>0");
+    fPipelineBatchSizeCmd->AvailableForStates(G4State_PreInit);
+
+    // Commands for the event trigger
+    fTriggerDirectory = new G4UIdirectory("/event/trigger/");
+    fTriggerDirectory->SetGuidance("Only write events with energy in the active volumes.");
+
+    fTriggerWindowCmd = new G4UIcommand("/event/trigger/window", this);
+    fTriggerWindowCmd->SetGuidance("Set the energy window in which an active volume fires the trigger.");
+    fTriggerWindowCmd->SetGuidance("Overrides the 'trigger' entry of the volume in the geometry file. maxEnergy 0 means no upper limit.");
+    auto* volumeParameter = new G4UIparameter("volume", 's', false);
+    fTriggerWindowCmd->SetParameter(volumeParameter);
+    auto* minEnergyParameter = new G4UIparameter("minEnergy", 'd', false);
+    minEnergyParameter->SetParameterRange("minEnergy>=0.");
+    fTriggerWindowCmd->SetParameter(minEnergyParameter);
+    auto* maxEnergyParameter = new G4UIparameter("maxEnergy", 'd', true);
+    maxEnergyParameter->SetDefaultValue(0.);
+    maxEnergyParameter->SetParameterRange("maxEnergy>=0.");
+    fTriggerWindowCmd->SetParameter(maxEnergyParameter);
+    auto* unitParameter = new G4UIparameter("unit", 's', true);
+    unitParameter->SetDefaultUnit("keV");
+    fTriggerWindowCmd->SetParameter(unitParameter);
+    fTriggerWindowCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    fTriggerCoincidenceCmd = new G4UIcmdWithAnInteger("/event/trigger/coincidence", this);
+    fTriggerCoincidenceCmd->SetGuidance("Set the number of active volumes that must fire for an event to be written.");
+    fTriggerCoincidenceCmd->SetParameterName("coincidence", false);
+    fTriggerCoincidenceCmd->SetRange("coincidence>0");
+    fTriggerCoincidenceCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    fTriggerPrescaleCmd = new G4UIcmdWithAnInteger("/event/trigger/prescale", this);
+    fTriggerPrescaleCmd->SetGuidance("Keep one in every N rejected events, with its weight multiplied by N. 0 drops all rejected events.");
+    fTriggerPrescaleCmd->SetParameterName("prescale", false);
+    fTriggerPrescaleCmd->SetRange("prescale>=0");
+    fTriggerPrescaleCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
 }
 
 EventActionMessenger::~EventActionMessenger() {
     delete fSpatialThresholdCmd;
     delete fTimeThresholdCmd;
+    delete fPipelineCmd;
+    delete fPipelineBatchSizeCmd;
+    delete fTriggerWindowCmd;
+    delete fTriggerCoincidenceCmd;
+    delete fTriggerPrescaleCmd;
+    delete fTriggerDirectory;
 }
 
 /**
@@ -58,6 +114,21 @@ void EventActionMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
         fEventAction->SetSpatialThreshold(fSpatialThresholdCmd->GetNewDoubleValue(newValue));
     } else if (command == fTimeThresholdCmd) {
         fEventAction->SetTimeThreshold(fTimeThresholdCmd->GetNewDoubleValue(newValue));
+    } else if (command == fPipelineCmd) {
+        fEventAction->SetUsePipeline(fPipelineCmd->GetNewBoolValue(newValue));
+    } else if (command == fPipelineBatchSizeCmd) {
+        fEventAction->SetPipelineBatchSize(fPipelineBatchSizeCmd->GetNewIntValue(newValue));
+    } else if (command == fTriggerWindowCmd) {
+        G4String volumeName, unit;
+        G4double minEnergy, maxEnergy;
+        std::istringstream is(newValue);
+        is >> volumeName >> minEnergy >> maxEnergy >> unit;
+        G4double unitValue = G4UIcommand::ValueOf(unit);
+        fEventAction->SetTriggerWindow(volumeName, minEnergy * unitValue, maxEnergy * unitValue);
+    } else if (command == fTriggerCoincidenceCmd) {
+        fEventAction->SetTriggerCoincidence(fTriggerCoincidenceCmd->GetNewIntValue(newValue));
+    } else if (command == fTriggerPrescaleCmd) {
+        fEventAction->SetTriggerPrescale(fTriggerPrescaleCmd->GetNewIntValue(newValue));
     }
 }
 
@@ -0,0 +1,102 @@
+#include "EventPipeline.hh"
+
+/**
+ * @namespace G4Sim
+ * @brief Namespace for the G4Sim library.
+/*/
+namespace G4Sim {
+
+/**
+ * @brief Constructs an EventPipeline.
+ *
+ * @param batchSize The number of events per batch.
+ * @param consumer The function that processes a record on the consumer thread.
+ */
+EventPipeline::EventPipeline(size_t batchSize, Consumer consumer)
+    : fBatchSize(batchSize > 0 ? batchSize : 1), fConsumer(std::move(consumer)) {
+    fBatches[0].resize(fBatchSize);
+    fBatches[1].resize(fBatchSize);
+}
+
+EventPipeline::~EventPipeline() {
+    Stop();
+}
+
+/**
+ * @brief Starts the consumer thread.
+ */
+void EventPipeline::Start() {
+    if (IsRunning()) return;
+    fBatchFill[0] = fBatchFill[1] = 0;
+    fProducerBatch = 0;
+    fPendingBatch = -1;
+    fStopRequested = false;
+    fThread = std::thread(&EventPipeline::Run, this);
+}
+
+/**
+ * @brief Returns the next free record of the batch that is being filled.
+ */
+EventRecord& EventPipeline::NextRecord() {
+    return fBatches[fProducerBatch][fBatchFill[fProducerBatch]];
+}
+
+/**
+ * @brief Marks the record returned by NextRecord() as filled, and hands the batch over when it is full.
+ */
+void EventPipeline::Commit() {
+    if (++fBatchFill[fProducerBatch] == fBatchSize) HandOver();
+}
+
+/**
+ * @brief Processes the remaining records and stops the consumer thread.
+ */
+void EventPipeline::Stop() {
+    if (!IsRunning()) return;
+    if (fBatchFill[fProducerBatch] > 0) HandOver();
+    {
+        std::lock_guard<std::mutex> lock(fMutex);
+        fStopRequested = true;
+    }
+    fCondition.notify_all();
+    fThread.join();
+}
+
+/**
+ * @brief Hands the current batch to the consumer, waiting until the consumer is done with the previous one.
+ */
+void EventPipeline::HandOver() {
+    std::unique_lock<std::mutex> lock(fMutex);
+    fCondition.wait(lock, [this] { return fPendingBatch < 0; });
+    fPendingBatch = fProducerBatch;
+    lock.unlock();
+    fCondition.notify_all();
+
+    // the other batch is free: it was processed before the consumer became idle
+    fProducerBatch = 1 - fProducerBatch;
+    fBatchFill[fProducerBatch] = 0;
+}
+
+void EventPipeline::Run() {
+    while (true) {
+        G4int batch;
+        {
+            std::unique_lock<std::mutex> lock(fMutex);
+            fCondition.wait(lock, [this] { return fPendingBatch >= 0 || fStopRequested; });
+            if (fPendingBatch < 0) return;  // stop requested and nothing left to do
+            batch = fPendingBatch;
+        }
+
+        for (size_t i = 0; i < fBatchFill[batch]; ++i) {
+            fConsumer(fBatches[batch][i]);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(fMutex);
+            fPendingBatch = -1;
+        }
+        fCondition.notify_all();
+    }
+}
+
+} // namespace G4Sim
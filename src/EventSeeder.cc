@@ -0,0 +1,61 @@
+#include "EventSeeder.hh"
+
+#include "Randomize.hh"
+
+/**
+ * @namespace G4Sim
+ * @brief Namespace for the G4Sim library.
+/*/
+namespace G4Sim {
+
+namespace {
+
+// the SplitMix64 finalizer, a bijective mix of all 64 bits
+std::uint64_t Mix(std::uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+} // namespace
+
+EventSeeder* EventSeeder::Instance() {
+    static EventSeeder instance;
+    return &instance;
+}
+
+/**
+ * @brief Computes the seeds of an event.
+ *
+ * @param runSeed The run seed.
+ * @param eventNumber The global event number.
+ * @param seeds Filled with two seeds in [1, 2^31), as accepted by all CLHEP engines.
+ */
+void EventSeeder::MakeSeeds(std::uint64_t runSeed, std::uint64_t eventNumber, long seeds[2]) {
+    std::uint64_t key = Mix(Mix(runSeed) ^ (eventNumber + 0x9e3779b97f4a7c15ULL));
+    for (int i = 0; i < 2; ++i) {
+        key = Mix(key + 0x9e3779b97f4a7c15ULL);
+        seeds[i] = static_cast<long>(key & 0x7fffffffULL);
+        if (seeds[i] == 0) seeds[i] = 1;
+    }
+}
+
+/**
+ * @brief Seeds the random engine of this thread for an event. Does nothing without a run seed.
+ *
+ * Called at the start of GeneratePrimaries(), after the run manager has seeded the engine of a worker, and before
+ * any random number of the event is drawn.
+ *
+ * @param eventID The event ID within the run.
+ */
+void EventSeeder::SeedEvent(G4int eventID) const {
+    if (!IsEnabled()) return;
+    long seeds[3] = {0, 0, 0};  // zero terminated
+    MakeSeeds(fRunSeed, GetEventNumber(eventID), seeds);
+    G4Random::setTheSeeds(seeds, -1);
+}
+
+} // namespace G4Sim
@@ -0,0 +1,107 @@
+#include "EventTrigger.hh"
+
+#include "G4SystemOfUnits.hh"
+#include "G4ios.hh"
+
+/**
+ * @namespace G4Sim
+ * @brief Namespace for the G4Sim library.
+/*/
+namespace G4Sim {
+
+/**
+ * @brief Sets the energy window of an active volume, overriding the window of the geometry file.
+ *
+ * @param volumeName The name of the active volume.
+ * @param minEnergy The minimum energy.
+ * @param maxEnergy The maximum energy, or 0 for no upper limit.
+ */
+void EventTrigger::SetWindow(const G4String& volumeName, G4double minEnergy, G4double maxEnergy) {
+    fOverrides[volumeName] = {minEnergy, maxEnergy};
+}
+
+/**
+ * @brief Builds the window per entry of the readout plan and resets the counters.
+ *
+ * Called at the start of each run, with the active volumes in the order of the readout plan.
+ *
+ * @param sensitiveVolumes The active volumes of the DetectorConstruction.
+ */
+void EventTrigger::Configure(const std::vector<SensitiveVolume>& sensitiveVolumes) {
+    fWindows.clear();
+    fActive = fCoincidence > 1;
+    for (const SensitiveVolume& sensitiveVolume : sensitiveVolumes) {
+        Window window;
+        if (sensitiveVolume.trigger) {
+            window = {sensitiveVolume.triggerMinEnergy, sensitiveVolume.triggerMaxEnergy};
+            fActive = true;
+        }
+        auto it = fOverrides.find(sensitiveVolume.volumeName);
+        if (it != fOverrides.end()) {
+            window = it->second;
+            fActive = true;
+        }
+        fWindows.push_back(window);
+    }
+
+    fNAccepted = fNPrescaled = fNRejected = 0;
+
+    if (fActive) {
+        G4cout << "EventTrigger::Configure: coincidence = " << fCoincidence << " prescale = " << fPrescale << G4endl;
+        for (size_t i = 0; i < fWindows.size(); ++i) {
+            G4cout << "EventTrigger::Configure: " << sensitiveVolumes[i].volumeName << " window = ["
+                   << fWindows[i].minEnergy / keV << ", ";
+            if (fWindows[i].maxEnergy > 0.) {
+                G4cout << fWindows[i].maxEnergy / keV;
+            } else {
+                G4cout << "inf";
+            }
+            G4cout << "] keV" << G4endl;
+        }
+    }
+}
+
+/**
+ * @brief Applies the trigger to the energies of an event.
+ *
+ * @param energies The energy deposit per entry of the readout plan.
+ * @return The decision for the event.
+ */
+EventTrigger::Decision EventTrigger::Evaluate(const std::vector<G4double>& energies) {
+    if (!fActive) {
+        fNAccepted++;
+        return kAccept;
+    }
+
+    G4int nFired = 0;
+    for (size_t i = 0; i < fWindows.size() && i < energies.size(); ++i) {
+        const Window& window = fWindows[i];
+        G4double energy = energies[i];
+        if (energy > 0. && energy >= window.minEnergy && (window.maxEnergy <= 0. || energy <= window.maxEnergy)) {
+            nFired++;
+        }
+    }
+
+    if (nFired >= fCoincidence) {
+        fNAccepted++;
+        return kAccept;
+    }
+
+    fNRejected++;
+    if (fPrescale > 0 && fNRejected % fPrescale == 0) {
+        fNPrescaled++;
+        return kPrescaled;
+    }
+    return kReject;
+}
+
+/**
+ * @brief Prints the number of accepted, prescaled and rejected events since Configure().
+ */
+void EventTrigger::PrintSummary() const {
+    if (!fActive) return;
+    G4cout << "EventTrigger: accepted = " << fNAccepted << " rejected = " << fNRejected
+           << " (of which kept by prescale = " << fNPrescaled << ")" << G4endl;
+}
+
+} // namespace G4Sim
@@ -0,0 +1,207 @@
+#include "GeometryCache.hh"
+
+#include "G4Version.hh"
+#include "G4ios.hh"
+#include "globals.hh"
+
+#ifdef G4XAMSSIM_USE_GDML
+#include "G4GDMLParser.hh"
+
+#include <xercesc/dom/DOMDocument.hpp>
+#include <xercesc/parsers/XercesDOMParser.hpp>
+#include <xercesc/util/PlatformUtils.hpp>
+#endif
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include <unistd.h>
+
+/**
+ * @namespace G4Sim
+ * @brief Namespace for the G4Sim library.
+/*/
+namespace G4Sim {
+
+namespace {
+
+const std::uint64_t kFnvOffset = 14695981039346656037ULL;
+const std::uint64_t kFnvPrime = 1099511628211ULL;
+const G4int kCacheVersion = 1;  // increase when the content of the entries changes
+
+void HashBytes(std::uint64_t& hash, const char* data, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= kFnvPrime;
+    }
+}
+
+#ifdef G4XAMSSIM_USE_GDML
+// unique per job, keeps the extension for the GDML writer
+G4String TemporaryName(const G4String& fileName) {
+    size_t dot = fileName.rfind('.');
+    return fileName.substr(0, dot) + ".tmp" + std::to_string(::getpid()) + fileName.substr(dot);
+}
+
+// the GDML reader aborts the job on a file that is not well-formed XML, so the file is parsed once without it
+G4bool IsWellFormed(const G4String& fileName) {
+    G4bool wellFormed = false;
+    xercesc::XMLPlatformUtils::Initialize();
+    {
+        xercesc::XercesDOMParser parser;
+        parser.setValidationScheme(xercesc::XercesDOMParser::Val_Never);
+        parser.setDoNamespaces(false);
+        parser.setDoSchema(false);
+        parser.setLoadExternalDTD(false);
+        try {
+            parser.parse(fileName.c_str());
+            wellFormed = parser.getErrorCount() == 0 && parser.getDocument() && parser.getDocument()->getDocumentElement();
+        } catch (...) {
+            wellFormed = false;
+        }
+    }
+    xercesc::XMLPlatformUtils::Terminate();
+    return wellFormed;
+}
+#endif
+
+} // namespace
+
+/**
+ * @brief Constructs the cache entry with the given key.
+ *
+ * @param directory The cache directory; it is created when the first entry is stored.
+ * @param key The key of the entry, see Hash().
+ */
+GeometryCache::GeometryCache(const G4String& directory, std::uint64_t key)
+    : fDirectory(directory) {
+    std::ostringstream name;
+    name << directory << "/geometry_" << std::hex << std::setw(16) << std::setfill('0') << key;
+    fGdmlFileName = name.str() + ".gdml";
+    fMetadataFileName = name.str() + ".json";
+}
+
+/**
+ * @brief Returns true if G4XamsSim is built with GDML support.
+ */
+G4bool GeometryCache::IsAvailable() {
+#ifdef G4XAMSSIM_USE_GDML
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Computes the key of a geometry.
+ *
+ * @param fileNames The files the geometry is built from. A file that cannot be read only contributes its name.
+ * @param settings The settings that change the constructed geometry or its metadata, as a string.
+ * @return The 64-bit FNV-1a hash of the files, the settings, the Geant4 version and the cache version.
+ */
+std::uint64_t GeometryCache::Hash(const std::vector<std::string>& fileNames, const std::string& settings) {
+    std::uint64_t hash = kFnvOffset;
+    std::ostringstream versions;
+    versions << kCacheVersion << ' ' << G4VERSION_NUMBER << ' ';
+    HashBytes(hash, versions.str().data(), versions.str().size());
+    HashBytes(hash, settings.data(), settings.size());
+
+    for (const std::string& fileName : fileNames) {
+        HashBytes(hash, fileName.data(), fileName.size() + 1);  // including the terminating zero as separator
+        std::ifstream file(fileName, std::ios::binary);
+        char buffer[65536];
+        while (file.read(buffer, sizeof(buffer)) || file.gcount() > 0) {
+            HashBytes(hash, buffer, file.gcount());
+        }
+    }
+    return hash;
+}
+
+/**
+ * @brief Returns true if the entry exists. The GDML file is renamed last, so both files are complete.
+ */
+G4bool GeometryCache::Contains() const {
+    return std::filesystem::exists(fGdmlFileName) && std::filesystem::exists(fMetadataFileName);
+}
+
+/**
+ * @brief Loads the geometry and its metadata.
+ *
+ * A metadata file that is not valid JSON, lacks one of the sections written by
+ * DetectorConstruction::MakeCacheMetadata(), or a GDML file that is not well-formed XML makes the entry unreadable;
+ * the caller then builds the geometry. Both are checked before the GDML reader runs, since it aborts on bad input.
+ *
+ * @param metadata Filled with the metadata given to Store().
+ * @return The world volume, or nullptr if the entry cannot be read.
+ */
+G4VPhysicalVolume* GeometryCache::Load(nlohmann::json& metadata) const {
+#ifdef G4XAMSSIM_USE_GDML
+    std::ifstream metadataFile(fMetadataFileName);
+    if (!metadataFile) return nullptr;
+    metadata = nlohmann::json::parse(metadataFile, nullptr, false);
+    G4bool complete = !metadata.is_discarded() && metadata.is_object();
+    for (const char* section : {"sensitiveVolumes", "terminationPolicies", "importances", "importanceParticles"}) {
+        complete = complete && metadata.contains(section) && metadata[section].is_array();
+    }
+    if (!complete) {
+        G4cerr << "GeometryCache::Load: Warning: " << fMetadataFileName << " is not valid" << G4endl;
+        return nullptr;
+    }
+    if (!IsWellFormed(fGdmlFileName)) {
+        G4cerr << "GeometryCache::Load: Warning: " << fGdmlFileName << " is not well-formed GDML" << G4endl;
+        return nullptr;
+    }
+
+    G4cout << "GeometryCache::Load: reading " << fGdmlFileName << G4endl;
+    G4GDMLParser parser;
+    parser.Read(fGdmlFileName, false);
+    return parser.GetWorldVolume();
+#else
+    (void)metadata;
+    return nullptr;
+#endif
+}
+
+/**
+ * @brief Stores the geometry and its metadata. Failures are reported, the job continues without a cache entry.
+ *
+ * @param world The world volume.
+ * @param metadata The metadata, returned by Load() in later jobs.
+ */
+void GeometryCache::Store(G4VPhysicalVolume* world, const nlohmann::json& metadata) const {
+#ifdef G4XAMSSIM_USE_GDML
+    std::error_code error;
+    std::filesystem::create_directories(fDirectory, error);
+
+    G4String metadataTemporary = TemporaryName(fMetadataFileName);
+    {
+        std::ofstream metadataFile(metadataTemporary);
+        metadataFile << metadata.dump(4);
+        if (!metadataFile) {
+            G4cerr << "GeometryCache::Store: Warning: cannot write " << metadataTemporary << G4endl;
+            return;
+        }
+    }
+
+    G4String gdmlTemporary = TemporaryName(fGdmlFileName);
+    G4GDMLParser parser;
+    parser.Write(gdmlTemporary, world, true);
+
+    if (std::rename(metadataTemporary.c_str(), fMetadataFileName.c_str()) != 0 ||
+        std::rename(gdmlTemporary.c_str(), fGdmlFileName.c_str()) != 0) {
+        G4cerr << "GeometryCache::Store: Warning: cannot create " << fGdmlFileName << G4endl;
+        std::remove(metadataTemporary.c_str());
+        std::remove(gdmlTemporary.c_str());
+        return;
+    }
+    G4cout << "GeometryCache::Store: geometry written to " << fGdmlFileName << G4endl;
+#else
+    (void)world;
+    (void)metadata;
+#endif
+}
+
+} // namespace G4Sim
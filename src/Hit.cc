@@ -1,5 +1,10 @@
 #include "Hit.hh"
 #include "G4SystemOfUnits.hh"
+#include "G4ParticleTable.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4ProcessManager.hh"
+#include "G4ProcessVector.hh"
+#include "G4VProcess.hh"
 
 /**
  * @namespace G4Sim
@@ -13,7 +18,7 @@ G4ThreadLocal G4Allocator<Hit>* HitAllocator = 0;
  * @brief Default constructor for the Hit class.
  */
 Hit::Hit()
-    : G4VHit(), energyDeposit(0.), position(G4ThreeVector()), time(0.), trackID(-1), parentID(-1), momentum(G4ThreeVector()), particleType(""), processType(""), used(false) {}
+    : G4VHit(), energyDeposit(0.), position(G4ThreeVector()), time(0.), trackID(-1), parentID(-1), momentum(G4ThreeVector()), particleID(0), processID(-1), particleEnergy0(0.), particleEnergy1(0.), weight(1.), used(false) {}
 
 Hit::~Hit() {}
 
@@ -26,15 +31,50 @@ Hit::~Hit() {}
 void Hit::Print() const {
     G4cout << "ID: " << trackID
            << ", ID: " << parentID
-           << ", Proc: " << processType
-           << ", Ptcl: " << particleType
+           << ", Proc: " << GetProcessName(particleID, processID)
+           << ", Ptcl: " << GetParticleName(particleID)
            << ", E0: " << particleEnergy0 / keV << " keV"
            << ", E1: " << particleEnergy1 / keV << " keV"
            << ", dE: " << energyDeposit / keV << " keV"
            << ", pos: " << position / cm << " cm"
            << ", t: " << time / ns << " ns"
+           << ", w: " << weight
            << G4endl;
     //       << ", p: " << momentum << G4endl;
 }
 
+/**
+ * @brief Looks up the name of a particle from its PDG encoding.
+ *
+ * @param particleID The PDG encoding of the particle.
+ * @return The particle name, or "unknown" if the particle table does not know the encoding.
+ */
+G4String Hit::GetParticleName(G4int particleID) {
+    G4ParticleDefinition* particle = G4ParticleTable::GetParticleTable()->FindParticle(particleID);
+    return particle ? particle->GetParticleName() : G4String("unknown");
+}
+
+/**
+ * @brief Looks up the name of a process from its sub type.
+ *
+ * The sub type alone is not unique (e.g. eIoni and hIoni are both fIonisation), so the process is searched in
+ * the process list of the particle that made the hit.
+ *
+ * @param particleID The PDG encoding of the particle.
+ * @param processID The sub type of the process.
+ * @return The process name, or "unknown" if the particle has no process with this sub type.
+ */
+G4String Hit::GetProcessName(G4int particleID, G4int processID) {
+    G4ParticleDefinition* particle = G4ParticleTable::GetParticleTable()->FindParticle(particleID);
+    if (particle && particle->GetProcessManager()) {
+        G4ProcessVector* processList = particle->GetProcessManager()->GetProcessList();
+        for (size_t i = 0; i < processList->entries(); ++i) {
+            if ((*processList)[i]->GetProcessSubType() == processID) {
+                return (*processList)[i]->GetProcessName();
+            }
+        }
+    }
+    return "unknown";
+}
+
 } // namespace G4Sim
\ No newline at end of file
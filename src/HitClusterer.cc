@@ -0,0 +1,307 @@
+#include "HitClusterer.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4EmProcessSubType.hh"
+
+#include <algorithm>
+#include <cmath>
+
+/**
+ * @namespace G4Sim
+ * @brief Namespace for the G4Sim library.
+/*/
+namespace G4Sim {
+
+namespace {
+    // marks an unused slot of the hash table; real keys only use the lower 63 bits
+    const std::uint64_t kEmptyKey = ~std::uint64_t(0);
+    // cell indices are packed in 21 bits each. Indices that wrap around only add candidates, never lose them.
+    const std::int64_t kCellMask = (std::int64_t(1) << 21) - 1;
+    const std::int64_t kMaxCellIndex = std::int64_t(1) << 40;
+    const size_t kInitialTableSize = 64;
+}
+
+/**
+ * @brief Prepares the engine for a new collection of hits.
+ *
+ * @param spatialThreshold The maximum distance between a hit and a cluster to join.
+ * @param timeThreshold The maximum time difference between a hit and a cluster to join.
+ */
+void HitClusterer::Reset(G4double spatialThreshold, G4double timeThreshold) {
+    fSpatialThreshold = spatialThreshold;
+    fTimeThreshold = timeThreshold;
+    // with a zero threshold nothing can ever be close, and the grid would have zero cell size
+    fUseGrid = (fSpatialThreshold > 0.);
+
+    fClusters.clear();
+    fAlive.clear();
+    fClusterCell.clear();
+    fNextInCell.clear();
+    fNumberOfClusters = 0;
+
+    if (fTableKeys.empty()) {
+        fTableKeys.resize(kInitialTableSize);
+        fTableHeads.resize(kInitialTableSize);
+    }
+    std::fill(fTableKeys.begin(), fTableKeys.end(), kEmptyKey);
+    fTableUsed = 0;
+}
+
+/**
+ * @brief Adds a deposit that always starts a new cluster.
+ */
+void HitClusterer::AddSeed(const G4ThreeVector& position, G4double energyDeposit, G4double time, G4double weight) {
+    NewCluster(position, energyDeposit, time, weight);
+}
+
+/**
+ * @brief Adds a deposit to the first cluster within the thresholds, or starts a new cluster.
+ *
+ * The cluster position and time become the unweighted mean of its hits, and the cluster moves to its new cell.
+ */
+void HitClusterer::AddHit(const G4ThreeVector& position, G4double energyDeposit, G4double time, G4double weight) {
+    G4int index = (energyDeposit > 0 * eV) ? FindCluster(position, time, -1) : -1;
+    if (index < 0) {
+        NewCluster(position, energyDeposit, time, weight);
+        return;
+    }
+
+    Cluster& cluster = fClusters[index];
+    G4int clusterSize = cluster.nHits;
+    cluster.position = (cluster.position * clusterSize + position) / (clusterSize + 1);
+    cluster.weight = MeanWeight(cluster.energyDeposit, cluster.weight, energyDeposit, weight);
+    cluster.energyDeposit += energyDeposit;
+    cluster.time = (cluster.time * clusterSize + time) / (clusterSize + 1);
+    cluster.nHits++;
+
+    std::int64_t ix, iy, iz;
+    CellIndices(cluster.position, ix, iy, iz);
+    if (MakeKey(ix, iy, iz) != fClusterCell[index]) {
+        RemoveFromGrid(index);
+        InsertInGrid(index);
+    }
+}
+
+/**
+ * @brief Merges clusters that are close together.
+ *
+ * Each cluster, in order, absorbs the following clusters that are within the thresholds of its current position.
+ * As in a single forward scan, a cluster that was skipped is not looked at again after the position has moved,
+ * therefore only candidates behind the last merged cluster are accepted.
+ */
+void HitClusterer::MergeClusters() {
+    G4int nClusters = static_cast<G4int>(fClusters.size());
+    for (G4int i = 0; i < nClusters; ++i) {
+        if (!fAlive[i]) continue;
+        // cluster i is final after this iteration, and later clusters only look at higher indices
+        if (fUseGrid) RemoveFromGrid(i);
+
+        G4int last = i;
+        G4int j;
+        while ((j = FindCluster(fClusters[i].position, fClusters[i].time, last)) >= 0) {
+            Cluster& target = fClusters[i];
+            const Cluster& source = fClusters[j];
+
+            G4int totalHits = target.nHits + source.nHits;
+            target.position = (target.position * target.nHits + source.position * source.nHits) / totalHits;
+            target.weight = MeanWeight(target.energyDeposit, target.weight, source.energyDeposit, source.weight);
+            target.energyDeposit += source.energyDeposit;
+            target.time = (target.time * target.nHits + source.time * source.nHits) / totalHits;
+            target.nHits = totalHits;
+
+            RemoveFromGrid(j);
+            fAlive[j] = false;
+            fNumberOfClusters--;
+            last = j;
+        }
+    }
+}
+
+/**
+ * @brief Clusters deposits that are given as arrays, one per property.
+ *
+ * Times are taken relative to the earliest deposit. Compton and photo-electric deposits are added as seeds first,
+ * then all other deposits in their original order, and finally the clusters are merged. The arrays are not
+ * modified. The result is available through GetClusters().
+ *
+ * @param nDeposits The number of deposits.
+ * @param x, y, z The position of the deposits.
+ * @param time The global time of the deposits.
+ * @param energyDeposit The deposited energy.
+ * @param processID The process sub type that defined the step.
+ * @param spatialThreshold The maximum distance between a hit and a cluster to join.
+ * @param timeThreshold The maximum time difference between a hit and a cluster to join.
+ * @param weight The track weight of the deposits, or nullptr if all weights are 1.
+ */
+void HitClusterer::ClusterDeposits(size_t nDeposits, const G4double* x, const G4double* y, const G4double* z,
+                                   const G4double* time, const G4double* energyDeposit, const G4int* processID,
+                                   G4double spatialThreshold, G4double timeThreshold, const G4double* weight) {
+    Reset(spatialThreshold, timeThreshold);
+    if (nDeposits == 0) return;
+
+    G4double startTime = time[0];
+    for (size_t j = 1; j < nDeposits; ++j) {
+        startTime = std::min(startTime, time[j]);
+    }
+
+    for (size_t j = 0; j < nDeposits; ++j) {
+        if (processID[j] == fComptonScattering || processID[j] == fPhotoElectricEffect) {
+            AddSeed(G4ThreeVector(x[j], y[j], z[j]), energyDeposit[j], time[j] - startTime, weight ? weight[j] : 1.);
+        }
+    }
+    for (size_t j = 0; j < nDeposits; ++j) {
+        if (processID[j] == fComptonScattering || processID[j] == fPhotoElectricEffect) continue;
+        AddHit(G4ThreeVector(x[j], y[j], z[j]), energyDeposit[j], time[j] - startTime, weight ? weight[j] : 1.);
+    }
+
+    MergeClusters();
+}
+
+/**
+ * @brief Appends the clusters to a vector, in the order in which they were created.
+ *
+ * @param clusters The vector to append to.
+ * @param collectionID The collection identifier stored in each cluster.
+ */
+void HitClusterer::GetClusters(std::vector<Cluster>& clusters, G4int collectionID) const {
+    for (size_t i = 0; i < fClusters.size(); ++i) {
+        if (!fAlive[i]) continue;
+        clusters.push_back(fClusters[i]);
+        clusters.back().collectionID = collectionID;
+    }
+}
+
+G4int HitClusterer::NewCluster(const G4ThreeVector& position, G4double energyDeposit, G4double time, G4double weight) {
+    G4int index = static_cast<G4int>(fClusters.size());
+    fClusters.push_back(Cluster{position, energyDeposit, time, 1, -1, weight});
+    fAlive.push_back(true);
+    fClusterCell.push_back(kEmptyKey);
+    fNextInCell.push_back(-1);
+    fNumberOfClusters++;
+    if (fUseGrid) InsertInGrid(index);
+    return index;
+}
+
+/**
+ * @brief Energy weighted mean of two weights. Without energy the first weight is kept.
+ */
+G4double HitClusterer::MeanWeight(G4double energy1, G4double weight1, G4double energy2, G4double weight2) {
+    if (weight1 == weight2) return weight1;
+    G4double energy = energy1 + energy2;
+    if (energy <= 0.) return weight1;
+    return (energy1 * weight1 + energy2 * weight2) / energy;
+}
+
+/**
+ * @brief Finds the lowest cluster index above `after` that is within the thresholds.
+ *
+ * @return The cluster index, or -1 if there is none.
+ */
+G4int HitClusterer::FindCluster(const G4ThreeVector& position, G4double time, G4int after) const {
+    if (!fUseGrid) return -1;
+
+    std::int64_t ix, iy, iz;
+    CellIndices(position, ix, iy, iz);
+
+    G4int best = -1;
+    for (std::int64_t dx = -1; dx <= 1; ++dx) {
+        for (std::int64_t dy = -1; dy <= 1; ++dy) {
+            for (std::int64_t dz = -1; dz <= 1; ++dz) {
+                for (G4int c = LookupCellHead(MakeKey(ix + dx, iy + dy, iz + dz)); c >= 0; c = fNextInCell[c]) {
+                    if (c <= after || (best >= 0 && c >= best)) continue;
+                    if (IsClose(fClusters[c], position, time)) best = c;
+                }
+            }
+        }
+    }
+    return best;
+}
+
+G4bool HitClusterer::IsClose(const Cluster& cluster, const G4ThreeVector& position, G4double time) const {
+    return (position - cluster.position).mag() < fSpatialThreshold &&
+           std::fabs(time - cluster.time) < fTimeThreshold;
+}
+
+void HitClusterer::CellIndices(const G4ThreeVector& position, std::int64_t& ix, std::int64_t& iy, std::int64_t& iz) const {
+    auto index = [this](G4double x) {
+        G4double cell = std::floor(x / fSpatialThreshold);
+        cell = std::max(std::min(cell, G4double(kMaxCellIndex)), -G4double(kMaxCellIndex));
+        return static_cast<std::int64_t>(cell);
+    };
+    ix = index(position.x());
+    iy = index(position.y());
+    iz = index(position.z());
+}
+
+HitClusterer::CellKey HitClusterer::MakeKey(std::int64_t ix, std::int64_t iy, std::int64_t iz) {
+    return (CellKey(ix & kCellMask) << 42) | (CellKey(iy & kCellMask) << 21) | CellKey(iz & kCellMask);
+}
+
+/**
+ * @brief Returns the slot of a key in the hash table, or the empty slot where it would go.
+ */
+size_t HitClusterer::FindSlot(CellKey key) const {
+    size_t mask = fTableKeys.size() - 1;
+    // mix the bits, neighbouring cells differ only in the low bits of each index
+    size_t slot = static_cast<size_t>((key * 0x9E3779B97F4A7C15ULL) >> 32) & mask;
+    while (fTableKeys[slot] != kEmptyKey && fTableKeys[slot] != key) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+G4int HitClusterer::LookupCellHead(CellKey key) const {
+    size_t slot = FindSlot(key);
+    return fTableKeys[slot] == key ? fTableHeads[slot] : -1;
+}
+
+G4int& HitClusterer::CellHead(CellKey key) {
+    size_t slot = FindSlot(key);
+    if (fTableKeys[slot] != key) {
+        if (2 * (fTableUsed + 1) > fTableKeys.size()) {
+            GrowTable();
+            slot = FindSlot(key);
+        }
+        fTableKeys[slot] = key;
+        fTableHeads[slot] = -1;
+        fTableUsed++;
+    }
+    return fTableHeads[slot];
+}
+
+void HitClusterer::GrowTable() {
+    std::vector<CellKey> oldKeys(fTableKeys.size() * 2, kEmptyKey);
+    std::vector<G4int> oldHeads(fTableHeads.size() * 2, -1);
+    // the new (larger, empty) table becomes the current one
+    oldKeys.swap(fTableKeys);
+    oldHeads.swap(fTableHeads);
+    for (size_t i = 0; i < oldKeys.size(); ++i) {
+        if (oldKeys[i] == kEmptyKey) continue;
+        size_t slot = FindSlot(oldKeys[i]);
+        fTableKeys[slot] = oldKeys[i];
+        fTableHeads[slot] = oldHeads[i];
+    }
+}
+
+void HitClusterer::InsertInGrid(G4int index) {
+    std::int64_t ix, iy, iz;
+    CellIndices(fClusters[index].position, ix, iy, iz);
+    CellKey key = MakeKey(ix, iy, iz);
+    G4int& head = CellHead(key);
+    fClusterCell[index] = key;
+    fNextInCell[index] = head;
+    head = index;
+}
+
+void HitClusterer::RemoveFromGrid(G4int index) {
+    size_t slot = FindSlot(fClusterCell[index]);
+    if (fTableKeys[slot] != fClusterCell[index]) return;
+
+    G4int* link = &fTableHeads[slot];
+    while (*link >= 0 && *link != index) {
+        link = &fNextInCell[*link];
+    }
+    if (*link == index) *link = fNextInCell[index];
+    fNextInCell[index] = -1;
+}
+
+} // namespace G4Sim
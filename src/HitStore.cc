@@ -0,0 +1,72 @@
+#include "HitStore.hh"
+
+#include <algorithm>
+
+/**
+ * @namespace G4Sim
+ * @brief Namespace for the G4Sim library.
+/*/
+namespace G4Sim {
+
+namespace {
+    const size_t kInitialCapacity = 1024;
+}
+
+/**
+ * @brief Constructs an empty HitStore with room for a typical event.
+ */
+HitStore::HitStore() {
+    fCapacity = kInitialCapacity;
+    fDoubleArena.resize(kNDoubleFields * fCapacity);
+    fIntArena.resize(kNIntFields * fCapacity);
+}
+
+/**
+ * @brief Appends a hit to the store.
+ */
+void HitStore::Add(G4double energyDeposit, const G4ThreeVector& position, G4double time, G4int trackID, G4int parentID,
+                   const G4ThreeVector& momentum, G4int particleID, G4int processID,
+                   G4double particleEnergy0, G4double particleEnergy1, G4double weight) {
+    if (fSize == fCapacity) Grow();
+
+    size_t i = fSize++;
+    DoubleField(kEnergyDeposit)[i] = energyDeposit;
+    DoubleField(kX)[i] = position.x();
+    DoubleField(kY)[i] = position.y();
+    DoubleField(kZ)[i] = position.z();
+    DoubleField(kTime)[i] = time;
+    DoubleField(kPx)[i] = momentum.x();
+    DoubleField(kPy)[i] = momentum.y();
+    DoubleField(kPz)[i] = momentum.z();
+    DoubleField(kParticleEnergy0)[i] = particleEnergy0;
+    DoubleField(kParticleEnergy1)[i] = particleEnergy1;
+    DoubleField(kWeight)[i] = weight;
+    IntField(kTrackID)[i] = trackID;
+    IntField(kParentID)[i] = parentID;
+    IntField(kParticleID)[i] = particleID;
+    IntField(kProcessID)[i] = processID;
+}
+
+/**
+ * @brief Doubles the capacity of the arena buffers.
+ *
+ * The fields are laid out one after the other, so every field moves to its new offset.
+ */
+void HitStore::Grow() {
+    size_t newCapacity = 2 * fCapacity;
+    std::vector<G4double> doubleArena(kNDoubleFields * newCapacity);
+    std::vector<G4int> intArena(kNIntFields * newCapacity);
+
+    for (G4int field = 0; field < kNDoubleFields; ++field) {
+        std::copy_n(DoubleField(field), fSize, doubleArena.data() + field * newCapacity);
+    }
+    for (G4int field = 0; field < kNIntFields; ++field) {
+        std::copy_n(IntField(field), fSize, intArena.data() + field * newCapacity);
+    }
+
+    fDoubleArena.swap(doubleArena);
+    fIntArena.swap(intArena);
+    fCapacity = newCapacity;
+}
+
+} // namespace G4Sim
@@ -1,6 +1,7 @@
 #include "Materials.hh"
 
 #include "Materials.hh"
+#include "PhaseTimers.hh"
 #include "G4NistManager.hh"
 #include "G4Material.hh"
 #include "G4PhysicalConstants.hh"
@@ -114,6 +115,7 @@ Materials::~Materials()
  * @endcode
  */
 void Materials::DefineMaterials() {
+    PhaseTimer timer(PhaseTimers::Instance(), PhaseTimers::kMaterials);
     G4cout << "Materials::DefineMaterials" << G4endl;
 
     // Get NIST material manager
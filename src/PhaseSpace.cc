@@ -0,0 +1,190 @@
+#include "PhaseSpace.hh"
+
+#include "G4Threading.hh"
+#include "G4ios.hh"
+#include "globals.hh"
+
+#include <cstring>
+
+// records are written from memory as they are, the format is little endian
+#if !defined(__BYTE_ORDER__) || __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "The phase space files require a little endian host"
+#endif
+
+/**
+ * @namespace G4Sim
+ * @brief Namespace for the G4Sim library.
+/*/
+namespace G4Sim {
+
+namespace {
+
+const char kMagic[8] = {'X', 'A', 'M', 'S', 'P', 'S', '0', '1'};
+const size_t kBufferSize = 4096;  // records per write
+
+struct Header {
+    char magic[8];
+    std::uint32_t recordSize;
+    std::uint32_t reserved;
+};
+static_assert(sizeof(Header) == 16, "the phase space header must be 16 bytes");
+
+} // namespace
+
+/**
+ * @brief Opens the phase space file of this thread.
+ *
+ * @param fileName The name given with /phaseSpace/record; the thread suffix and the .xps extension are added.
+ */
+PhaseSpaceWriter::PhaseSpaceWriter(const G4String& fileName) {
+    fFileName = MakeFileName(fileName);
+    fFile.open(fFileName, std::ios::binary | std::ios::trunc);
+    if (!fFile) {
+        G4ExceptionDescription msg;
+        msg << "Cannot open phase space file " << fFileName << G4endl;
+        G4Exception("PhaseSpaceWriter::PhaseSpaceWriter()", "PhaseSpace0001", FatalException, msg);
+    }
+
+    Header header;
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.recordSize = sizeof(PhaseSpaceRecord);
+    header.reserved = 0;
+    fFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    fBuffer.reserve(kBufferSize);
+
+    G4cout << "PhaseSpaceWriter: writing " << fFileName << G4endl;
+}
+
+PhaseSpaceWriter::~PhaseSpaceWriter() {
+    Close();
+}
+
+/**
+ * @brief Returns the file name of the phase space file of this thread.
+ *
+ * @param fileName The file name, with or without the .xps extension.
+ * @return The file name with the thread suffix on worker threads and the .xps extension.
+ */
+G4String PhaseSpaceWriter::MakeFileName(const G4String& fileName) {
+    G4String base = fileName;
+    const G4String extension = ".xps";
+    if (base.size() > extension.size() &&
+        base.compare(base.size() - extension.size(), extension.size(), extension) == 0) {
+        base = base.substr(0, base.size() - extension.size());
+    }
+    if (G4Threading::IsWorkerThread()) {
+        base += "_t" + std::to_string(G4Threading::G4GetThreadId());
+    }
+    return base + extension;
+}
+
+void PhaseSpaceWriter::Write(const PhaseSpaceRecord& record) {
+    fBuffer.push_back(record);
+    fNRecords++;
+    if (fBuffer.size() >= kBufferSize) Flush();
+}
+
+void PhaseSpaceWriter::Flush() {
+    if (fBuffer.empty()) return;
+    fFile.write(reinterpret_cast<const char*>(fBuffer.data()), fBuffer.size() * sizeof(PhaseSpaceRecord));
+    fBuffer.clear();
+}
+
+/**
+ * @brief Writes the buffered records and closes the file.
+ */
+void PhaseSpaceWriter::Close() {
+    if (!fFile.is_open()) return;
+    Flush();
+    fFile.close();
+    G4cout << "PhaseSpaceWriter: " << fNRecords << " particles written to " << fFileName << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PhaseSpaceReader* PhaseSpaceReader::Instance() {
+    static PhaseSpaceReader instance;
+    return &instance;
+}
+
+/**
+ * @brief Sets the files to replay and the reuse factor.
+ *
+ * Every thread calls this with the same arguments; only the first call opens the files, and a later run with the
+ * same files continues where the previous one stopped. Other files or another reuse factor start from the beginning.
+ *
+ * @param fileNames The phase space files, read in this order.
+ * @param reuse The number of times every recorded event is replayed.
+ */
+void PhaseSpaceReader::Open(const std::vector<G4String>& fileNames, G4int reuse) {
+    G4AutoLock lock(&fMutex);
+    if (fileNames == fFileNames && reuse == fReuse) return;
+
+    fFileNames = fileNames;
+    fReuse = reuse > 0 ? reuse : 1;
+    fEvent.clear();
+    fNUses = 0;
+    fHasNext = false;
+    if (!fFileNames.empty() && OpenFile(0)) {
+        fHasNext = ReadRecord(fNext);
+    }
+}
+
+G4bool PhaseSpaceReader::OpenFile(size_t index) {
+    if (fFile.is_open()) fFile.close();
+    fFileIndex = index;
+    if (index >= fFileNames.size()) return false;
+
+    fFile.open(fFileNames[index], std::ios::binary);
+    Header header;
+    if (!fFile || !fFile.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.recordSize != sizeof(PhaseSpaceRecord)) {
+        G4ExceptionDescription msg;
+        msg << "Cannot read phase space file " << fFileNames[index] << G4endl;
+        G4Exception("PhaseSpaceReader::OpenFile()", "PhaseSpace0002", FatalException, msg);
+        return false;
+    }
+    G4cout << "PhaseSpaceReader: reading " << fFileNames[index] << G4endl;
+    return true;
+}
+
+/**
+ * @brief Reads the next record, continuing with the next file at the end of a file.
+ */
+G4bool PhaseSpaceReader::ReadRecord(PhaseSpaceRecord& record) {
+    while (fFile.is_open()) {
+        if (fFile.read(reinterpret_cast<char*>(&record), sizeof(record))) return true;
+        OpenFile(fFileIndex + 1);
+    }
+    return false;
+}
+
+/**
+ * @brief Returns the particles of the next replayed event, with the weights divided by the reuse factor.
+ *
+ * @param records Filled with the particles of the event.
+ * @return false when all recorded events have been replayed.
+ */
+G4bool PhaseSpaceReader::NextEvent(std::vector<PhaseSpaceRecord>& records) {
+    G4AutoLock lock(&fMutex);
+
+    if (fEvent.empty() || fNUses >= fReuse) {
+        fEvent.clear();
+        fNUses = 0;
+        if (!fHasNext) return false;
+
+        // the consecutive records of one event of one file
+        size_t fileIndex = fFileIndex;
+        fEvent.push_back(fNext);
+        while ((fHasNext = ReadRecord(fNext)) && fFileIndex == fileIndex && fNext.eventID == fEvent.front().eventID) {
+            fEvent.push_back(fNext);
+        }
+    }
+
+    fNUses++;
+    records = fEvent;
+    for (PhaseSpaceRecord& record : records) record.weight /= fReuse;
+    return true;
+}
+
+} // namespace G4Sim
@@ -0,0 +1,291 @@
+#include "PhaseTimers.hh"
+
+#include "G4Threading.hh"
+#include "G4VStateDependent.hh"
+#include "G4ios.hh"
+
+#include "nlohmann/json.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * @namespace G4Sim
+ * @brief Namespace for the G4Sim library.
+/*/
+namespace G4Sim {
+
+std::atomic<G4bool> PhaseTimers::fEnabled{false};
+
+namespace {
+
+// The timers of all threads. They are owned here and not by the threads, because the consumer thread of the
+// event pipeline ends before the master writes the report.
+std::mutex& RegistryMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+std::vector<std::unique_ptr<PhaseTimers>>& Registry() {
+    static std::vector<std::unique_ptr<PhaseTimers>> registry;
+    return registry;
+}
+
+/**
+ * @brief Adds the time that a thread spends in the G4State_Init state to its initialization phase.
+ */
+class InitializationWatcher : public G4VStateDependent {
+public:
+    explicit InitializationWatcher(PhaseTimers* timers) : fTimers(timers) {}
+
+    G4bool Notify(G4ApplicationState previousState, G4ApplicationState requestedState) override {
+        if (requestedState == G4State_Init && previousState != G4State_Init) {
+            fStart = PhaseTimers::Clock::now();
+        } else if (previousState == G4State_Init && requestedState != G4State_Init) {
+            fTimers->Add(PhaseTimers::kInitialization,
+                         std::chrono::duration<G4double, std::nano>(PhaseTimers::Clock::now() - fStart).count());
+        }
+        return true;
+    }
+
+private:
+    PhaseTimers* fTimers;
+    PhaseTimers::Clock::time_point fStart;
+};
+
+} // namespace
+
+PhaseTimers::PhaseTimers() {
+    if (G4Threading::IsWorkerThread()) {
+        fName = "worker " + std::to_string(G4Threading::G4GetThreadId());
+    } else {
+        fName = "master";
+    }
+}
+
+/**
+ * @brief Returns the timers of the calling thread, creating them on first use.
+ */
+PhaseTimers* PhaseTimers::Instance() {
+    static G4ThreadLocal PhaseTimers* instance = nullptr;
+    if (!instance) instance = Create("");
+    return instance;
+}
+
+/**
+ * @brief Creates timers that are not bound to the calling thread, owned by the registry.
+ *
+ * The caller keeps them for a thread that is started again in every run, and only one thread may use them at a
+ * time.
+ *
+ * @param name The name of the timers in the report, empty for the name of the calling thread.
+ */
+PhaseTimers* PhaseTimers::Create(const G4String& name) {
+    auto* timers = new PhaseTimers();
+    if (!name.empty()) timers->fName = name;
+    std::lock_guard<std::mutex> lock(RegistryMutex());
+    Registry().emplace_back(timers);
+    return timers;
+}
+
+const char* PhaseTimers::GetPhaseName(Phase phase) {
+    switch (phase) {
+        case kConstruct:      return "construct";
+        case kMaterials:      return "materials";
+        case kInitialization: return "initialization";
+        case kEvent:          return "event";
+        case kTransport:      return "transport";
+        case kProcessHits:    return "process_hits";
+        case kClustering:     return "clustering";
+        case kOutput:         return "output";
+        default:              return "unknown";
+    }
+}
+
+/**
+ * @brief Times the G4State_Init state of the calling thread. Must be called on every Geant4 thread before its
+ * run manager is initialized, e.g. from the ActionInitialization.
+ */
+void PhaseTimers::WatchInitialization() {
+    static G4ThreadLocal std::unique_ptr<InitializationWatcher> watcher;
+    if (!watcher) watcher = std::make_unique<InitializationWatcher>(Instance());
+}
+
+/**
+ * @brief Adds a time to a phase.
+ *
+ * One time phases are added directly. The per event phases are summed for the current event and become one
+ * sample at EndEvent().
+ *
+ * @param phase The phase.
+ * @param nanoseconds The time in ns.
+ */
+void PhaseTimers::Add(Phase phase, G4double nanoseconds) {
+    if (phase <= kInitialization) {
+        fStatistics[phase].total += nanoseconds;
+        fStatistics[phase].calls++;
+        return;
+    }
+    fEventTime[phase] += nanoseconds;
+    fEventTimed[phase] = true;
+    fStatistics[phase].calls++;
+}
+
+/**
+ * @brief Marks the start of an event on a tracking thread.
+ */
+void PhaseTimers::BeginEvent() {
+    if (!IsEnabled()) return;
+    fInEvent = true;
+    fEventStart = Clock::now();
+}
+
+/**
+ * @brief Turns the times of the current event into samples.
+ *
+ * On a tracking thread this also samples the event time and the transport time. The consumer thread of the event
+ * pipeline calls it after each record, without BeginEvent().
+ */
+void PhaseTimers::EndEvent() {
+    if (fInEvent) {
+        G4double eventTime = std::chrono::duration<G4double, std::nano>(Clock::now() - fEventStart).count();
+        G4double transportTime = eventTime - fEventTime[kProcessHits] - fEventTime[kClustering] - fEventTime[kOutput];
+        fStatistics[kEvent].calls++;
+        fStatistics[kTransport].calls++;
+        Sample(kEvent, eventTime);
+        Sample(kTransport, std::max(transportTime, 0.));
+        fInEvent = false;
+    }
+    for (size_t phase = kProcessHits; phase < kNPhases; ++phase) {
+        if (fEventTimed[phase]) Sample(static_cast<Phase>(phase), fEventTime[phase]);
+        fEventTime[phase] = 0.;
+        fEventTimed[phase] = false;
+    }
+}
+
+void PhaseTimers::Sample(Phase phase, G4double nanoseconds) {
+    Statistics& statistics = fStatistics[phase];
+    statistics.total += nanoseconds;
+    statistics.samples++;
+    statistics.maximum = std::max(statistics.maximum, nanoseconds);
+
+    size_t bin = 0;
+    if (nanoseconds > 1.) {
+        bin = std::min(static_cast<size_t>(std::log2(nanoseconds) * kBinsPerOctave), kNBins - 1);
+    }
+    statistics.histogram[bin]++;
+}
+
+void PhaseTimers::Reset() {
+    for (size_t phase = kEvent; phase < kNPhases; ++phase) {
+        fStatistics[phase] = Statistics();
+        fEventTime[phase] = 0.;
+        fEventTimed[phase] = false;
+    }
+    fInEvent = false;
+}
+
+/**
+ * @brief Resets the per event phases of all threads.
+ *
+ * Called by the master at the start of a run, when the worker threads are not processing events.
+ */
+void PhaseTimers::ResetRun() {
+    std::lock_guard<std::mutex> lock(RegistryMutex());
+    for (auto& timers : Registry()) timers->Reset();
+}
+
+/**
+ * @brief Merges the timers of all threads and writes them as a JSON report.
+ *
+ * Called by the master at the end of a run, after the worker threads have finished their events. For every phase
+ * the report has the total time summed over the threads, and for the per event phases the number of events, the
+ * mean, the 50%, 90% and 99% percentiles (estimated from the histograms, within about 5%) and the maximum. The
+ * fraction is the share of the summed event time of the tracking threads.
+ *
+ * @param fileName The name of the report.
+ * @param runID The run ID.
+ * @param nEvents The number of events of the run.
+ * @param wallTime The wall time of the event loop in s.
+ */
+void PhaseTimers::WriteReport(const G4String& fileName, G4int runID, G4int nEvents, G4double wallTime) {
+    std::lock_guard<std::mutex> lock(RegistryMutex());
+
+    std::array<Statistics, kNPhases> merged;
+    nlohmann::json threads = nlohmann::json::array();
+    for (const auto& timers : Registry()) {
+        nlohmann::json thread;
+        thread["name"] = timers->fName;
+        G4bool used = false;
+        for (size_t phase = 0; phase < kNPhases; ++phase) {
+            const Statistics& statistics = timers->fStatistics[phase];
+            if (statistics.calls == 0) continue;
+            used = true;
+            thread[GetPhaseName(static_cast<Phase>(phase))] = statistics.total * 1e-9;
+
+            Statistics& total = merged[phase];
+            total.total += statistics.total;
+            total.calls += statistics.calls;
+            total.samples += statistics.samples;
+            total.maximum = std::max(total.maximum, statistics.maximum);
+            for (size_t bin = 0; bin < kNBins; ++bin) total.histogram[bin] += statistics.histogram[bin];
+        }
+        if (used) threads.push_back(thread);
+    }
+
+    auto percentile = [](const Statistics& statistics, G4double fraction) {
+        std::uint64_t target = static_cast<std::uint64_t>(std::ceil(fraction * statistics.samples));
+        std::uint64_t sum = 0;
+        for (size_t bin = 0; bin < kNBins; ++bin) {
+            sum += statistics.histogram[bin];
+            if (sum >= target && sum > 0) {
+                return std::min(std::exp2((bin + 0.5) / kBinsPerOctave), statistics.maximum);
+            }
+        }
+        return statistics.maximum;
+    };
+
+    nlohmann::json report;
+    report["run"] = runID;
+    report["events"] = nEvents;
+    report["wall_time_s"] = wallTime;
+    report["events_per_second"] = wallTime > 0. ? nEvents / wallTime : 0.;
+
+    nlohmann::json phases;
+    const G4double eventTime = merged[kEvent].total;
+    for (size_t phase = 0; phase < kNPhases; ++phase) {
+        const Statistics& statistics = merged[phase];
+        nlohmann::json entry;
+        entry["total_s"] = statistics.total * 1e-9;
+        entry["calls"] = statistics.calls;
+        if (phase > kInitialization) {
+            entry["events"] = statistics.samples;
+            if (statistics.samples > 0) {
+                entry["mean_us"] = statistics.total / statistics.samples * 1e-3;
+                entry["p50_us"] = percentile(statistics, 0.50) * 1e-3;
+                entry["p90_us"] = percentile(statistics, 0.90) * 1e-3;
+                entry["p99_us"] = percentile(statistics, 0.99) * 1e-3;
+                entry["max_us"] = statistics.maximum * 1e-3;
+            }
+            if (eventTime > 0.) entry["fraction"] = statistics.total / eventTime;
+        }
+        phases[GetPhaseName(static_cast<Phase>(phase))] = entry;
+    }
+    report["phases"] = phases;
+    report["threads"] = threads;
+
+    std::ofstream file(fileName);
+    if (!file) {
+        G4cerr << "PhaseTimers::WriteReport: Error: cannot write " << fileName << G4endl;
+        return;
+    }
+    file << report.dump(2) << std::endl;
+    G4cout << "PhaseTimers::WriteReport: " << nEvents << " events in " << wallTime << " s, timing report written to "
+           << fileName << G4endl;
+}
+
+} // namespace G4Sim
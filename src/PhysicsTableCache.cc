@@ -0,0 +1,160 @@
+#include "PhysicsTableCache.hh"
+#include "GeometryCache.hh"
+
+#include "G4Element.hh"
+#include "G4EmParameters.hh"
+#include "G4Material.hh"
+#include "G4ProductionCuts.hh"
+#include "G4Region.hh"
+#include "G4RegionStore.hh"
+#include "G4RunManager.hh"
+#include "G4VModularPhysicsList.hh"
+#include "G4VPhysicsConstructor.hh"
+#include "G4ios.hh"
+
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <sstream>
+
+#include <unistd.h>
+
+/**
+ * @namespace G4Sim
+ * @brief Namespace for the G4Sim library.
+/*/
+namespace G4Sim {
+
+namespace {
+
+G4VUserPhysicsList* GetPhysicsList() {
+    return const_cast<G4VUserPhysicsList*>(G4RunManager::GetRunManager()->GetUserPhysicsList());
+}
+
+// the data sets of Geant4; their directories carry the version (e.g. G4EMLOW8.5)
+const char* const kDataSetVariables[] = {
+    "G4LEDATA", "G4LEVELGAMMADATA", "G4RADIOACTIVEDATA", "G4PARTICLEXSDATA", "G4NEUTRONHPDATA", "G4ENSDFSTATEDATA",
+    "G4PIIDATA", "G4SAIDXSDATA", "G4ABLADATA", "G4INCLDATA", "G4REALSURFACEDATA", "G4CHANNELINGDATA"};
+
+} // namespace
+
+PhysicsTableCache* PhysicsTableCache::Instance() {
+    static PhysicsTableCache* instance = new PhysicsTableCache();  // registered with the state manager of this thread
+    return instance;
+}
+
+/**
+ * @brief Retrieves the tables before they are built at the first run, and stores them once they are built.
+ */
+G4bool PhysicsTableCache::Notify(G4ApplicationState previousState, G4ApplicationState requestedState) {
+    if (fDirectory.empty() || fDone) return true;
+
+    if (previousState == G4State_Idle && requestedState == G4State_Init) {
+        // start of the first run, /run/initialize comes from PreInit
+        Retrieve();
+    } else if (requestedState == G4State_GeomClosed && fStorePending) {
+        Store();
+    }
+    return true;
+}
+
+/**
+ * @brief Computes the key of the physics tables.
+ *
+ * Geant4 only checks the materials and cuts of retrieved tables, so everything else the tables depend on is in the
+ * key: the EM options (/process/em/ and /process/eLoss/, as printed by G4EmParameters) and the data sets.
+ *
+ * @return The hash of the materials (name, density and element fractions), the production cuts per region, the
+ *         names of the physics constructors, the EM parameters and the data set directories, see
+ *         GeometryCache::Hash().
+ */
+std::uint64_t PhysicsTableCache::ComputeKey() {
+    std::ostringstream settings;
+    settings << std::setprecision(17);
+
+    for (const G4Material* material : *G4Material::GetMaterialTable()) {
+        settings << "material " << material->GetName() << ' ' << material->GetDensity() << ' '
+                 << material->GetTemperature() << ' ' << material->GetPressure();
+        const G4double* fractions = material->GetFractionVector();
+        for (size_t i = 0; i < material->GetNumberOfElements(); ++i) {
+            settings << ' ' << material->GetElement(i)->GetName() << ' ' << fractions[i];
+        }
+        settings << '\n';
+    }
+
+    for (const G4Region* region : *G4RegionStore::GetInstance()) {
+        settings << "region " << region->GetName();
+        const G4ProductionCuts* cuts = region->GetProductionCuts();
+        if (cuts) {
+            for (G4int i = 0; i < 4; ++i) settings << ' ' << cuts->GetProductionCut(i);
+        }
+        settings << '\n';
+    }
+
+    const auto* modularPhysicsList = dynamic_cast<const G4VModularPhysicsList*>(GetPhysicsList());
+    if (modularPhysicsList) {
+        for (G4int i = 0; modularPhysicsList->GetPhysics(i); ++i) {
+            settings << "physics " << modularPhysicsList->GetPhysics(i)->GetPhysicsName() << '\n';
+        }
+    }
+
+    G4EmParameters::Instance()->StreamInfo(settings);
+
+    for (const char* variable : kDataSetVariables) {
+        const char* path = std::getenv(variable);
+        settings << "data " << variable << ' ' << (path ? std::filesystem::path(path).lexically_normal().string() : "") << '\n';
+    }
+
+    return GeometryCache::Hash({}, settings.str());
+}
+
+/**
+ * @brief Lets the physics list retrieve the tables if the cache has an entry, otherwise stores them later.
+ */
+void PhysicsTableCache::Retrieve() {
+    std::ostringstream name;
+    name << fDirectory << "/physics_" << std::hex << std::setw(16) << std::setfill('0') << ComputeKey();
+    fEntryName = name.str();
+
+    if (std::filesystem::is_directory(fEntryName)) {
+        G4cout << "PhysicsTableCache::Retrieve: retrieving the physics tables from " << fEntryName << G4endl;
+        GetPhysicsList()->SetPhysicsTableRetrieved(fEntryName);
+        fDone = true;
+    } else {
+        G4cout << "PhysicsTableCache::Retrieve: no entry " << fEntryName << ", the tables are stored after they are built" << G4endl;
+        fStorePending = true;
+    }
+}
+
+/**
+ * @brief Stores the tables in a temporary directory and renames it to the entry.
+ */
+void PhysicsTableCache::Store() {
+    fStorePending = false;
+    fDone = true;
+
+    std::error_code error;
+    std::filesystem::create_directories(fDirectory, error);
+    G4String temporaryName = fEntryName + ".tmp" + std::to_string(::getpid());
+    std::filesystem::create_directories(temporaryName, error);
+    if (error) {
+        G4cerr << "PhysicsTableCache::Store: Warning: cannot create " << temporaryName << G4endl;
+        return;
+    }
+
+    if (!GetPhysicsList()->StorePhysicsTable(temporaryName)) {
+        G4cerr << "PhysicsTableCache::Store: Warning: cannot store the physics tables in " << temporaryName << G4endl;
+        std::filesystem::remove_all(temporaryName, error);
+        return;
+    }
+
+    // fails if another job stored the entry first, its tables are the same
+    std::filesystem::rename(temporaryName, fEntryName, error);
+    if (error) {
+        std::filesystem::remove_all(temporaryName, error);
+        return;
+    }
+    G4cout << "PhysicsTableCache::Store: physics tables stored in " << fEntryName << G4endl;
+}
+
+} // namespace G4Sim
@@ -1,4 +1,7 @@
 #include "PrimaryGeneratorAction.hh"
+#include "PrimaryGeneratorMessenger.hh"
+#include "PhaseSpace.hh"
+#include "EventSeeder.hh"
 
 #include "G4LogicalVolumeStore.hh"
 #include "G4LogicalVolume.hh"
@@ -7,6 +10,10 @@
 #include "G4GeneralParticleSource.hh"
 #include "G4ParticleTable.hh"
 #include "G4ParticleDefinition.hh"
+#include "G4IonTable.hh"
+#include "G4Event.hh"
+#include "G4PrimaryVertex.hh"
+#include "G4PrimaryParticle.hh"
 #include "G4SystemOfUnits.hh"
 #include "Randomize.hh"
 
@@ -23,12 +30,14 @@
 PrimaryGeneratorAction::PrimaryGeneratorAction()
 {
   fParticleGun  = new G4GeneralParticleSource();
+  fMessenger = new G4Sim::PrimaryGeneratorMessenger(this);
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 PrimaryGeneratorAction::~PrimaryGeneratorAction()
 {
+  delete fMessenger;
   delete fParticleGun;
 }
 
@@ -42,9 +51,52 @@ PrimaryGeneratorAction::~PrimaryGeneratorAction()
 void PrimaryGeneratorAction::GeneratePrimaries(G4Event* anEvent)
 {
   //this function is called at the begining of event
+  G4Sim::EventSeeder::Instance()->SeedEvent(anEvent->GetEventID());
+  if (!fPhaseSpaceFiles.empty()) {
+    GeneratePhaseSpacePrimaries(anEvent);
+    return;
+  }
   fParticleGun->GeneratePrimaryVertex(anEvent);
 }
 
+/**
+ * @brief Replays the particles of the next recorded event of the phase space files.
+ *
+ * When all recorded events have been replayed the event is aborted, and so is the run of this thread.
+ *
+ * @param anEvent Pointer to the G4Event object representing the current event.
+ */
+void PrimaryGeneratorAction::GeneratePhaseSpacePrimaries(G4Event* anEvent)
+{
+  G4Sim::PhaseSpaceReader* reader = G4Sim::PhaseSpaceReader::Instance();
+  reader->Open(fPhaseSpaceFiles, fPhaseSpaceReuse);
+  if (!reader->NextEvent(fPhaseSpaceEvent)) {
+    G4cout << "PrimaryGeneratorAction: all phase space events replayed, stopping the run" << G4endl;
+    anEvent->SetEventAborted();
+    G4RunManager::GetRunManager()->AbortRun(true);
+    return;
+  }
+
+  G4ParticleTable* particleTable = G4ParticleTable::GetParticleTable();
+  for (const G4Sim::PhaseSpaceRecord& record : fPhaseSpaceEvent) {
+    G4ParticleDefinition* particle = particleTable->FindParticle(record.pdgCode);
+    if (!particle && record.pdgCode > 1000000000) particle = G4IonTable::GetIonTable()->GetIon(record.pdgCode);
+    if (!particle) {
+      G4cerr << "PrimaryGeneratorAction: Warning: unknown PDG code " << record.pdgCode << " in the phase space" << G4endl;
+      continue;
+    }
+
+    auto* primary = new G4PrimaryParticle(particle);
+    primary->SetKineticEnergy(record.kineticEnergy);
+    primary->SetMomentumDirection(G4ThreeVector(record.dx, record.dy, record.dz));
+    primary->SetWeight(record.weight);
+
+    auto* vertex = new G4PrimaryVertex(G4ThreeVector(record.x, record.y, record.z), record.time);
+    vertex->SetPrimary(primary);
+    anEvent->AddPrimaryVertex(vertex);
+  }
+}
+
 G4double PrimaryGeneratorAction::GetInitialEnergy() const {
     return fInitialEnergy;
 }
@@ -0,0 +1,53 @@
+#include "PrimaryGeneratorMessenger.hh"
+#include "PrimaryGeneratorAction.hh"
+
+namespace G4Sim {
+
+/**
+ * @brief Constructs a PrimaryGeneratorMessenger object.
+ *
+ * @param primaryGenerator Pointer to the PrimaryGeneratorAction object.
+ */
+PrimaryGeneratorMessenger::PrimaryGeneratorMessenger(PrimaryGeneratorAction* primaryGenerator)
+    : G4UImessenger(), fPrimaryGenerator(primaryGenerator) {
+
+    fReplayDirectory = new G4UIdirectory("/phaseSpace/replay/");
+    fReplayDirectory->SetGuidance("Use the particles of phase space files as primaries instead of the GPS.");
+
+    fAddFileCmd = new G4UIcmdWithAString("/phaseSpace/replay/addFile", this);
+    fAddFileCmd->SetGuidance("Add a phase space file (.xps) to replay. Files are replayed in the order they are added.");
+    fAddFileCmd->SetParameterName("fileName", false);
+    fAddFileCmd->SetGuidance("Available after /run/initialize, when the primary generators of the threads exist.");
+    fAddFileCmd->AvailableForStates(G4State_Idle);
+
+    fReuseCmd = new G4UIcmdWithAnInteger("/phaseSpace/replay/reuse", this);
+    fReuseCmd->SetGuidance("Replay every recorded event N times, with the weights divided by N.");
+    fReuseCmd->SetParameterName("reuse", false);
+    fReuseCmd->SetRange("reuse>0");
+    fReuseCmd->AvailableForStates(G4State_Idle);
+}
+
+/**
+ * @brief Destructor for the PrimaryGeneratorMessenger class.
+ */
+PrimaryGeneratorMessenger::~PrimaryGeneratorMessenger() {
+    delete fAddFileCmd;
+    delete fReuseCmd;
+    delete fReplayDirectory;
+}
+
+/**
+ * @brief Sets the new value for a given command.
+ *
+ * @param command The command for which the new value is being set.
+ * @param newValue The new value to be set.
+ */
+void PrimaryGeneratorMessenger::SetNewValue(G4UIcommand* command, G4String newValue) {
+    if (command == fAddFileCmd) {
+        fPrimaryGenerator->AddPhaseSpaceFile(newValue);
+    } else if (command == fReuseCmd) {
+        fPrimaryGenerator->SetPhaseSpaceReuse(fReuseCmd->GetNewIntValue(newValue));
+    }
+}
+
+} // namespace G4Sim
@@ -0,0 +1,117 @@
+#include "ProcessPool.hh"
+
+#include "G4ios.hh"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <map>
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/**
+ * @namespace G4Sim
+ * @brief Namespace for the G4Sim library.
+/*/
+namespace G4Sim {
+
+namespace {
+
+// output buffered before the fork would otherwise be written by the master and by every child
+void FlushOutput() {
+    G4cout.flush();
+    G4cerr.flush();
+    std::cout.flush();
+    std::cerr.flush();
+    std::fflush(nullptr);
+}
+
+} // namespace
+
+/**
+ * @brief Constructs the pool.
+ *
+ * @param nProcesses The maximum number of children running at the same time.
+ * @param maxRetries The number of times a failed task is started again.
+ */
+ProcessPool::ProcessPool(G4int nProcesses, G4int maxRetries)
+    : fNProcesses(nProcesses > 0 ? nProcesses : 1), fMaxRetries(maxRetries > 0 ? maxRetries : 0) {}
+
+/**
+ * @brief Runs all tasks, each in its own child process.
+ *
+ * Returns in the master when all tasks are done, and in every child after its task. The caller tells them apart
+ * by the return value; a child should then clean up as at the end of a normal job and exit with childStatus.
+ *
+ * @param nTasks The number of tasks.
+ * @param task Called in the child with the index of the task; returns the exit status of the child.
+ * @param childStatus Set in a child to the status returned by the task.
+ * @return true in the master, false in a child.
+ */
+G4bool ProcessPool::Run(size_t nTasks, const std::function<G4int(size_t)>& task, G4int& childStatus) {
+    fResults.assign(nTasks, Result());
+    std::deque<size_t> pending;
+    for (size_t i = 0; i < nTasks; ++i) pending.push_back(i);
+    std::map<pid_t, size_t> running;
+
+    while (!pending.empty() || !running.empty()) {
+        while (!pending.empty() && static_cast<G4int>(running.size()) < fNProcesses) {
+            size_t index = pending.front();
+            FlushOutput();
+            pid_t pid = ::fork();
+            if (pid == 0) {
+                childStatus = task(index);
+                FlushOutput();
+                return false;
+            }
+            if (pid < 0) {
+                G4cerr << "ProcessPool::Run: Warning: cannot fork: " << std::strerror(errno) << G4endl;
+                if (running.empty()) {
+                    // nothing will finish to free resources, give up on the remaining tasks
+                    pending.clear();
+                }
+                break;
+            }
+            pending.pop_front();
+            fResults[index].attempts++;
+            running[pid] = index;
+            G4cout << "ProcessPool::Run: task " << index << " started in process " << pid
+                   << " (attempt " << fResults[index].attempts << ")" << G4endl;
+        }
+        if (running.empty()) break;
+
+        int status = 0;
+        pid_t pid = ::waitpid(-1, &status, 0);
+        if (pid < 0) {
+            if (errno == EINTR) continue;
+            G4cerr << "ProcessPool::Run: Warning: waitpid failed: " << std::strerror(errno) << G4endl;
+            break;
+        }
+        auto it = running.find(pid);
+        if (it == running.end()) continue;
+        size_t index = it->second;
+        running.erase(it);
+
+        Result& result = fResults[index];
+        result.exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+        result.signal = WIFSIGNALED(status) ? WTERMSIG(status) : 0;
+        result.succeeded = result.exitCode == 0;
+        if (result.succeeded) {
+            G4cout << "ProcessPool::Run: task " << index << " finished" << G4endl;
+        } else if (result.attempts <= fMaxRetries) {
+            G4cerr << "ProcessPool::Run: Warning: task " << index << " failed (exit code " << result.exitCode
+                   << ", signal " << result.signal << "), starting it again" << G4endl;
+            pending.push_back(index);
+        } else {
+            G4cerr << "ProcessPool::Run: Warning: task " << index << " failed (exit code " << result.exitCode
+                   << ", signal " << result.signal << ") after " << result.attempts << " attempts" << G4endl;
+        }
+    }
+    return true;
+}
+
+} // namespace G4Sim
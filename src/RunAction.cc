@@ -29,8 +29,12 @@
 
 #include "RunAction.hh"
 #include "EventAction.hh"	
+#include "SteppingAction.hh"
 #include "PrimaryGeneratorAction.hh"
 #include "DetectorConstruction.hh"
+#include "AnalysisManagerOutput.hh"
+#include "ColumnarOutput.hh"
+#include "RunSummary.hh"
 // #include "Run.hh"
 
 #include "G4RunManager.hh"
@@ -44,7 +48,9 @@
 #include "G4AnalysisManager.hh"
 #include "G4Gamma.hh"
 #include "G4PhysicalConstants.hh"
+#include "G4Threading.hh"
 
+#include <chrono>
 #include <cmath>
 
 /**
@@ -52,6 +58,26 @@
  * @brief Namespace for the G4Sim library.
 /*/
 namespace G4Sim{
+
+namespace {
+
+/**
+ * @brief Returns the name of a report of a run, next to the output file, e.g. "out_timing.json".
+ */
+G4String MakeReportFileName(const G4String& fileName, G4int runID, const G4String& suffix) {
+  G4String base = fileName;
+  for (const G4String extension : {".root", ".xcol"}) {
+    if (base.size() > extension.size() &&
+        base.compare(base.size() - extension.size(), extension.size(), extension) == 0) {
+      base = base.substr(0, base.size() - extension.size());
+    }
+  }
+  if (runID > 0) base += "_run" + std::to_string(runID);
+  return base + suffix;
+}
+
+} // namespace
+
 /**
  * @file RunAction.cc
  * @brief Implementation of the RunAction class.
@@ -88,57 +114,102 @@ RunAction::RunAction(EventAction* eventAction)
  * 
  * It retrieves the initial energy from the primary generator action and prints it to the console.
  * 
- * It also initializes the analysis manager and ntuples.
+ * It also configures the readout of the EventAction of this thread, resolves the termination policies and importances
+ * of the SteppingAction for the current geometry, and initializes the analysis manager and ntuples.
+ * On the master the per event phases of the PhaseTimers and the histograms of the RunSummary are reset.
  * 
  * @param run Pointer to the G4Run object representing the current run.
  */
 void RunAction::BeginOfRunAction(const G4Run*)
 {
 
-  // Get the initial energy from the primary generator action
+  // the master starts the clock of the run, before the workers start their events
+  if (G4Threading::IsMasterThread()) {
+    PhaseTimers::ResetRun();
+    RunSummary::ResetRun();
+    fRunStart = PhaseTimers::Clock::now();
+  }
+
+  // Get the initial energy from the primary generator action (there is none on the master of a multithreaded run)
   const PrimaryGeneratorAction* primaryGeneratorAction = static_cast<const PrimaryGeneratorAction*>(
     G4RunManager::GetRunManager()->GetUserPrimaryGeneratorAction());
 
-  G4cout << "Runaction::BeginOfRunAction: E0 = " << primaryGeneratorAction->GetInitialEnergy() / keV << " keV" << G4endl;
+  if (primaryGeneratorAction) {
+    G4cout << "Runaction::BeginOfRunAction: E0 = " << primaryGeneratorAction->GetInitialEnergy() / keV << " keV" << G4endl;
+  }
+
+  // the ROOT ntuple is booked in the first run and keeps its columns, so its layout cannot change afterwards
+  G4String layout = fEventLayout;
+  if (fOutputFormat != "columnar" && !fNtupleLayout.empty() && layout != fNtupleLayout) {
+    if (G4Threading::IsMasterThread()) {
+      G4ExceptionDescription msg;
+      msg << "The ROOT ntuple was booked with the " << fNtupleLayout << " layout, /run/setEventLayout " << layout
+          << " is ignored for this job" << G4endl;
+      G4Exception("RunAction::BeginOfRunAction()", "Run0001", JustWarning, msg);
+    }
+    layout = fNtupleLayout;
+  }
+
+  // hits collections and clustering parameters of this thread
+  fEventAction->SetSparseLayout(layout == "sparse");
+  fEventAction->ConfigureReadout();
+  if (fSteppingAction) fSteppingAction->ResolvePolicies();
 
   // initialize the analysis manager and ntuples
   InitializeNtuples();
+  fEventAction->StartPipeline();
 
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 RunAction::~RunAction()
 {
+  delete fOutput;
   delete fMessenger;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 /**
- * @brief Initializes the analysis manager and creates event data ntuple.
- * 
- * This function initializes the analysis manager and sets the default file type to "root".
- * It opens the output file specified by `fOutputFileName`.
- * The verbose level is set to 1.
- * Ntuple merging is enabled.
- * Finally, it calls the `DefineEventNtuple()` function to create the event data ntuple.
+ * @brief Creates the output backend and the event data ntuple.
  * 
- * @note This function should be called only in the master thread.
+ * The backend is chosen with /run/setOutputFormat:
+ * - "root": the G4AnalysisManager writes a ROOT file. It is opened on the master and on all worker threads, the
+ *   rows of the workers are merged into the master file at the end of the run.
+ * - "columnar": every thread that processes events writes its own ColumnarOutput file. The master of a
+ *   multithreaded run does not process events and writes no file.
+ *
+ * It opens the output file specified by `fOutputFileName` and calls the `DefineEventNtuple()` function to create
+ * the event data ntuple. The ntuple of a thread is bound to the vectors of the EventAction of that thread.
+ *
+ * With /summary/writeNtuple false no output is opened; the events only go into the RunSummary histograms.
  */
 void RunAction::InitializeNtuples(){
 
-  // Get analysis manager
-  auto analysisManager = G4AnalysisManager::Instance();
-  if (G4Threading::IsMasterThread()) {
-    analysisManager->SetDefaultFileType("root");
-    analysisManager->OpenFile(fOutputFileName);
-    //  
-    analysisManager->SetVerboseLevel(1);
-    // Default settings
-    analysisManager->SetNtupleMerging(true);
-    // Creating event data ntuple
-    DefineEventNtuple();
+  delete fOutput;
+  fOutput = nullptr;
+
+  if (!RunSummary::GetWriteNtuple()) {
+    fEventAction->SetOutput(nullptr);
+    return;
+  }
+
+  if (fOutputFormat == "columnar") {
+    if (G4Threading::IsMultithreadedApplication() && G4Threading::IsMasterThread()) {
+      fEventAction->SetOutput(nullptr);
+      return;
+    }
+    auto compression = (fOutputCompression == "zstd") ? ColumnarOutput::kZstd : ColumnarOutput::kNone;
+    fOutput = new ColumnarOutput(fOutputChunkSize, compression);
+  } else {
+    fOutput = new AnalysisManagerOutput();
+    if (fNtupleLayout.empty()) fNtupleLayout = fEventAction->IsSparseLayout() ? "sparse" : "dense";
   }
+
+  fOutput->OpenFile(fOutputFileName);
+  // Creating event data ntuple
+  DefineEventNtuple();
+  fEventAction->SetOutput(fOutput);
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -146,53 +217,81 @@ void RunAction::InitializeNtuples(){
 /**
  * @brief Defines the event ntuple for data analysis.
  * 
- * This function creates an event ntuple using the G4AnalysisManager class. The ntuple contains columns for storing energy deposition (Edep), x-coordinate (xh), and y-coordinate (yh) of each event. The ntuple is finished and assigned an ID.
+ * This function creates an event ntuple through the output backend. The ntuple contains columns for storing energy deposition (Edep), x-coordinate (xh), and y-coordinate (yh) of each event. The ntuple is finished and assigned an ID.
+ *
+ * With the sparse layout (/run/setEventLayout sparse) the per detector columns only hold the detectors with clusters,
+ * with their index in det, and the always zero nphot and ncomp are left out. The scalar columns keep their IDs in
+ * both layouts.
  */
 void RunAction::DefineEventNtuple(){
-  // Creating ntuple
-  auto analysisManager = G4AnalysisManager::Instance();
 
   G4cout << "RunAction::BeginOfRunAction: Creating event data ntuple" << G4endl;
 
-  eventNtupleId = analysisManager->CreateNtuple("ev", "G4XamsSim ntuple");
-  analysisManager->CreateNtupleDColumn(eventNtupleId, "ev");   // column Id = 0
-  analysisManager->CreateNtupleDColumn(eventNtupleId, "w");    // column Id = 1
-  analysisManager->CreateNtupleDColumn(eventNtupleId, "type"); // column Id = 2
-  analysisManager->CreateNtupleDColumn(eventNtupleId, "xp");   // column Id = 3
-  analysisManager->CreateNtupleDColumn(eventNtupleId, "yp");   // column Id = 4
-  analysisManager->CreateNtupleDColumn(eventNtupleId, "zp");   // column Id = 5
-  analysisManager->CreateNtupleDColumn(eventNtupleId, "eh", fEventAction->GetE()); 
-  analysisManager->CreateNtupleDColumn(eventNtupleId, "xh", fEventAction->GetX()); 
-  analysisManager->CreateNtupleDColumn(eventNtupleId, "yh", fEventAction->GetY()); 
-  analysisManager->CreateNtupleDColumn(eventNtupleId, "zh", fEventAction->GetZ()); 
-  analysisManager->CreateNtupleDColumn(eventNtupleId, "wh", fEventAction->GetW()); 
-  analysisManager->CreateNtupleIColumn(eventNtupleId, "id", fEventAction->GetID()); 
-  analysisManager->CreateNtupleDColumn(eventNtupleId, "edet", fEventAction->GetEdet());
-  analysisManager->CreateNtupleIColumn(eventNtupleId, "ndet", fEventAction->GetNdet());
-  analysisManager->CreateNtupleIColumn(eventNtupleId, "nphot", fEventAction->GetNphot());
-  analysisManager->CreateNtupleIColumn(eventNtupleId, "ncomp", fEventAction->GetNcomp());
-
-  analysisManager->FinishNtuple(eventNtupleId);
-  G4cout <<"RunAction::BeginOfRunAction: Event data ntuple created. ID = "<< eventNtupleId << G4endl;
+  fOutput->CreateNtuple("ev", "G4XamsSim ntuple");
+  fOutput->CreateDColumn("ev");   // column Id = 0
+  fOutput->CreateDColumn("w");    // column Id = 1
+  fOutput->CreateDColumn("type"); // column Id = 2
+  fOutput->CreateDColumn("xp");   // column Id = 3
+  fOutput->CreateDColumn("yp");   // column Id = 4
+  fOutput->CreateDColumn("zp");   // column Id = 5
+  fOutput->CreateDColumn("trig"); // column Id = 6
+  fOutput->CreateDColumn("eh", fEventAction->GetE()); 
+  fOutput->CreateDColumn("xh", fEventAction->GetX()); 
+  fOutput->CreateDColumn("yh", fEventAction->GetY()); 
+  fOutput->CreateDColumn("zh", fEventAction->GetZ()); 
+  fOutput->CreateDColumn("wh", fEventAction->GetW());
+  fOutput->CreateIColumn("id", fEventAction->GetID()); 
+  if (fEventAction->IsSparseLayout()) fOutput->CreateIColumn("det", fEventAction->GetDet());
+  fOutput->CreateDColumn("edet", fEventAction->GetEdet());
+  fOutput->CreateIColumn("ndet", fEventAction->GetNdet());
+  if (!fEventAction->IsSparseLayout()) {
+    fOutput->CreateIColumn("nphot", fEventAction->GetNphot());
+    fOutput->CreateIColumn("ncomp", fEventAction->GetNcomp());
+  }
+
+  fOutput->FinishNtuple();
+  G4cout <<"RunAction::BeginOfRunAction: Event data ntuple created." << G4endl;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 /**
  * @brief This function is called at the end of a run.
- * It saves histograms and ntuple if the current thread is the master thread.
+ * It saves histograms and ntuple. With the ROOT output this hands the ntuple rows of a worker to the master for merging.
+ *
+ * When the timing report is enabled, the master writes it after the output: the EndOfRunAction of the master is
+ * called after all workers have finished. The report of "out.root" is "out_timing.json", and for later runs
+ * "out_run1_timing.json" etc. The histograms of the RunSummary are written in the same way, to "out_summary.json".
  * 
  * @param run Pointer to the G4Run object representing the current run.
  */
 void RunAction::EndOfRunAction(const G4Run* run)
 {
 
+  // finish the events that are still in the pipeline
+  fEventAction->StopPipeline();
+  if (!G4Threading::IsMultithreadedApplication() || G4Threading::IsWorkerThread()) {
+    fEventAction->PrintTriggerSummary();
+  }
+
   // save histograms & ntuple
   //
-  if (G4Threading::IsMasterThread()) {
-      auto analysisManager = G4AnalysisManager::Instance();
-      analysisManager->Write();
-      analysisManager->CloseFile();
+  if (fOutput) {
+    fOutput->Write();
+    fOutput->CloseFile();
+  }
+
+  if (PhaseTimers::IsEnabled() && G4Threading::IsMasterThread()) {
+    G4double wallTime = std::chrono::duration<G4double>(PhaseTimers::Clock::now() - fRunStart).count();
+    G4int runID = run->GetRunID();
+    PhaseTimers::WriteReport(MakeReportFileName(fOutputFileName, runID, "_timing.json"), runID,
+                             run->GetNumberOfEvent(), wallTime);
+  }
+
+  if (RunSummary::IsEnabled() && G4Threading::IsMasterThread()) {
+    G4int runID = run->GetRunID();
+    RunSummary::WriteReport(MakeReportFileName(fOutputFileName, runID, "_summary.json"), runID,
+                            run->GetNumberOfEvent());
   }
 
 }
@@ -1,5 +1,7 @@
 #include "RunActionMessenger.hh"
 #include "RunAction.hh"
+#include "EventSeeder.hh"
+#include "RunSummary.hh"
 
 ///using namespace G4FastSim;
 namespace G4Sim {
@@ -17,17 +19,110 @@ RunActionMessenger::RunActionMessenger(RunAction* action)
     fOutputFileNameCmd->SetParameterName("outputFileName", false);
     fOutputFileNameCmd->SetDefaultValue("G4XamsSim.root");
 
+    fOutputFormatCmd = new G4UIcmdWithAString("/run/setOutputFormat", this);
+    fOutputFormatCmd->SetGuidance("Set the output format.");
+    fOutputFormatCmd->SetGuidance("  root     : ROOT ntuple written by the G4AnalysisManager");
+    fOutputFormatCmd->SetGuidance("  columnar : native columnar file (.xcol) per thread, see analysis/ColumnarReader.py");
+    fOutputFormatCmd->SetParameterName("outputFormat", false);
+    fOutputFormatCmd->SetCandidates("root columnar");
+    fOutputFormatCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    fOutputChunkSizeCmd = new G4UIcmdWithAnInteger("/run/setOutputChunkSize", this);
+    fOutputChunkSizeCmd->SetGuidance("Set the number of events per chunk of the columnar output.");
+    fOutputChunkSizeCmd->SetParameterName("chunkSize", false);
+    fOutputChunkSizeCmd->SetRange("chunkSize>0");
+    fOutputChunkSizeCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    fOutputCompressionCmd = new G4UIcmdWithAString("/run/setOutputCompression", this);
+    fOutputCompressionCmd->SetGuidance("Set the compression of the columnar output (zstd requires a build with WITH_ZSTD).");
+    fOutputCompressionCmd->SetParameterName("compression", false);
+    fOutputCompressionCmd->SetCandidates("none zstd");
+    fOutputCompressionCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    fEventLayoutCmd = new G4UIcmdWithAString("/run/setEventLayout", this);
+    fEventLayoutCmd->SetGuidance("Set the layout of the per detector columns (edet, ndet, nphot, ncomp).");
+    fEventLayoutCmd->SetGuidance("  dense  : one entry per active volume, zero if it has no clusters");
+    fEventLayoutCmd->SetGuidance("  sparse : only the active volumes with clusters, their index in det; no nphot and ncomp");
+    fEventLayoutCmd->SetGuidance("With the root format the layout of the first run with an ntuple is kept for the whole job,");
+    fEventLayoutCmd->SetGuidance("a different layout in a later run is ignored with a warning.");
+    fEventLayoutCmd->SetParameterName("layout", false);
+    fEventLayoutCmd->SetCandidates("dense sparse");
+    fEventLayoutCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    fTimingReportCmd = new G4UIcmdWithABool("/run/timingReport", this);
+    fTimingReportCmd->SetGuidance("Time the phases of each event and write a JSON timing report next to the output file.");
+    fTimingReportCmd->SetParameterName("timingReport", true);
+    fTimingReportCmd->SetDefaultValue(true);
+    fTimingReportCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    fPhysicsTableCacheCmd = new G4UIcmdWithAString("/run/physicsTableCache", this);
+    fPhysicsTableCacheCmd->SetGuidance("Retrieve the physics tables from this directory, or store them there after they are built.");
+    fPhysicsTableCacheCmd->SetGuidance("The entries are keyed by the materials, the production cuts and the physics list.");
+    fPhysicsTableCacheCmd->SetGuidance("Give it before the first /run/beamOn.");
+    fPhysicsTableCacheCmd->SetParameterName("directory", false);
+    fPhysicsTableCacheCmd->SetToBeBroadcasted(false);
+    fPhysicsTableCacheCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    fEventSeedCmd = new G4UIcmdWithAnInteger("/run/eventSeed", this);
+    fEventSeedCmd->SetGuidance("Seed the random engine of every event from this seed and the global event number.");
+    fEventSeedCmd->SetGuidance("The events are then independent of the split into jobs and threads. 0 switches it off.");
+    fEventSeedCmd->SetParameterName("seed", false);
+    fEventSeedCmd->SetRange("seed>=0");
+    fEventSeedCmd->SetToBeBroadcasted(false);
+    fEventSeedCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    fEventOffsetCmd = new G4UIcmdWithAnInteger("/run/eventOffset", this);
+    fEventOffsetCmd->SetGuidance("Set the global event number of the first event of the run.");
+    fEventOffsetCmd->SetGuidance("The global event number is written as event ID and used by /run/eventSeed.");
+    fEventOffsetCmd->SetParameterName("offset", false);
+    fEventOffsetCmd->SetRange("offset>=0");
+    fEventOffsetCmd->SetToBeBroadcasted(false);
+    fEventOffsetCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    fSummaryDirectory = new G4UIdirectory("/summary/");
+    fSummaryDirectory->SetGuidance("Weighted histograms of the events, accumulated during the run and written as JSON.");
+
+    fSummaryHistogramCmd = new G4UIcmdWithAString("/summary/histogram", this);
+    fSummaryHistogramCmd->SetGuidance("Add a 1D, 2D or 3D histogram: \"quantity nBins min max\" for every axis.");
+    fSummaryHistogramCmd->SetGuidance("Per detector: edet ndet nphot ncomp. Per cluster: eh xh yh zh rh. Per event: xp yp zp.");
+    fSummaryHistogramCmd->SetGuidance("Units are keV and mm. Per detector and per cluster quantities cannot be combined.");
+    fSummaryHistogramCmd->SetParameterName("definition", false);
+    fSummaryHistogramCmd->SetToBeBroadcasted(false);
+    fSummaryHistogramCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    fSummaryClearCmd = new G4UIcmdWithoutParameter("/summary/clear", this);
+    fSummaryClearCmd->SetGuidance("Remove all histograms.");
+    fSummaryClearCmd->SetToBeBroadcasted(false);
+    fSummaryClearCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    fSummaryWriteNtupleCmd = new G4UIcmdWithABool("/summary/writeNtuple", this);
+    fSummaryWriteNtupleCmd->SetGuidance("Write the event ntuple (default true). With false only the histograms are written.");
+    fSummaryWriteNtupleCmd->SetParameterName("writeNtuple", false);
+    fSummaryWriteNtupleCmd->SetToBeBroadcasted(false);
+    fSummaryWriteNtupleCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
 }
 
 RunActionMessenger::~RunActionMessenger() {
     delete fOutputFileNameCmd;
+    delete fOutputFormatCmd;
+    delete fOutputChunkSizeCmd;
+    delete fOutputCompressionCmd;
+    delete fEventLayoutCmd;
+    delete fTimingReportCmd;
+    delete fPhysicsTableCacheCmd;
+    delete fEventSeedCmd;
+    delete fEventOffsetCmd;
+    delete fSummaryHistogramCmd;
+    delete fSummaryClearCmd;
+    delete fSummaryWriteNtupleCmd;
+    delete fSummaryDirectory;
 }
 
 /**
  * @brief Sets the new value for a given G4UIcommand.
  *
  * This method is called when a G4UIcommand is executed and the new value is passed as a G4String.
- * It checks if the given command is the fOutputFileNameCmd and if so, it sets the new value as the output file name for the associated RunAction object.
+ * It checks which command is given and passes the new value to the associated RunAction object.
  *
  * @param command The G4UIcommand object.
  * @param newValue The new value as a G4String.
@@ -35,6 +130,28 @@ RunActionMessenger::~RunActionMessenger() {
 void RunActionMessenger::SetNewValue(G4UIcommand* command, G4String newValue) {
     if (command == fOutputFileNameCmd) {
         fRunAction->SetOutputFileName(newValue);
+    } else if (command == fOutputFormatCmd) {
+        fRunAction->SetOutputFormat(newValue);
+    } else if (command == fOutputChunkSizeCmd) {
+        fRunAction->SetOutputChunkSize(fOutputChunkSizeCmd->GetNewIntValue(newValue));
+    } else if (command == fOutputCompressionCmd) {
+        fRunAction->SetOutputCompression(newValue);
+    } else if (command == fEventLayoutCmd) {
+        fRunAction->SetEventLayout(newValue);
+    } else if (command == fTimingReportCmd) {
+        fRunAction->SetTimingReport(fTimingReportCmd->GetNewBoolValue(newValue));
+    } else if (command == fPhysicsTableCacheCmd) {
+        fRunAction->SetPhysicsTableCache(newValue);
+    } else if (command == fEventSeedCmd) {
+        EventSeeder::Instance()->SetRunSeed(fEventSeedCmd->GetNewIntValue(newValue));
+    } else if (command == fEventOffsetCmd) {
+        EventSeeder::Instance()->SetEventOffset(fEventOffsetCmd->GetNewIntValue(newValue));
+    } else if (command == fSummaryHistogramCmd) {
+        RunSummary::AddDefinition(newValue);
+    } else if (command == fSummaryClearCmd) {
+        RunSummary::ClearDefinitions();
+    } else if (command == fSummaryWriteNtupleCmd) {
+        RunSummary::SetWriteNtuple(fSummaryWriteNtupleCmd->GetNewBoolValue(newValue));
     }
 }
 
@@ -0,0 +1,299 @@
+#include "RunSummary.hh"
+
+#include "G4Exception.hh"
+#include "G4ios.hh"
+#include "globals.hh"
+
+#include "nlohmann/json.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+
+/**
+ * @namespace G4Sim
+ * @brief Namespace for the G4Sim library.
+/*/
+namespace G4Sim {
+
+std::vector<RunSummary::Definition> RunSummary::fDefinitions;
+G4bool RunSummary::fWriteNtuple = true;
+
+namespace {
+
+// The summaries of all threads, owned here like the PhaseTimers: the master reads them at the end of the run.
+std::mutex& RegistryMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+std::vector<std::unique_ptr<RunSummary>>& Registry() {
+    static std::vector<std::unique_ptr<RunSummary>> registry;
+    return registry;
+}
+
+const std::vector<G4String> kQuantityNames = {
+    "edet", "ndet", "nphot", "ncomp", "eh", "xh", "yh", "zh", "rh", "xp", "yp", "zp"};
+
+} // namespace
+
+/**
+ * @brief Adds a histogram definition, "quantity nBins min max" for every axis (one to three).
+ *
+ * @param text The definition, as given to /summary/histogram.
+ * @return false, with a warning, if the definition is not valid.
+ */
+G4bool RunSummary::AddDefinition(const G4String& text) {
+    Definition definition;
+    definition.text = text;
+    G4bool hasDetector = false;
+    G4bool hasCluster = false;
+
+    std::istringstream stream(text);
+    G4String name;
+    G4String error;
+    while (error.empty() && stream >> name) {
+        Axis axis;
+        auto it = std::find(kQuantityNames.begin(), kQuantityNames.end(), name);
+        if (it == kQuantityNames.end()) {
+            error = "unknown quantity " + name;
+        } else if (!(stream >> axis.nBins >> axis.min >> axis.max) || axis.nBins <= 0 || !(axis.max > axis.min)) {
+            error = "expected nBins > 0, min and max > min after " + name;
+        } else {
+            axis.quantity = static_cast<Quantity>(it - kQuantityNames.begin());
+            hasDetector = hasDetector || axis.quantity <= kNcomp;
+            hasCluster = hasCluster || (axis.quantity >= kEh && axis.quantity <= kRh);
+            definition.axes.push_back(axis);
+        }
+    }
+    if (error.empty() && (definition.axes.empty() || definition.axes.size() > 3)) error = "expected one to three axes";
+    if (error.empty() && hasDetector && hasCluster) error = "per detector and per cluster quantities cannot be combined";
+    if (!error.empty()) {
+        G4ExceptionDescription msg;
+        msg << "Histogram \"" << text << "\" ignored: " << error << G4endl;
+        G4Exception("RunSummary::AddDefinition()", "Summary0001", JustWarning, msg);
+        return false;
+    }
+
+    definition.level = hasCluster ? kClusterLevel : (hasDetector ? kDetectorLevel : kEventLevel);
+    fDefinitions.push_back(definition);
+    return true;
+}
+
+void RunSummary::ClearDefinitions() {
+    fDefinitions.clear();
+}
+
+G4bool RunSummary::IsEnabled() {
+    return !fDefinitions.empty();
+}
+
+/**
+ * @brief Creates a summary, owned by the registry, for an EventAction.
+ */
+RunSummary* RunSummary::Create() {
+    std::lock_guard<std::mutex> lock(RegistryMutex());
+    Registry().emplace_back(new RunSummary());
+    return Registry().back().get();
+}
+
+/**
+ * @brief Drops the histograms of all summaries.
+ *
+ * Called by the master at the start of a run, before the threads book their histograms, so that a thread that
+ * takes no part in the run does not add the histograms of an earlier run.
+ */
+void RunSummary::ResetRun() {
+    std::lock_guard<std::mutex> lock(RegistryMutex());
+    for (auto& summary : Registry()) {
+        summary->fBooking.clear();
+        summary->fHistograms.clear();
+        summary->fDetectorHistograms.clear();
+        summary->fClusterHistograms.clear();
+        summary->fEventHistograms.clear();
+    }
+}
+
+/**
+ * @brief Books the histograms of all definitions for the active collections of this thread.
+ *
+ * @param collectionNames The names of the active collections, by output slot.
+ */
+void RunSummary::Book(const std::vector<G4String>& collectionNames) {
+    fHistograms.clear();
+    fDetectorHistograms.assign(collectionNames.size(), {});
+    fClusterHistograms.assign(collectionNames.size(), {});
+    fEventHistograms.clear();
+    fBooking.clear();
+    if (fDefinitions.empty()) return;
+
+    for (const G4String& name : collectionNames) fBooking += name + ";";
+    for (size_t d = 0; d < fDefinitions.size(); ++d) {
+        const Definition& definition = fDefinitions[d];
+        fBooking += definition.text + ";";
+
+        size_t nBins = 1;
+        for (const Axis& axis : definition.axes) nBins *= axis.nBins;
+
+        auto book = [&](const G4String& collection, G4int slot) {
+            Histogram histogram;
+            histogram.definition = d;
+            histogram.collection = collection;
+            histogram.slot = slot;
+            histogram.sumWeights.assign(nBins, 0.);
+            histogram.sumWeights2.assign(nBins, 0.);
+            fHistograms.push_back(histogram);
+            return fHistograms.size() - 1;
+        };
+
+        if (definition.level == kEventLevel) {
+            fEventHistograms.push_back(book("event", -1));
+            continue;
+        }
+        for (size_t slot = 0; slot < collectionNames.size(); ++slot) {
+            size_t index = book(collectionNames[slot], static_cast<G4int>(slot));
+            if (definition.level == kDetectorLevel) {
+                fDetectorHistograms[slot].push_back(index);
+            } else {
+                fClusterHistograms[slot].push_back(index);
+            }
+        }
+    }
+}
+
+G4double RunSummary::Value(Quantity quantity, const Event& event, size_t index) {
+    switch (quantity) {
+        case kEdet:  return (*event.edet)[index];
+        case kNdet:  return (*event.ndet)[index];
+        case kNphot: return event.nphot ? (*event.nphot)[index] : 0.;
+        case kNcomp: return event.ncomp ? (*event.ncomp)[index] : 0.;
+        case kEh:    return (*event.e)[index];
+        case kXh:    return (*event.x)[index];
+        case kYh:    return (*event.y)[index];
+        case kZh:    return (*event.z)[index];
+        case kRh:    return std::hypot((*event.x)[index], (*event.y)[index]);
+        case kXp:    return event.xp;
+        case kYp:    return event.yp;
+        case kZp:    return event.zp;
+    }
+    return 0.;
+}
+
+void RunSummary::FillHistogram(Histogram& histogram, const Event& event, size_t index, G4double weight) {
+    histogram.entries++;
+    size_t bin = 0;
+    for (const Axis& axis : fDefinitions[histogram.definition].axes) {
+        G4double value = Value(axis.quantity, event, index);
+        G4double position = (value - axis.min) / (axis.max - axis.min) * axis.nBins;
+        if (!(position >= 0.) || position >= axis.nBins) {
+            histogram.outside += weight;
+            return;
+        }
+        bin = bin * axis.nBins + static_cast<size_t>(position);
+    }
+    histogram.sumWeights[bin] += weight;
+    histogram.sumWeights2[bin] += weight * weight;
+}
+
+/**
+ * @brief Fills the histograms with an event.
+ *
+ * @param event The clustered event. The cluster IDs are the output slots of the collections.
+ */
+void RunSummary::Fill(const Event& event) {
+    if (fHistograms.empty()) return;
+    const G4double eventWeight = std::exp(event.logWeight);
+
+    for (size_t index : fEventHistograms) FillHistogram(fHistograms[index], event, 0, eventWeight);
+
+    // in the sparse layout the per detector entries are only those with clusters, the slot is in det
+    for (size_t i = 0; i < event.ndet->size(); ++i) {
+        size_t slot = event.det ? static_cast<size_t>((*event.det)[i]) : i;
+        if (slot >= fDetectorHistograms.size() || (*event.ndet)[i] == 0) continue;
+        for (size_t index : fDetectorHistograms[slot]) FillHistogram(fHistograms[index], event, i, eventWeight);
+    }
+
+    for (size_t cluster = 0; cluster < event.e->size(); ++cluster) {
+        size_t slot = static_cast<size_t>((*event.id)[cluster]);
+        if (slot >= fClusterHistograms.size()) continue;
+        G4double weight = std::exp((*event.w)[cluster]);
+        for (size_t index : fClusterHistograms[slot]) FillHistogram(fHistograms[index], event, cluster, weight);
+    }
+}
+
+/**
+ * @brief Adds the histograms of all threads and writes them as a JSON file.
+ *
+ * Called by the master at the end of a run, after the worker threads have finished their events. The bins of a
+ * histogram are stored flat, with the last axis running fastest.
+ *
+ * @param fileName The name of the file.
+ * @param runID The run ID.
+ * @param nEvents The number of events of the run.
+ */
+void RunSummary::WriteReport(const G4String& fileName, G4int runID, G4int nEvents) {
+    std::lock_guard<std::mutex> lock(RegistryMutex());
+
+    const RunSummary* reference = nullptr;
+    for (const auto& summary : Registry()) {
+        if (!summary->fBooking.empty()) {
+            reference = summary.get();
+            break;
+        }
+    }
+    if (!reference) return;
+
+    std::vector<Histogram> merged = reference->fHistograms;
+    for (auto& histogram : merged) {
+        histogram.sumWeights.assign(histogram.sumWeights.size(), 0.);
+        histogram.sumWeights2.assign(histogram.sumWeights2.size(), 0.);
+        histogram.outside = 0.;
+        histogram.entries = 0;
+    }
+    for (const auto& summary : Registry()) {
+        if (summary->fBooking != reference->fBooking) continue;
+        for (size_t i = 0; i < merged.size(); ++i) {
+            const Histogram& histogram = summary->fHistograms[i];
+            for (size_t bin = 0; bin < histogram.sumWeights.size(); ++bin) {
+                merged[i].sumWeights[bin] += histogram.sumWeights[bin];
+                merged[i].sumWeights2[bin] += histogram.sumWeights2[bin];
+            }
+            merged[i].outside += histogram.outside;
+            merged[i].entries += histogram.entries;
+        }
+    }
+
+    nlohmann::json report;
+    report["run"] = runID;
+    report["events"] = nEvents;
+    nlohmann::json histograms = nlohmann::json::array();
+    for (const Histogram& histogram : merged) {
+        const Definition& definition = fDefinitions[histogram.definition];
+        nlohmann::json entry;
+        entry["definition"] = definition.text;
+        entry["collection"] = histogram.collection;
+        for (const Axis& axis : definition.axes) {
+            entry["axes"].push_back({{"quantity", kQuantityNames[axis.quantity]}, {"nBins", axis.nBins},
+                                     {"min", axis.min}, {"max", axis.max}});
+        }
+        entry["sumWeights"] = histogram.sumWeights;
+        entry["sumWeights2"] = histogram.sumWeights2;
+        entry["outside"] = histogram.outside;
+        entry["entries"] = histogram.entries;
+        histograms.push_back(entry);
+    }
+    report["histograms"] = histograms;
+
+    std::ofstream file(fileName);
+    if (!file) {
+        G4cerr << "RunSummary::WriteReport: Error: cannot write " << fileName << G4endl;
+        return;
+    }
+    file << report.dump() << std::endl;
+    G4cout << "RunSummary::WriteReport: " << merged.size() << " histograms written to " << fileName << G4endl;
+}
+
+} // namespace G4Sim
@@ -7,6 +7,7 @@
 #include "G4PhysicalConstants.hh"
 #include "G4ThreeVector.hh"
 #include "G4VProcess.hh"
+#include "G4EmProcessSubType.hh"
 #include "Hit.hh"
 
 /**
@@ -24,31 +25,61 @@ namespace G4Sim {
 SensitiveDetector::SensitiveDetector(const G4String& name, const G4String& hitsCollectionName)
     : G4VSensitiveDetector(name), fHitsCollection(nullptr), fHitsCollectionID(-1), fTotalEnergyDeposit(0.) {
     collectionName.insert(hitsCollectionName);
+    // sensitive detectors are constructed on the thread that uses them
+    fTimers = PhaseTimers::Instance();
 }
 
 SensitiveDetector::~SensitiveDetector() {}
 
+/**
+ * @brief Switches the detector to streaming clustering.
+ *
+ * Instead of storing a Hit for every step, the deposits are clustered while the event is tracked. Compton and
+ * photo-electric deposits start a new cluster, all other deposits join the first cluster within the thresholds.
+ * Since the deposits are seen in tracking order rather than all seeds first, the clusters can differ slightly
+ * from the end-of-event clustering in EventAction.
+ *
+ * @param spatialThreshold The spatial threshold for clustering.
+ * @param timeThreshold The time threshold for clustering.
+ */
+void SensitiveDetector::SetStreamingClustering(G4double spatialThreshold, G4double timeThreshold) {
+    fStreamingClustering = true;
+    fSpatialThreshold = spatialThreshold;
+    fTimeThreshold = timeThreshold;
+}
+
 /**
  * @brief Initialize the SensitiveDetector.
  * 
  * This function is called to initialize the SensitiveDetector. It creates a new HitsCollection
  * and assigns it to the SensitiveDetector. It also retrieves the collection ID and adds the
  * HitsCollection to the G4HCofThisEvent object. Finally, it resets the total energy deposit.
+ * In streaming clustering mode only the running clusters are reset, and in hit store mode only the store is cleared.
  * 
  * @param hce Pointer to the G4HCofThisEvent object.
  */
 void SensitiveDetector::Initialize(G4HCofThisEvent* hce) {
-    
+    fTotalEnergyDeposit = 0.;  // Reset total energy deposit
+
+    if (fStreamingClustering) {
+        fClusterer.Reset(fSpatialThreshold, fTimeThreshold);
+        fClusters.clear();
+        fHitsCollection = nullptr;
+        return;
+    }
+    if (fUseHitStore) {
+        fHitStore.Clear();
+        fHitsCollection = nullptr;
+        return;
+    }
+
     fHitsCollection = new HitsCollection(SensitiveDetectorName, collectionName[0]);
     if (fHitsCollectionID < 0) {
         fHitsCollectionID = G4SDManager::GetSDMpointer()->GetCollectionID(fHitsCollection);
     }
     //fHitsCollection = new G4THitsCollection<Hit>(SensitiveDetectorName, collectionName[0]);
 
-    G4int hcID = G4SDManager::GetSDMpointer()->GetCollectionID(collectionName[0]);
-    hce->AddHitsCollection(hcID, fHitsCollection);
-    fTotalEnergyDeposit = 0.;  // Reset total energy deposit
-
+    hce->AddHitsCollection(fHitsCollectionID, fHitsCollection);
 }
 
 /**
@@ -61,9 +92,36 @@ void SensitiveDetector::Initialize(G4HCofThisEvent* hce) {
  * @return A boolean value indicating whether the hit was processed successfully or not.
  */
 G4bool SensitiveDetector::ProcessHits(G4Step* step, G4TouchableHistory*) {
+    PhaseTimer timer(fTimers, PhaseTimers::kProcessHits);
+
     G4double edep = step->GetTotalEnergyDeposit();
     if (edep == 0.) return false;
 
+    if (fStreamingClustering) {
+        const G4StepPoint* postStepPoint = step->GetPostStepPoint();
+        G4int processID = postStepPoint->GetProcessDefinedStep()->GetProcessSubType();
+        G4double weight = step->GetTrack()->GetWeight();
+        if (processID == fComptonScattering || processID == fPhotoElectricEffect) {
+            fClusterer.AddSeed(postStepPoint->GetPosition(), edep, postStepPoint->GetGlobalTime(), weight);
+        } else {
+            fClusterer.AddHit(postStepPoint->GetPosition(), edep, postStepPoint->GetGlobalTime(), weight);
+        }
+        fTotalEnergyDeposit += edep;
+        return true;
+    }
+
+    if (fUseHitStore) {
+        const G4StepPoint* preStepPoint = step->GetPreStepPoint();
+        const G4StepPoint* postStepPoint = step->GetPostStepPoint();
+        fHitStore.Add(edep, postStepPoint->GetPosition(), postStepPoint->GetGlobalTime(),
+                      step->GetTrack()->GetTrackID(), step->GetTrack()->GetParentID(), preStepPoint->GetMomentum(),
+                      step->GetTrack()->GetDefinition()->GetPDGEncoding(),
+                      postStepPoint->GetProcessDefinedStep()->GetProcessSubType(),
+                      preStepPoint->GetKineticEnergy(), postStepPoint->GetKineticEnergy(), step->GetTrack()->GetWeight());
+        fTotalEnergyDeposit += edep;
+        return true;
+    }
+
     G4Sim::Hit* newHit = new G4Sim::Hit();
     //Hit* newHit = new Hit();
     newHit->energyDeposit = edep;
@@ -73,17 +131,18 @@ G4bool SensitiveDetector::ProcessHits(G4Step* step, G4TouchableHistory*) {
     newHit->trackID = step->GetTrack()->GetTrackID();
     newHit->parentID = step->GetTrack()->GetParentID();
     newHit->momentum = step->GetPreStepPoint()->GetMomentum();
-    newHit->particleType = step->GetTrack()->GetDefinition()->GetParticleName();
-    newHit->processType = step->GetPostStepPoint()->GetProcessDefinedStep()->GetProcessName();
+    newHit->particleID = step->GetTrack()->GetDefinition()->GetPDGEncoding();
+    newHit->processID = step->GetPostStepPoint()->GetProcessDefinedStep()->GetProcessSubType();
     newHit->particleEnergy0 = step->GetPreStepPoint()->GetKineticEnergy();
     newHit->particleEnergy1 = step->GetPostStepPoint()->GetKineticEnergy(); 
+    newHit->weight = step->GetTrack()->GetWeight();
 
     
     //if (newHit->trackID == 1){
     //    newHit->Print();
     //    // get the track energy before the step
-    //    G4cout << newHit->processType<<" SensitiveDetector::ProcessHits: track energy before: " << step->GetPreStepPoint()->GetKineticEnergy() / keV << " keV"<<G4endl;
-    //    G4cout << newHit->processType<<" SensitiveDetector::ProcessHits: track energy after: " << step->GetTrack()->GetKineticEnergy() / keV << " keV" <<G4endl;
+    //    G4cout << Hit::GetProcessName(newHit->particleID, newHit->processID)<<" SensitiveDetector::ProcessHits: track energy before: " << step->GetPreStepPoint()->GetKineticEnergy() / keV << " keV"<<G4endl;
+    //    G4cout << Hit::GetProcessName(newHit->particleID, newHit->processID)<<" SensitiveDetector::ProcessHits: track energy after: " << step->GetTrack()->GetKineticEnergy() / keV << " keV" <<G4endl;
     //}
 
     fHitsCollection->insert(newHit);
@@ -95,10 +154,17 @@ G4bool SensitiveDetector::ProcessHits(G4Step* step, G4TouchableHistory*) {
 /**
  * @brief This function is called at the end of each event in the SensitiveDetector class.
  * It processes the hits collected during the event and performs any necessary calculations or actions.
+ * In streaming clustering mode the running clusters are merged and stored as the result of the event.
  * 
  * @param hce A pointer to the G4HCofThisEvent object containing the hits collections.
  */
 void SensitiveDetector::EndOfEvent(G4HCofThisEvent* hce) {
+    if (fStreamingClustering) {
+        fClusterer.MergeClusters();
+        fClusterer.GetClusters(fClusters, -1);
+        return;
+    }
+    // the hit store is read directly by the EventAction
     if (!fHitsCollection) return;
 
     // Example of processing hits at the end of the event
@@ -0,0 +1,252 @@
+#include "SolidFlattener.hh"
+
+#include "G4GenericPolycone.hh"
+#include "G4Polycone.hh"
+#include "G4ThreeVector.hh"
+#include "G4VSolid.hh"
+#include "G4PhysicalConstants.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <random>
+#include <sstream>
+
+/**
+ * @namespace G4Sim
+ * @brief Namespace for the G4Sim library.
+/*/
+namespace G4Sim {
+
+namespace {
+
+// sorted edges, with edges closer than the tolerance merged
+std::vector<G4double> MergeEdges(std::vector<G4double> values) {
+    std::sort(values.begin(), values.end());
+    std::vector<G4double> edges;
+    for (G4double value : values) {
+        if (edges.empty() || value - edges.back() > SolidFlattener::kTolerance) edges.push_back(value);
+    }
+    return edges;
+}
+
+} // namespace
+
+SolidFlattener::SolidFlattener(G4double startPhi, G4double deltaPhi) : fStartPhi(startPhi), fDeltaPhi(deltaPhi) {}
+
+/**
+ * @brief Adds a tubs, in the order of the boolean operations. The first one must not be subtracted.
+ *
+ * @param rMin Inner radius.
+ * @param rMax Outer radius.
+ * @param zMin Lower z edge, in the frame of the first component.
+ * @param zMax Upper z edge.
+ * @param subtract true to subtract the tubs, false to add it.
+ */
+void SolidFlattener::Add(G4double rMin, G4double rMax, G4double zMin, G4double zMax, G4bool subtract) {
+    fComponents.push_back({rMin, rMax, zMin, zMax, subtract});
+}
+
+/**
+ * @brief Marks every cell of the (r, z) grid as inside or outside.
+ */
+void SolidFlattener::FillCells() {
+    std::vector<G4double> rValues;
+    std::vector<G4double> zValues;
+    for (const Component& component : fComponents) {
+        rValues.insert(rValues.end(), {component.rMin, component.rMax});
+        zValues.insert(zValues.end(), {component.zMin, component.zMax});
+    }
+    fREdges = MergeEdges(rValues);
+    fZEdges = MergeEdges(zValues);
+
+    const size_t nR = fREdges.size() - 1;
+    const size_t nZ = fZEdges.size() - 1;
+    fInside.assign(nR * nZ, false);
+    for (const Component& component : fComponents) {
+        for (size_t j = 0; j < nZ; ++j) {
+            if (fZEdges[j] < component.zMin - kTolerance || fZEdges[j + 1] > component.zMax + kTolerance) continue;
+            for (size_t i = 0; i < nR; ++i) {
+                if (fREdges[i] < component.rMin - kTolerance || fREdges[i + 1] > component.rMax + kTolerance) continue;
+                fInside[j * nR + i] = !component.subtract;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Builds the polycone, or returns nullptr if the region cannot be represented (see GetDescription()).
+ *
+ * @param name The name of the solid.
+ */
+G4VSolid* SolidFlattener::Build(const G4String& name) {
+    if (fComponents.size() < 2 || fComponents.front().subtract) {
+        fDescription = "needs a first tubs and at least one more";
+        return nullptr;
+    }
+    FillCells();
+    if (std::find(fInside.begin(), fInside.end(), true) == fInside.end()) {
+        fDescription = "the region is empty";
+        return nullptr;
+    }
+
+    G4VSolid* solid = BuildPolycone(name);
+    if (!solid) solid = BuildGenericPolycone(name);
+    return solid;
+}
+
+/**
+ * @brief Builds a G4Polycone if every z slab with cells is one r interval, and the slabs are not separated.
+ *
+ * Slabs with the same interval are merged; a step between slabs is two planes at the same z.
+ */
+G4VSolid* SolidFlattener::BuildPolycone(const G4String& name) {
+    const size_t nR = fREdges.size() - 1;
+    const size_t nZ = fZEdges.size() - 1;
+
+    std::vector<G4double> zPlanes;
+    std::vector<G4double> rInner;
+    std::vector<G4double> rOuter;
+    G4bool ended = false;  // a slab without cells after the first slab with cells
+    for (size_t j = 0; j < nZ; ++j) {
+        size_t first = nR;
+        size_t last = 0;
+        for (size_t i = 0; i < nR; ++i) {
+            if (!IsInside(i, j)) continue;
+            first = std::min(first, i);
+            last = i;
+        }
+        if (first == nR) {
+            ended = ended || !zPlanes.empty();
+            continue;
+        }
+        if (ended) return nullptr;
+        for (size_t i = first; i <= last; ++i) {
+            if (!IsInside(i, j)) return nullptr;
+        }
+
+        G4double r1 = fREdges[first];
+        G4double r2 = fREdges[last + 1];
+        if (!zPlanes.empty() && rInner.back() == r1 && rOuter.back() == r2) {
+            zPlanes.back() = fZEdges[j + 1];
+            continue;
+        }
+        // slabs whose intervals do not overlap only touch at a circle
+        if (!zPlanes.empty() && (r1 >= rOuter.back() || r2 <= rInner.back())) return nullptr;
+        zPlanes.insert(zPlanes.end(), {fZEdges[j], fZEdges[j + 1]});
+        rInner.insert(rInner.end(), {r1, r1});
+        rOuter.insert(rOuter.end(), {r2, r2});
+    }
+
+    std::ostringstream description;
+    description << "G4Polycone with " << zPlanes.size() << " z planes";
+    fDescription = description.str();
+    return new G4Polycone(name, fStartPhi, fDeltaPhi, static_cast<G4int>(zPlanes.size()), zPlanes.data(),
+                          rInner.data(), rOuter.data());
+}
+
+/**
+ * @brief Builds a G4GenericPolycone from the outline of the cells, if it is one simple polygon.
+ *
+ * The sides of the cells that border an outside cell are the edges of the outline, directed with the inside on the
+ * left. The outline is one simple polygon if every corner starts at most one edge (no cells that only touch at a
+ * corner) and the edges form a single loop (no separate parts and no holes).
+ */
+G4VSolid* SolidFlattener::BuildGenericPolycone(const G4String& name) {
+    const size_t nR = fREdges.size() - 1;
+    const size_t nZ = fZEdges.size() - 1;
+    auto inside = [&](long i, long j) {
+        return i >= 0 && j >= 0 && i < static_cast<long>(nR) && j < static_cast<long>(nZ) && IsInside(i, j);
+    };
+    auto corner = [&](size_t i, size_t j) { return j * (nR + 1) + i; };
+
+    std::map<size_t, size_t> next;  // start corner -> end corner of the outline edges
+    G4bool simple = true;
+    auto addEdge = [&](size_t from, size_t to) { simple = next.emplace(from, to).second && simple; };
+    for (size_t j = 0; j < nZ; ++j) {
+        for (size_t i = 0; i < nR; ++i) {
+            if (!IsInside(i, j)) continue;
+            long li = static_cast<long>(i);
+            long lj = static_cast<long>(j);
+            if (!inside(li, lj - 1)) addEdge(corner(i, j), corner(i + 1, j));
+            if (!inside(li + 1, lj)) addEdge(corner(i + 1, j), corner(i + 1, j + 1));
+            if (!inside(li, lj + 1)) addEdge(corner(i + 1, j + 1), corner(i, j + 1));
+            if (!inside(li - 1, lj)) addEdge(corner(i, j + 1), corner(i, j));
+        }
+    }
+    if (!simple) {
+        fDescription = "parts of the region only touch at a corner";
+        return nullptr;
+    }
+
+    std::vector<size_t> loop;
+    size_t start = next.begin()->first;
+    for (size_t c = start; loop.empty() || c != start; c = next.at(c)) loop.push_back(c);
+    if (loop.size() != next.size()) {
+        fDescription = "the region has separate parts or holes in the (r, z) plane";
+        return nullptr;
+    }
+
+    // only the corners where the outline turns
+    std::vector<G4double> r;
+    std::vector<G4double> z;
+    const size_t n = loop.size();
+    for (size_t k = 0; k < n; ++k) {
+        size_t previous = loop[(k + n - 1) % n];
+        size_t current = loop[k];
+        size_t following = loop[(k + 1) % n];
+        G4bool sameR = previous % (nR + 1) == current % (nR + 1) && current % (nR + 1) == following % (nR + 1);
+        G4bool sameZ = previous / (nR + 1) == current / (nR + 1) && current / (nR + 1) == following / (nR + 1);
+        if (sameR || sameZ) continue;
+        r.push_back(fREdges[current % (nR + 1)]);
+        z.push_back(fZEdges[current / (nR + 1)]);
+    }
+
+    std::ostringstream description;
+    description << "G4GenericPolycone with " << r.size() << " corners";
+    fDescription = description.str();
+    return new G4GenericPolycone(name, fStartPhi, fDeltaPhi, static_cast<G4int>(r.size()), r.data(), z.data());
+}
+
+G4double SolidFlattener::GetVolume() const {
+    const size_t nR = fREdges.size() - 1;
+    G4double volume = 0.;
+    for (size_t j = 0; j + 1 < fZEdges.size(); ++j) {
+        for (size_t i = 0; i < nR; ++i) {
+            if (!IsInside(i, j)) continue;
+            volume += 0.5 * fDeltaPhi * (fREdges[i + 1] * fREdges[i + 1] - fREdges[i] * fREdges[i]) *
+                (fZEdges[j + 1] - fZEdges[j]);
+        }
+    }
+    return volume;
+}
+
+/**
+ * @brief Compares the solid with the boolean solid at random points around the region.
+ *
+ * A point counts as a mismatch if one solid has it inside and the other outside; points on the surface of either
+ * solid are not counted.
+ *
+ * @param solid The solid made by Build().
+ * @param reference The boolean solid.
+ * @param nPoints The number of test points.
+ * @return true if the solids agree on all points.
+ */
+G4bool SolidFlattener::Check(const G4VSolid* solid, const G4VSolid* reference, G4int nPoints) {
+    const G4double rMax = 1.1 * fREdges.back();
+    const G4double margin = 0.1 * (fZEdges.back() - fZEdges.front());
+    std::mt19937_64 engine(20240601);
+    std::uniform_real_distribution<G4double> xy(-rMax, rMax);
+    std::uniform_real_distribution<G4double> z(fZEdges.front() - margin, fZEdges.back() + margin);
+
+    fMismatches = 0;
+    for (G4int n = 0; n < nPoints; ++n) {
+        G4ThreeVector point(xy(engine), xy(engine), z(engine));
+        EInside a = solid->Inside(point);
+        EInside b = reference->Inside(point);
+        if ((a == kInside && b == kOutside) || (a == kOutside && b == kInside)) fMismatches++;
+    }
+    return fMismatches == 0;
+}
+
+} // namespace G4Sim
@@ -0,0 +1,223 @@
+#include "StepTracer.hh"
+#include "EventSeeder.hh"
+
+#include "G4Event.hh"
+#include "G4EventManager.hh"
+#include "G4LogicalVolume.hh"
+#include "G4LogicalVolumeStore.hh"
+#include "G4ParticleTable.hh"
+#include "G4Step.hh"
+#include "G4Threading.hh"
+#include "G4Track.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4VProcess.hh"
+#include "G4ios.hh"
+#include "globals.hh"
+
+#include <algorithm>
+#include <cstring>
+
+#if !defined(__BYTE_ORDER__) || __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "The step trace files require a little endian host"
+#endif
+
+/**
+ * @namespace G4Sim
+ * @brief Namespace for the G4Sim library.
+/*/
+namespace G4Sim {
+
+namespace {
+
+const char kHeaderMagic[8] = {'X', 'A', 'M', 'S', 'S', 'T', 'P', '1'};
+const char kFooterMagic[8] = {'X', 'A', 'M', 'S', 'E', 'N', 'D', '1'};
+
+template <typename T>
+void WriteValue(std::ofstream& file, T value) {
+    file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void WriteName(std::ofstream& file, const G4String& name) {
+    WriteValue<std::uint32_t>(file, name.size());
+    file.write(name.data(), name.size());
+}
+
+} // namespace
+
+StepTracer::~StepTracer() {
+    Close();
+}
+
+/**
+ * @brief Returns the file name of the step trace file of this thread.
+ *
+ * @param fileName The file name, with or without the .xst extension.
+ * @return The file name with the thread suffix on worker threads and the .xst extension.
+ */
+G4String StepTracer::MakeFileName(const G4String& fileName) {
+    G4String base = fileName;
+    const G4String extension = ".xst";
+    if (base.size() > extension.size() &&
+        base.compare(base.size() - extension.size(), extension.size(), extension) == 0) {
+        base = base.substr(0, base.size() - extension.size());
+    }
+    if (G4Threading::IsWorkerThread()) {
+        base += "_t" + std::to_string(G4Threading::G4GetThreadId());
+    }
+    return base + extension;
+}
+
+/**
+ * @brief Opens the step trace file of this thread; a file that is already open is closed first.
+ *
+ * @param fileName The name given with /stepTrace/file, see MakeFileName().
+ */
+void StepTracer::Open(const G4String& fileName) {
+    Close();
+
+    fFileName = MakeFileName(fileName);
+    fFile.open(fFileName, std::ios::binary | std::ios::trunc);
+    if (!fFile) {
+        G4ExceptionDescription msg;
+        msg << "Cannot open step trace file " << fFileName << G4endl;
+        G4Exception("StepTracer::Open()", "StepTrace0001", FatalException, msg);
+    }
+
+    fFile.write(kHeaderMagic, sizeof(kHeaderMagic));
+    WriteValue<std::uint32_t>(fFile, sizeof(StepRecord));
+    WriteValue<std::uint32_t>(fFile, 0);
+
+    fBuffer.clear();
+    fBuffer.reserve(fBufferSize);
+    fNRecords = 0;
+    fEvent = nullptr;
+    fProcessIndex.clear();
+    fProcessNames.clear();
+
+    G4cout << "StepTracer::Open: writing " << fFileName << G4endl;
+}
+
+/**
+ * @brief Writes the buffered steps and the footer, and closes the file.
+ */
+void StepTracer::Close() {
+    if (!fFile.is_open()) return;
+    Flush();
+
+    std::uint64_t footerOffset = fFile.tellp();
+    WriteValue<std::uint32_t>(fFile, fVolumeTable.size());
+    for (const auto& volume : fVolumeTable) {
+        WriteValue<std::int32_t>(fFile, volume.first);
+        WriteName(fFile, volume.second);
+    }
+    WriteValue<std::uint32_t>(fFile, fProcessNames.size());
+    for (const G4String& name : fProcessNames) WriteName(fFile, name);
+    WriteValue<std::uint64_t>(fFile, footerOffset);
+    fFile.write(kFooterMagic, sizeof(kFooterMagic));
+    fFile.close();
+
+    G4cout << "StepTracer::Close: " << fNRecords << " steps written to " << fFileName << G4endl;
+}
+
+void StepTracer::Flush() {
+    if (fBuffer.empty()) return;
+    fFile.write(reinterpret_cast<const char*>(fBuffer.data()), fBuffer.size() * sizeof(StepRecord));
+    fBuffer.clear();
+}
+
+/**
+ * @brief Resolves the volume and particle names of the filters, and records the names of all volumes.
+ *
+ * Done at the first traced step, when the geometry is built and the particle table is complete.
+ */
+void StepTracer::ResolveFilters() {
+    fFiltersResolved = true;
+
+    const G4LogicalVolumeStore* volumeStore = G4LogicalVolumeStore::GetInstance();
+    fVolumeTable.clear();
+    fVolumeSelected.clear();
+    for (const G4LogicalVolume* volume : *volumeStore) {
+        G4int instanceID = volume->GetInstanceID();
+        fVolumeTable.emplace_back(instanceID, volume->GetName());
+        if (instanceID >= static_cast<G4int>(fVolumeSelected.size())) fVolumeSelected.resize(instanceID + 1, false);
+        fVolumeSelected[instanceID] = fVolumeNames.empty() ||
+            std::find(fVolumeNames.begin(), fVolumeNames.end(), volume->GetName()) != fVolumeNames.end();
+    }
+    for (const G4String& name : fVolumeNames) {
+        if (!volumeStore->GetVolume(name, false)) {
+            G4cerr << "StepTracer::ResolveFilters: Warning: unknown volume " << name << G4endl;
+        }
+    }
+
+    fParticles.clear();
+    G4ParticleTable* particleTable = G4ParticleTable::GetParticleTable();
+    for (const G4String& name : fParticleNames) {
+        const G4ParticleDefinition* particle = particleTable->FindParticle(name);
+        if (!particle) {
+            G4cerr << "StepTracer::ResolveFilters: Warning: unknown particle " << name << G4endl;
+            continue;
+        }
+        fParticles.push_back(particle);
+    }
+}
+
+std::int16_t StepTracer::GetProcessIndex(const G4VProcess* process) {
+    if (!process) return -1;
+    auto it = fProcessIndex.find(process);
+    if (it != fProcessIndex.end()) return it->second;
+    auto index = static_cast<std::int16_t>(fProcessNames.size());
+    fProcessIndex[process] = index;
+    fProcessNames.push_back(process->GetProcessName());
+    return index;
+}
+
+/**
+ * @brief Adds a step to the buffer if it passes the event, volume and particle filters.
+ *
+ * @param step The step.
+ */
+void StepTracer::Trace(const G4Step* step) {
+    const G4Event* event = G4EventManager::GetEventManager()->GetConstCurrentEvent();
+    if (event != fEvent) {
+        fEvent = event;
+        fEventID = event ? EventSeeder::Instance()->GetEventNumber(event->GetEventID()) : -1;
+        fEventSelected = fEventID >= fFirstEvent && (fLastEvent < 0 || fEventID <= fLastEvent);
+    }
+    if (!fEventSelected) return;
+
+    if (!fFiltersResolved) ResolveFilters();
+
+    const G4StepPoint* preStepPoint = step->GetPreStepPoint();
+    const G4StepPoint* postStepPoint = step->GetPostStepPoint();
+    G4int instanceID = preStepPoint->GetPhysicalVolume()->GetLogicalVolume()->GetInstanceID();
+    if (instanceID >= static_cast<G4int>(fVolumeSelected.size()) || !fVolumeSelected[instanceID]) return;
+
+    const G4Track* track = step->GetTrack();
+    const G4ParticleDefinition* particle = track->GetParticleDefinition();
+    if (!fParticles.empty() && std::find(fParticles.begin(), fParticles.end(), particle) == fParticles.end()) return;
+
+    const G4ThreeVector& prePosition = preStepPoint->GetPosition();
+    const G4ThreeVector& postPosition = postStepPoint->GetPosition();
+    StepRecord record;
+    record.eventID = fEventID;
+    record.trackID = track->GetTrackID();
+    record.parentID = track->GetParentID();
+    record.pdgCode = particle->GetPDGEncoding();
+    record.volume = static_cast<std::int16_t>(instanceID);
+    record.process = GetProcessIndex(postStepPoint->GetProcessDefinedStep());
+    record.preX = prePosition.x();
+    record.preY = prePosition.y();
+    record.preZ = prePosition.z();
+    record.postX = postPosition.x();
+    record.postY = postPosition.y();
+    record.postZ = postPosition.z();
+    record.kineticEnergy = postStepPoint->GetKineticEnergy();
+    record.energyDeposit = step->GetTotalEnergyDeposit();
+    record.time = postStepPoint->GetGlobalTime();
+
+    fBuffer.push_back(record);
+    fNRecords++;
+    if (fBuffer.size() >= fBufferSize) Flush();
+}
+
+} // namespace G4Sim
@@ -1,5 +1,21 @@
 #include "SteppingAction.hh"
 #include "EventAction.hh"
+#include "DetectorConstruction.hh"
+#include "EventSeeder.hh"
+#include "PhaseSpace.hh"
+#include "StepTracer.hh"
+#include "SteppingActionMessenger.hh"
+#include "G4EventManager.hh"
+#include "G4Event.hh"
+#include "G4LogicalVolumeStore.hh"
+#include "G4ParticleTable.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4VTouchable.hh"
+#include "G4DynamicParticle.hh"
+#include "G4SteppingManager.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
 #include "G4Step.hh"
 #include "G4Track.hh"
 #include "G4LogicalVolume.hh"
@@ -13,51 +29,287 @@ namespace G4Sim
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-SteppingAction::SteppingAction(EventAction* eventAction): G4UserSteppingAction(){
-
+SteppingAction::SteppingAction(EventAction* eventAction, const DetectorConstruction* detector)
+  : G4UserSteppingAction(), fEventAction(eventAction), fDetector(detector)
+{
+  fMessenger = new SteppingActionMessenger(this);
 }
 
 
 SteppingAction::~SteppingAction()
-{}
+{
+  delete fMessenger;
+}
+
+/**
+ * @brief Records the particles that cross into a volume to a phase space file.
+ *
+ * The file of a previous /phaseSpace/record is closed. An empty volume name stops recording.
+ *
+ * @param volumeName The name of the logical volume.
+ * @param fileName The name of the phase space file, see PhaseSpaceWriter::MakeFileName().
+ */
+void SteppingAction::SetPhaseSpace(const G4String& volumeName, const G4String& fileName)
+{
+  fPhaseSpaceWriter.reset();
+  fPhaseSpaceVolume = nullptr;
+  fPhaseSpaceVolumeName = volumeName;
+  if (!volumeName.empty()) fPhaseSpaceWriter = std::make_unique<PhaseSpaceWriter>(fileName);
+}
+
+/**
+ * @brief Returns the step tracer of this thread, created at the first call.
+ */
+StepTracer* SteppingAction::GetStepTracer()
+{
+  if (!fStepTracer) fStepTracer = std::make_unique<StepTracer>();
+  return fStepTracer.get();
+}
+
+/**
+ * @brief Traces the steps to a file, or stops tracing with an empty file name.
+ *
+ * @param fileName The name of the step trace file, see StepTracer::MakeFileName().
+ */
+void SteppingAction::SetStepTraceFile(const G4String& fileName)
+{
+  StepTracer* tracer = GetStepTracer();
+  if (fileName.empty()) {
+    tracer->Close();
+    fActiveTracer = nullptr;
+    return;
+  }
+  tracer->Open(fileName);
+  fActiveTracer = tracer;
+}
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 /**
  * @brief Performs the user-defined stepping action for each step of a particle in the simulation.
  *
- * This function is called for each step of a particle in the simulation. It checks if the event is a fast simulation event,
- * and if not, it calls the `AnalyzeStandardStep` function to analyze the standard step. If the event is a fast simulation event,
- * it performs various operations based on the particle's properties and the current volume.
+ * This function is called for each step of a particle in the simulation. The step is traced if a step trace file
+ * is open, the termination policy of the volume in which the step ended is applied, particles that enter the phase
+ * space volume are recorded, and tracks that cross into a volume of different importance are split or play Russian
+ * roulette.
  *
  * @param step The G4Step object representing the current step of the particle.
  */
 void SteppingAction::UserSteppingAction(const G4Step* step)
 {
-  if (verbosityLevel >= 2) Print(step);
+  if (fActiveTracer) fActiveTracer->Trace(step);
+
+  if (!fPolicies.empty()) {
+    const G4VPhysicalVolume* volume = step->GetPostStepPoint()->GetPhysicalVolume();
+    G4int instanceID = volume ? volume->GetLogicalVolume()->GetInstanceID() : -1;
+    if (instanceID >= 0 && instanceID < static_cast<G4int>(fPolicyIndex.size()) && fPolicyIndex[instanceID] >= 0) {
+      G4Track* track = step->GetTrack();
+      if (track->GetTrackStatus() == fAlive && IsTerminated(fPolicies[fPolicyIndex[instanceID]], track)) {
+        track->SetTrackStatus(fStopAndKill);
+      }
+    }
+  }
+
+  if (fPhaseSpaceWriter) RecordPhaseSpace(step);
+
+  if (!fImportance.empty()) ApplyImportance(step);
 }
-//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 /**
- * Prints information about the given step.
+ * @brief Writes a track that enters the phase space volume to the phase space file, and kills it if requested.
+ *
+ * Only entries from outside the volume are recorded, not returns from its daughters (with /phaseSpace/killAtSurface
+ * false).
+ *
+ * @param step The step of the track.
+ */
+void SteppingAction::RecordPhaseSpace(const G4Step* step)
+{
+  const G4StepPoint* postStepPoint = step->GetPostStepPoint();
+  if (postStepPoint->GetStepStatus() != fGeomBoundary) return;
+
+  if (!fPhaseSpaceVolume) {
+    fPhaseSpaceVolume = G4LogicalVolumeStore::GetInstance()->GetVolume(fPhaseSpaceVolumeName, false);
+    if (!fPhaseSpaceVolume) {
+      G4ExceptionDescription msg;
+      msg << "Unknown phase space volume " << fPhaseSpaceVolumeName << G4endl;
+      G4Exception("SteppingAction::RecordPhaseSpace()", "PhaseSpace0003", FatalException, msg);
+      return;
+    }
+  }
+
+  const G4VPhysicalVolume* postVolume = postStepPoint->GetPhysicalVolume();
+  if (!postVolume || postVolume->GetLogicalVolume() != fPhaseSpaceVolume) return;
+
+  // only entries from outside: a track that comes back from a daughter of the volume was recorded when it entered
+  const G4VTouchable* preTouchable = step->GetPreStepPoint()->GetTouchable();
+  for (G4int depth = 0; preTouchable && depth <= preTouchable->GetHistoryDepth(); ++depth) {
+    const G4VPhysicalVolume* volume = preTouchable->GetVolume(depth);
+    if (volume && volume->GetLogicalVolume() == fPhaseSpaceVolume) return;
+  }
+
+  G4Track* track = step->GetTrack();
+  if (track->GetTrackStatus() != fAlive) return;
+
+  const G4ThreeVector& position = postStepPoint->GetPosition();
+  const G4ThreeVector& direction = postStepPoint->GetMomentumDirection();
+  PhaseSpaceRecord record;
+  record.eventID = EventSeeder::Instance()->GetEventNumber(
+      G4EventManager::GetEventManager()->GetConstCurrentEvent()->GetEventID());
+  record.pdgCode = track->GetParticleDefinition()->GetPDGEncoding();
+  record.x = position.x();
+  record.y = position.y();
+  record.z = position.z();
+  record.dx = direction.x();
+  record.dy = direction.y();
+  record.dz = direction.z();
+  record.kineticEnergy = postStepPoint->GetKineticEnergy();
+  record.time = postStepPoint->GetGlobalTime();
+  record.weight = track->GetWeight();
+  fPhaseSpaceWriter->Write(record);
+
+  if (fPhaseSpaceKill) track->SetTrackStatus(fStopAndKill);
+}
+
+/**
+ * @brief Builds the lookup table of the termination policies of the geometry.
+ *
+ * Called by the RunAction of this thread at the start of every run, when the geometry is built and the particle table
+ * is complete, so that the tables follow /run/reinitializeGeometry. Particle names that are not known are reported
+ * and ignored. The importances of the volumes are resolved in the same way, and the phase space volume is looked up
+ * again at the next step.
+ */
+void SteppingAction::ResolvePolicies()
+{
+  fPolicies.clear();
+  fPolicyIndex.clear();
+  fImportance.clear();
+  fImportanceParticles.clear();
+  fPhaseSpaceVolume = nullptr;
+  if (!fDetector) return;
+
+  G4ParticleTable* particleTable = G4ParticleTable::GetParticleTable();
+  for (const auto& terminationPolicy : fDetector->GetTerminationPolicies()) {
+    VolumePolicy policy;
+    policy.killOnEntry = terminationPolicy.killOnEntry;
+    policy.maxTime = terminationPolicy.maxTime;
+    policy.minKineticEnergy = terminationPolicy.minKineticEnergy;
+    for (const auto& particleEnergy : terminationPolicy.particleMinKineticEnergy) {
+      const G4ParticleDefinition* particle = particleTable->FindParticle(particleEnergy.first);
+      if (!particle) {
+        G4cerr << "SteppingAction::ResolvePolicies: Warning: unknown particle " << particleEnergy.first
+               << " in the termination policy of " << terminationPolicy.volumeName << G4endl;
+        continue;
+      }
+      policy.particleMinKineticEnergy.emplace_back(particle, particleEnergy.second);
+    }
+
+    G4int instanceID = terminationPolicy.logicalVolume->GetInstanceID();
+    if (instanceID >= static_cast<G4int>(fPolicyIndex.size())) fPolicyIndex.resize(instanceID + 1, -1);
+    fPolicyIndex[instanceID] = static_cast<G4int>(fPolicies.size());
+    fPolicies.push_back(policy);
+  }
+
+  for (const auto& volumeImportance : fDetector->GetVolumeImportances()) {
+    G4int instanceID = volumeImportance.logicalVolume->GetInstanceID();
+    if (instanceID >= static_cast<G4int>(fImportance.size())) fImportance.resize(instanceID + 1, 0.);
+    fImportance[instanceID] = volumeImportance.importance;
+  }
+  for (const auto& particleName : fDetector->GetImportanceParticles()) {
+    const G4ParticleDefinition* particle = particleTable->FindParticle(particleName);
+    if (!particle) {
+      G4cerr << "SteppingAction::ResolvePolicies: Warning: unknown particle " << particleName
+             << " in importanceParticles" << G4endl;
+      continue;
+    }
+    fImportanceParticles.push_back(particle);
+  }
+}
+
+/**
+ * @brief Returns the importance of a volume, or 0 if it has none (e.g. outside the world).
+ */
+G4double SteppingAction::GetImportance(const G4VPhysicalVolume* volume) const
+{
+  if (!volume) return 0.;
+  G4int instanceID = volume->GetLogicalVolume()->GetInstanceID();
+  if (instanceID < 0 || instanceID >= static_cast<G4int>(fImportance.size())) return 0.;
+  return fImportance[instanceID];
+}
+
+/**
+ * @brief Splits or plays Russian roulette with a track that crosses into a volume of different importance.
+ *
+ * With a ratio r of the importance after and before the boundary, a track is split into on average r copies with
+ * the weight divided by r (the integer part of r copies, plus one with the probability of the fractional part).
+ * For r < 1 the track survives with probability r and its weight is divided by r. The copies are added to the
+ * secondaries of the track, and start at the boundary with the same momentum and time.
  *
- * @param step The step for which to print information.
+ * @param step The step of the track.
  */
-void SteppingAction::Print(const G4Step* step) {
+void SteppingAction::ApplyImportance(const G4Step* step)
+{
+  const G4StepPoint* postStepPoint = step->GetPostStepPoint();
+  if (postStepPoint->GetStepStatus() != fGeomBoundary) return;
 
   G4Track* track = step->GetTrack();
-  G4LogicalVolume* volume_pre = step->GetPreStepPoint()->GetTouchableHandle()->GetVolume()->GetLogicalVolume();
-  G4String processType = step->GetPostStepPoint()->GetProcessDefinedStep()->GetProcessName();
-
-  // if Verbose level >=2 print this information
-
-  G4cout << "SteppingAction::Print track ID             : " << track->GetTrackID() << G4endl;
-  G4cout << "                      track parent ID      : " << track->GetParentID() << G4endl;
-  G4cout << "                      particle name        : " << track->GetParticleDefinition()->GetParticleName() << G4endl;
-  G4cout << "                      energy               : " << track->GetKineticEnergy() / keV << " keV"<< G4endl;
-  G4cout << "                      volume_pre name      : " << volume_pre->GetName() << G4endl;
-  G4cout << "                      volume_pre position  : " << step->GetPreStepPoint()->GetPosition()/cm << " cm"<<G4endl;
-  G4cout << "                      volume_post position : " << step->GetPostStepPoint()->GetPosition()/cm << " cm"<<G4endl;
-  G4cout << "                      process type         : " << processType << G4endl;
+  if (track->GetTrackStatus() != fAlive) return;
+  if (std::find(fImportanceParticles.begin(), fImportanceParticles.end(), track->GetParticleDefinition())
+      == fImportanceParticles.end()) return;
+
+  G4double preImportance = GetImportance(step->GetPreStepPoint()->GetPhysicalVolume());
+  G4double postImportance = GetImportance(postStepPoint->GetPhysicalVolume());
+  if (preImportance <= 0. || postImportance <= 0. || preImportance == postImportance) return;
+
+  G4double ratio = postImportance / preImportance;
+  if (ratio < 1.) {
+    // Russian roulette
+    if (G4UniformRand() < ratio) {
+      track->SetWeight(track->GetWeight() / ratio);
+    } else {
+      track->SetTrackStatus(fStopAndKill);
+    }
+    return;
+  }
+
+  // splitting
+  G4int nCopies = static_cast<G4int>(ratio);
+  if (G4UniformRand() < ratio - nCopies) nCopies++;
+  G4double weight = track->GetWeight() / ratio;
+  track->SetWeight(weight);
+
+  G4TrackVector* secondaries = fpSteppingManager->GetfSecondary();
+  for (G4int i = 1; i < nCopies; ++i) {
+    auto* copy = new G4Track(new G4DynamicParticle(*track->GetDynamicParticle()), track->GetGlobalTime(), track->GetPosition());
+    copy->SetWeight(weight);
+    copy->SetParentID(track->GetTrackID());
+    copy->SetCreatorProcess(track->GetCreatorProcess());
+    // the touchable of the track is still the volume it leaves, the copies start in the volume it enters
+    copy->SetTouchableHandle(track->GetNextTouchableHandle());
+    secondaries->push_back(copy);
+  }
+}
+
+/**
+ * @brief Checks the conditions of a termination policy for a track at the end of its step.
+ *
+ * @param policy The policy of the volume in which the step ended.
+ * @param track The track.
+ * @return true if the track has to be killed.
+ */
+G4bool SteppingAction::IsTerminated(const VolumePolicy& policy, const G4Track* track) const
+{
+  if (policy.killOnEntry) return true;
+  if (policy.maxTime > 0. && track->GetGlobalTime() > policy.maxTime) return true;
+
+  G4double minKineticEnergy = policy.minKineticEnergy;
+  const G4ParticleDefinition* particle = track->GetParticleDefinition();
+  for (const auto& particleEnergy : policy.particleMinKineticEnergy) {
+    if (particleEnergy.first == particle) {
+      minKineticEnergy = particleEnergy.second;
+      break;
+    }
+  }
+  return track->GetKineticEnergy() < minKineticEnergy;
 }
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
@@ -0,0 +1,119 @@
+#include "SteppingActionMessenger.hh"
+#include "SteppingAction.hh"
+#include "StepTracer.hh"
+#include "G4UIparameter.hh"
+
+#include <sstream>
+
+namespace G4Sim {
+
+/**
+ * @brief Constructs a SteppingActionMessenger object.
+ *
+ * @param steppingAction Pointer to the SteppingAction object.
+ */
+SteppingActionMessenger::SteppingActionMessenger(SteppingAction* steppingAction)
+    : G4UImessenger(), fSteppingAction(steppingAction) {
+
+    fPhaseSpaceDirectory = new G4UIdirectory("/phaseSpace/");
+    fPhaseSpaceDirectory->SetGuidance("Record the particles that enter a volume, and replay them as primaries.");
+
+    fRecordCmd = new G4UIcommand("/phaseSpace/record", this);
+    fRecordCmd->SetGuidance("Write every particle that enters the volume to a phase space file (.xps, one per thread).");
+    fRecordCmd->SetGuidance("Replay the files with /phaseSpace/replay/addFile.");
+    auto* volumeParameter = new G4UIparameter("volume", 's', false);
+    fRecordCmd->SetParameter(volumeParameter);
+    auto* fileParameter = new G4UIparameter("fileName", 's', false);
+    fRecordCmd->SetParameter(fileParameter);
+    fRecordCmd->SetGuidance("Available after /run/initialize, when the stepping actions of the threads exist.");
+    fRecordCmd->AvailableForStates(G4State_Idle);
+
+    fKillAtSurfaceCmd = new G4UIcmdWithABool("/phaseSpace/killAtSurface", this);
+    fKillAtSurfaceCmd->SetGuidance("Kill the recorded particles at the surface of the volume (default true).");
+    fKillAtSurfaceCmd->SetParameterName("kill", false);
+    fKillAtSurfaceCmd->AvailableForStates(G4State_Idle);
+
+    fStepTraceDirectory = new G4UIdirectory("/stepTrace/");
+    fStepTraceDirectory->SetGuidance("Write the steps of selected events, volumes and particles to a binary file.");
+
+    fStepTraceFileCmd = new G4UIcmdWithAString("/stepTrace/file", this);
+    fStepTraceFileCmd->SetGuidance("Trace the steps to a file (.xst, one per thread), see analysis/StepTraceReader.py.");
+    fStepTraceFileCmd->SetGuidance("An empty name stops tracing.");
+    fStepTraceFileCmd->SetParameterName("fileName", true);
+    fStepTraceFileCmd->SetDefaultValue("");
+    fStepTraceFileCmd->AvailableForStates(G4State_Idle);
+
+    fStepTraceEventsCmd = new G4UIcommand("/stepTrace/events", this);
+    fStepTraceEventsCmd->SetGuidance("Only trace the events with an ID in [first, last]. last -1 means no limit.");
+    fStepTraceEventsCmd->SetGuidance("The ID is the global event number, including /run/eventOffset.");
+    auto* firstParameter = new G4UIparameter("first", 'i', false);
+    firstParameter->SetParameterRange("first>=0");
+    fStepTraceEventsCmd->SetParameter(firstParameter);
+    auto* lastParameter = new G4UIparameter("last", 'i', true);
+    lastParameter->SetDefaultValue(-1);
+    fStepTraceEventsCmd->SetParameter(lastParameter);
+    fStepTraceEventsCmd->AvailableForStates(G4State_Idle);
+
+    fStepTraceVolumeCmd = new G4UIcmdWithAString("/stepTrace/volume", this);
+    fStepTraceVolumeCmd->SetGuidance("Only trace steps that start in this logical volume. Repeat for more volumes.");
+    fStepTraceVolumeCmd->SetParameterName("volume", false);
+    fStepTraceVolumeCmd->AvailableForStates(G4State_Idle);
+
+    fStepTraceParticleCmd = new G4UIcmdWithAString("/stepTrace/particle", this);
+    fStepTraceParticleCmd->SetGuidance("Only trace steps of this particle. Repeat for more particles.");
+    fStepTraceParticleCmd->SetParameterName("particle", false);
+    fStepTraceParticleCmd->AvailableForStates(G4State_Idle);
+
+    fStepTraceBufferSizeCmd = new G4UIcmdWithAnInteger("/stepTrace/bufferSize", this);
+    fStepTraceBufferSizeCmd->SetGuidance("Set the number of steps buffered per thread before they are written.");
+    fStepTraceBufferSizeCmd->SetParameterName("bufferSize", false);
+    fStepTraceBufferSizeCmd->SetRange("bufferSize>0");
+    fStepTraceBufferSizeCmd->AvailableForStates(G4State_Idle);
+}
+
+/**
+ * @brief Destructor for the SteppingActionMessenger class.
+ */
+SteppingActionMessenger::~SteppingActionMessenger() {
+    delete fRecordCmd;
+    delete fKillAtSurfaceCmd;
+    delete fPhaseSpaceDirectory;
+    delete fStepTraceFileCmd;
+    delete fStepTraceEventsCmd;
+    delete fStepTraceVolumeCmd;
+    delete fStepTraceParticleCmd;
+    delete fStepTraceBufferSizeCmd;
+    delete fStepTraceDirectory;
+}
+
+/**
+ * @brief Sets the new value for a given command.
+ *
+ * @param command The command for which the new value is being set.
+ * @param newValue The new value to be set.
+ */
+void SteppingActionMessenger::SetNewValue(G4UIcommand* command, G4String newValue) {
+    if (command == fRecordCmd) {
+        std::istringstream is(newValue);
+        G4String volumeName, fileName;
+        is >> volumeName >> fileName;
+        fSteppingAction->SetPhaseSpace(volumeName, fileName);
+    } else if (command == fKillAtSurfaceCmd) {
+        fSteppingAction->SetPhaseSpaceKill(fKillAtSurfaceCmd->GetNewBoolValue(newValue));
+    } else if (command == fStepTraceFileCmd) {
+        fSteppingAction->SetStepTraceFile(newValue);
+    } else if (command == fStepTraceEventsCmd) {
+        std::istringstream is(newValue);
+        G4int first = 0, last = -1;
+        is >> first >> last;
+        fSteppingAction->GetStepTracer()->SetEventRange(first, last);
+    } else if (command == fStepTraceVolumeCmd) {
+        fSteppingAction->GetStepTracer()->AddVolume(newValue);
+    } else if (command == fStepTraceParticleCmd) {
+        fSteppingAction->GetStepTracer()->AddParticle(newValue);
+    } else if (command == fStepTraceBufferSizeCmd) {
+        fSteppingAction->GetStepTracer()->SetBufferSize(fStepTraceBufferSizeCmd->GetNewIntValue(newValue));
+    }
+}
+
+} // namespace G4Sim
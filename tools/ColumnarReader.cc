@@ -0,0 +1,158 @@
+#include "ColumnarReader.hh"
+
+#include <cstring>
+#include <stdexcept>
+
+#ifdef G4XAMSSIM_USE_ZSTD
+#include <zstd.h>
+#endif
+
+// the blocks are used as they are read, the format is little endian
+#if !defined(__BYTE_ORDER__) || __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "ColumnarReader requires a little endian host"
+#endif
+
+/**
+ * @namespace G4Sim
+ * @brief Namespace for the G4Sim library.
+/*/
+namespace G4Sim {
+
+namespace {
+    const char kHeaderMagic[8] = {'X', 'A', 'M', 'S', 'C', 'O', 'L', '1'};
+    const char kFooterMagic[8] = {'X', 'A', 'M', 'S', 'E', 'N', 'D', '1'};
+}
+
+/**
+ * @brief Opens the file and reads the column definitions and the chunk index.
+ *
+ * @param fileName The .xcol file.
+ */
+ColumnarReader::ColumnarReader(const std::string& fileName)
+    : fFileName(fileName), fFile(fileName, std::ios::binary) {
+    if (!fFile) throw std::runtime_error("cannot open " + fileName);
+
+    char magic[8];
+    ReadRaw(magic, sizeof(magic));
+    if (std::memcmp(magic, kHeaderMagic, sizeof(magic)) != 0) {
+        throw std::runtime_error(fileName + " is not a G4XamsSim columnar file");
+    }
+    std::uint32_t nColumns = 0;
+    ReadRaw(&fCompression, sizeof(fCompression));
+    ReadRaw(&nColumns, sizeof(nColumns));
+    for (std::uint32_t i = 0; i < nColumns; ++i) {
+        std::uint32_t type = 0;
+        std::uint32_t length = 0;
+        ReadRaw(&type, sizeof(type));
+        ReadRaw(&length, sizeof(length));
+        std::string name(length, '\0');
+        ReadRaw(&name[0], length);
+        Align();
+        fColumns.push_back({name, static_cast<ColumnType>(type)});
+    }
+
+    // footer: ..., uint64 footer offset, "XAMSEND1"
+    fFile.seekg(-16, std::ios::end);
+    std::uint64_t footerOffset = 0;
+    fFile.read(reinterpret_cast<char*>(&footerOffset), sizeof(footerOffset));
+    fFile.read(magic, sizeof(magic));
+    if (!fFile || std::memcmp(magic, kFooterMagic, sizeof(magic)) != 0) {
+        throw std::runtime_error(fileName + " is incomplete (no footer), was the run finished?");
+    }
+    fFile.seekg(footerOffset);
+    fPosition = footerOffset;
+    std::uint64_t nChunks = 0;
+    ReadRaw(&nChunks, sizeof(nChunks));
+    fChunkOffsets.resize(nChunks);
+    fChunkRows.resize(nChunks);
+    for (std::uint64_t i = 0; i < nChunks; ++i) {
+        ReadRaw(&fChunkOffsets[i], sizeof(std::uint64_t));
+        ReadRaw(&fChunkRows[i], sizeof(std::uint64_t));
+    }
+}
+
+/**
+ * @brief Returns the index of a column, or -1 if the file has no column with that name.
+ */
+G4int ColumnarReader::GetColumnIndex(const std::string& name) const {
+    for (size_t i = 0; i < fColumns.size(); ++i) {
+        if (fColumns[i].name == name) return static_cast<G4int>(i);
+    }
+    return -1;
+}
+
+std::uint64_t ColumnarReader::GetNumberOfRows() const {
+    std::uint64_t nRows = 0;
+    for (std::uint64_t rows : fChunkRows) nRows += rows;
+    return nRows;
+}
+
+/**
+ * @brief Reads one chunk. The vectors of the chunk keep their capacity, so a chunk can be reused for the next one.
+ *
+ * @param index The index of the chunk.
+ * @param chunk Filled with the rows of the chunk.
+ */
+void ColumnarReader::ReadChunk(size_t index, Chunk& chunk) {
+    fFile.clear();
+    fFile.seekg(fChunkOffsets.at(index));
+    fPosition = fChunkOffsets[index];
+
+    ReadRaw(&chunk.nRows, sizeof(chunk.nRows));
+    chunk.columns.resize(fColumns.size());
+    for (size_t i = 0; i < fColumns.size(); ++i) {
+        Column& column = chunk.columns[i];
+        column.offsets.clear();
+        column.doubleValues.clear();
+        column.intValues.clear();
+        if (fColumns[i].type != kDouble) ReadBlock(column.offsets);
+        if (fColumns[i].type == kJaggedInt) {
+            ReadBlock(column.intValues);
+        } else {
+            ReadBlock(column.doubleValues);
+        }
+    }
+}
+
+template <typename T>
+void ColumnarReader::ReadBlock(std::vector<T>& values) {
+    std::uint64_t rawSize = 0;
+    std::uint64_t storedSize = 0;
+    ReadRaw(&rawSize, sizeof(rawSize));
+    ReadRaw(&storedSize, sizeof(storedSize));
+    values.resize(rawSize / sizeof(T));
+
+    if (storedSize == rawSize) {
+        ReadRaw(values.data(), rawSize);
+    } else {
+#ifdef G4XAMSSIM_USE_ZSTD
+        fCompressedBuffer.resize(storedSize);
+        ReadRaw(fCompressedBuffer.data(), storedSize);
+        size_t size = ZSTD_decompress(values.data(), rawSize, fCompressedBuffer.data(), storedSize);
+        if (ZSTD_isError(size) || size != rawSize) {
+            throw std::runtime_error("corrupt compressed block in " + fFileName);
+        }
+#else
+        throw std::runtime_error(fFileName + " is compressed, rebuild with WITH_ZSTD to read it");
+#endif
+    }
+    Align();
+}
+
+void ColumnarReader::ReadRaw(void* data, size_t size) {
+    if (size == 0) return;
+    if (!fFile.read(static_cast<char*>(data), size)) {
+        throw std::runtime_error("unexpected end of " + fFileName);
+    }
+    fPosition += size;
+}
+
+void ColumnarReader::Align() {
+    size_t padding = (8 - fPosition % 8) % 8;
+    if (padding > 0) {
+        fFile.seekg(padding, std::ios::cur);
+        fPosition += padding;
+    }
+}
+
+} // namespace G4Sim
@@ -0,0 +1,77 @@
+#ifndef COLUMNAR_READER_HH
+#define COLUMNAR_READER_HH
+
+#include "G4Types.hh"
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+ * @namespace G4Sim
+ * @brief Namespace for the G4Sim library.
+/*/
+namespace G4Sim {
+
+/**
+ * @class ColumnarReader
+ * @brief Reads the columnar files written by ColumnarOutput (.xcol) one chunk at a time.
+ *
+ * Only the column definitions and the chunk index are kept in memory, so the memory use is bounded by the size of
+ * one chunk. Compressed blocks need a build with WITH_ZSTD. Errors are reported with std::runtime_error.
+ */
+class ColumnarReader {
+public:
+    enum ColumnType : std::uint32_t { kDouble = 0, kJaggedDouble = 1, kJaggedInt = 2 };
+
+    struct ColumnInfo {
+        std::string name;
+        ColumnType type;
+    };
+
+    /**
+     * @struct Column
+     * @brief The values of one column in a chunk. Jagged columns have nRows+1 offsets into the values.
+     */
+    struct Column {
+        std::vector<std::uint64_t> offsets;
+        std::vector<G4double> doubleValues;
+        std::vector<std::int32_t> intValues;
+    };
+
+    struct Chunk {
+        std::uint64_t nRows = 0;
+        std::vector<Column> columns;
+    };
+
+    explicit ColumnarReader(const std::string& fileName);
+    ~ColumnarReader() = default;
+
+    const std::string& GetFileName() const { return fFileName; }
+    const std::vector<ColumnInfo>& GetColumns() const { return fColumns; }
+    G4int GetColumnIndex(const std::string& name) const;
+    size_t GetNumberOfChunks() const { return fChunkOffsets.size(); }
+    std::uint64_t GetNumberOfRows() const;
+
+    void ReadChunk(size_t index, Chunk& chunk);
+
+private:
+    template <typename T>
+    void ReadBlock(std::vector<T>& values);
+    void ReadRaw(void* data, size_t size);
+    void Align();
+
+    std::string fFileName;
+    std::ifstream fFile;
+    std::uint64_t fPosition = 0;
+    std::uint32_t fCompression = 0;
+    std::vector<ColumnInfo> fColumns;
+    std::vector<std::uint64_t> fChunkOffsets;
+    std::vector<std::uint64_t> fChunkRows;
+    std::vector<char> fCompressedBuffer;
+};
+
+} // namespace G4Sim
+
+#endif
@@ -0,0 +1,297 @@
+//
+// Merges and reduces the per-job columnar output files (.xcol) of a run.
+//
+// The files are read one chunk at a time by a pool of threads, so the memory use is bounded by a few chunks per
+// thread, however many jobs a run has. Every chunk passes the event and hit cuts (see tools/Reduction.hh), after
+// which the selected events are
+//   - appended to one merged columnar file, which analysis/ColumnarReader.py reads like a job output, and/or
+//   - filled into weighted histograms, written as one JSON file (read with read_histograms in ColumnarReader.py).
+// With more than one thread the chunks of different files are appended in the order in which they are done.
+//
+// Usage: G4XamsSim_merge [options] input...
+//   input                      a .xcol file, or a run directory (the outputDir in rundb.json) of which all .xcol
+//                              files are read; ROOT files are skipped (merge them with hadd)
+//   -o, --output FILE.xcol     write the selected events to one merged file
+//   --cut EXPR                 event cut on a scalar column, e.g. "trig==1" (repeatable, all must pass)
+//   --hit-cut EXPR             hit cut on a hit column, e.g. "eh>1" (repeatable)
+//   --hist COLUMN:N:MIN:MAX    histogram of a column with N bins (repeatable)
+//   --hist-output FILE.json    histogram file (default histograms.json)
+//   --unweighted               fill the histograms without the event and hit weights
+//   -j, --threads N            number of threads (default: number of cores)
+//   --chunk-size N             events per chunk of the merged file (default 10000)
+//   --compression none|zstd    compression of the merged file (zstd requires a build with WITH_ZSTD)
+//
+// Exit code: 0 on success, 1 if an input file could not be read, 3 on a usage error.
+//
+
+#include "ColumnarReader.hh"
+#include "Reduction.hh"
+
+#include "ColumnarOutput.hh"
+
+#include "nlohmann/json.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace G4Sim;
+
+namespace {
+
+struct Options {
+    std::vector<std::string> inputs;
+    std::string outputFile;
+    std::vector<Cut> eventCuts;
+    std::vector<Cut> hitCuts;
+    std::vector<Histogram> histograms;
+    std::string histogramFile = "histograms.json";
+    G4bool weighted = true;
+    size_t nThreads = std::max(1u, std::thread::hardware_concurrency());
+    size_t chunkSize = 10000;
+    ColumnarOutput::Compression compression = ColumnarOutput::kNone;
+};
+
+void PrintUsage() {
+    std::cerr << "Usage: G4XamsSim_merge [-o merged.xcol] [--cut expr] [--hit-cut expr] [--hist column:n:min:max]"
+              << " [--hist-output file.json] [--unweighted] [-j threads] [--chunk-size n]"
+              << " [--compression none|zstd] input..." << std::endl;
+}
+
+/**
+ * @brief Returns the .xcol files of the inputs; directories are replaced by the .xcol files in them.
+ */
+std::vector<std::string> ListFiles(const std::vector<std::string>& inputs, const std::string& outputFile) {
+    namespace fs = std::filesystem;
+    std::vector<std::string> files;
+    for (const std::string& input : inputs) {
+        if (!fs::is_directory(input)) {
+            files.push_back(input);
+            continue;
+        }
+        std::vector<std::string> directoryFiles;
+        size_t nRootFiles = 0;
+        for (const auto& entry : fs::directory_iterator(input)) {
+            if (entry.path().extension() == ".xcol") directoryFiles.push_back(entry.path().string());
+            if (entry.path().extension() == ".root") nRootFiles++;
+        }
+        if (nRootFiles > 0) {
+            std::cerr << "Warning: skipping " << nRootFiles << " ROOT files in " << input << " (merge them with hadd)"
+                      << std::endl;
+        }
+        std::sort(directoryFiles.begin(), directoryFiles.end());
+        files.insert(files.end(), directoryFiles.begin(), directoryFiles.end());
+    }
+
+    // a merged file from an earlier pass over the same directory is not an input
+    if (!outputFile.empty()) {
+        std::error_code error;
+        files.erase(std::remove_if(files.begin(), files.end(), [&](const std::string& file) {
+            return fs::equivalent(file, ColumnarOutput::MakeFileName(outputFile), error);
+        }), files.end());
+    }
+    return files;
+}
+
+/**
+ * @class MergedOutput
+ * @brief Appends the rows of chunks to a ColumnarOutput with the columns of the input files.
+ */
+class MergedOutput {
+public:
+    MergedOutput(const std::string& fileName, const std::vector<ColumnarReader::ColumnInfo>& columns,
+                 size_t chunkSize, ColumnarOutput::Compression compression)
+        : fOutput(chunkSize, compression), fColumns(columns),
+          fDoubleValues(columns.size()), fIntValues(columns.size()) {
+        fOutput.OpenFile(fileName);
+        fOutput.CreateNtuple("ev", "events");
+        for (size_t c = 0; c < columns.size(); ++c) {
+            switch (columns[c].type) {
+                case ColumnarReader::kDouble: fOutput.CreateDColumn(columns[c].name); break;
+                case ColumnarReader::kJaggedDouble: fOutput.CreateDColumn(columns[c].name, fDoubleValues[c]); break;
+                case ColumnarReader::kJaggedInt: fOutput.CreateIColumn(columns[c].name, fIntValues[c]); break;
+            }
+        }
+        fOutput.FinishNtuple();
+    }
+
+    void Append(const ColumnarReader::Chunk& chunk) {
+        for (std::uint64_t row = 0; row < chunk.nRows; ++row) {
+            for (size_t c = 0; c < fColumns.size(); ++c) {
+                const ColumnarReader::Column& column = chunk.columns[c];
+                switch (fColumns[c].type) {
+                    case ColumnarReader::kDouble:
+                        fOutput.FillDColumn(static_cast<G4int>(c), column.doubleValues[row]);
+                        break;
+                    case ColumnarReader::kJaggedDouble:
+                        fDoubleValues[c].assign(column.doubleValues.begin() + column.offsets[row],
+                                                column.doubleValues.begin() + column.offsets[row + 1]);
+                        break;
+                    case ColumnarReader::kJaggedInt:
+                        fIntValues[c].assign(column.intValues.begin() + column.offsets[row],
+                                             column.intValues.begin() + column.offsets[row + 1]);
+                        break;
+                }
+            }
+            fOutput.AddRow();
+        }
+    }
+
+    void Close() { fOutput.CloseFile(); }
+
+private:
+    ColumnarOutput fOutput;
+    std::vector<ColumnarReader::ColumnInfo> fColumns;
+    // bound to the jagged columns of the output, so they are never resized after the construction
+    std::vector<std::vector<G4double>> fDoubleValues;
+    std::vector<std::vector<G4int>> fIntValues;
+};
+
+G4bool SameColumns(const std::vector<ColumnarReader::ColumnInfo>& a, const std::vector<ColumnarReader::ColumnInfo>& b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](const auto& x, const auto& y) {
+        return x.name == y.name && x.type == y.type;
+    });
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string argument = argv[i];
+            auto next = [&]() -> std::string {
+                if (i + 1 >= argc) {
+                    PrintUsage();
+                    std::exit(3);
+                }
+                return argv[++i];
+            };
+            if (argument == "-o" || argument == "--output") options.outputFile = next();
+            else if (argument == "--cut") options.eventCuts.push_back(Cut::Parse(next()));
+            else if (argument == "--hit-cut") options.hitCuts.push_back(Cut::Parse(next()));
+            else if (argument == "--hist") options.histograms.push_back(Histogram::Parse(next()));
+            else if (argument == "--hist-output") options.histogramFile = next();
+            else if (argument == "--unweighted") options.weighted = false;
+            else if (argument == "-j" || argument == "--threads") options.nThreads = std::max(1ul, std::stoul(next()));
+            else if (argument == "--chunk-size") options.chunkSize = std::stoul(next());
+            else if (argument == "--compression") {
+                std::string compression = next();
+                if (compression != "none" && compression != "zstd") throw std::runtime_error("bad compression " + compression);
+                options.compression = compression == "zstd" ? ColumnarOutput::kZstd : ColumnarOutput::kNone;
+            }
+            else if (!argument.empty() && argument[0] == '-') throw std::runtime_error("unknown option " + argument);
+            else options.inputs.push_back(argument);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        PrintUsage();
+        return 3;
+    }
+    if (options.inputs.empty() || (options.outputFile.empty() && options.histograms.empty())) {
+        std::cerr << "Give the input files, and -o and/or --hist" << std::endl;
+        PrintUsage();
+        return 3;
+    }
+
+    const std::vector<std::string> files = ListFiles(options.inputs, options.outputFile);
+    if (files.empty()) {
+        std::cerr << "No .xcol files found" << std::endl;
+        return 1;
+    }
+
+    // the first file defines the columns, the other files must have the same
+    std::vector<ColumnarReader::ColumnInfo> columns;
+    Reduction prototype(options.eventCuts, options.hitCuts, options.histograms, options.weighted);
+    try {
+        columns = ColumnarReader(files.front()).GetColumns();
+        prototype.Bind(columns);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return files.size() == 1 ? 1 : 3;
+    }
+
+    std::unique_ptr<MergedOutput> output;
+    if (!options.outputFile.empty()) {
+        output = std::make_unique<MergedOutput>(options.outputFile, columns, options.chunkSize, options.compression);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    size_t nThreads = std::min(options.nThreads, files.size());
+    std::vector<Reduction> reductions(nThreads, prototype);
+    std::atomic<size_t> nextFile{0};
+    std::atomic<std::uint64_t> nEventsRead{0};
+    std::atomic<std::uint64_t> nEventsSelected{0};
+    std::atomic<G4bool> failed{false};
+    std::mutex outputMutex;
+
+    auto work = [&](Reduction& reduction) {
+        ColumnarReader::Chunk chunk;
+        ColumnarReader::Chunk selection;
+        for (size_t index; (index = nextFile++) < files.size();) {
+            try {
+                ColumnarReader reader(files[index]);
+                if (!SameColumns(reader.GetColumns(), columns)) {
+                    throw std::runtime_error(files[index] + " has other columns than " + files.front());
+                }
+                for (size_t i = 0; i < reader.GetNumberOfChunks(); ++i) {
+                    reader.ReadChunk(i, chunk);
+                    reduction.Apply(chunk, selection);
+                    reduction.Fill(selection);
+                    nEventsRead += chunk.nRows;
+                    nEventsSelected += selection.nRows;
+                    if (output) {
+                        std::lock_guard<std::mutex> lock(outputMutex);
+                        output->Append(selection);
+                    }
+                }
+            } catch (const std::exception& e) {
+                std::lock_guard<std::mutex> lock(outputMutex);
+                std::cerr << "Error: " << e.what() << ", rest of the file skipped" << std::endl;
+                failed = true;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < nThreads; ++t) threads.emplace_back(work, std::ref(reductions[t]));
+    work(reductions[0]);
+    for (auto& thread : threads) thread.join();
+    if (output) output->Close();
+
+    for (size_t t = 1; t < nThreads; ++t) reductions[0].Add(reductions[t]);
+    if (!options.histograms.empty()) {
+        nlohmann::json result;
+        result["files"] = files;
+        result["eventsRead"] = nEventsRead.load();
+        result["eventsSelected"] = nEventsSelected.load();
+        result["weighted"] = options.weighted;
+        for (const Cut& cut : reductions[0].GetEventCuts()) result["cuts"].push_back(cut.ToString());
+        for (const Cut& cut : reductions[0].GetHitCuts()) result["hitCuts"].push_back(cut.ToString());
+        for (const Histogram& histogram : reductions[0].GetHistograms()) {
+            result["histograms"].push_back(histogram.ToJson());
+        }
+        std::ofstream file(options.histogramFile);
+        file << result.dump(2) << std::endl;
+        if (!file) {
+            std::cerr << "Cannot write " << options.histogramFile << std::endl;
+            failed = true;
+        }
+    }
+
+    G4double seconds = std::chrono::duration<G4double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << files.size() << " files, " << nEventsRead << " events read, " << nEventsSelected << " selected in "
+              << seconds << " s with " << nThreads << " threads" << std::endl;
+    if (output) std::cout << "Merged events written to " << ColumnarOutput::MakeFileName(options.outputFile) << std::endl;
+    if (!options.histograms.empty()) std::cout << "Histograms written to " << options.histogramFile << std::endl;
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,280 @@
+#include "Reduction.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+/**
+ * @namespace G4Sim
+ * @brief Namespace for the G4Sim library.
+/*/
+namespace G4Sim {
+
+namespace {
+    // jagged columns with one value per detector instead of one per hit, see RunAction::DefineEventNtuple
+    const std::vector<std::string> kDetectorColumns = {"edet", "ndet", "nphot", "ncomp", "det"};
+
+    // longest first, so that "<=" is not read as "<"
+    const std::vector<std::pair<std::string, Cut::Operator>> kOperators = {
+        {"<=", Cut::kLessEqual}, {">=", Cut::kGreaterEqual}, {"==", Cut::kEqual}, {"!=", Cut::kNotEqual},
+        {"<", Cut::kLess}, {">", Cut::kGreater}};
+
+    std::string Trim(const std::string& text) {
+        size_t begin = text.find_first_not_of(" \t");
+        size_t end = text.find_last_not_of(" \t");
+        return begin == std::string::npos ? "" : text.substr(begin, end - begin + 1);
+    }
+
+    G4double Value(const ColumnarReader::Column& column, G4bool isInt, size_t i) {
+        return isInt ? column.intValues[i] : column.doubleValues[i];
+    }
+}
+
+/**
+ * @brief Parses a cut such as "eh>1" or "trig == 1".
+ */
+Cut Cut::Parse(const std::string& text) {
+    for (const auto& candidate : kOperators) {
+        size_t position = text.find(candidate.first);
+        if (position == std::string::npos) continue;
+        Cut cut;
+        cut.column = Trim(text.substr(0, position));
+        cut.op = candidate.second;
+        try {
+            cut.value = std::stod(text.substr(position + candidate.first.size()));
+        } catch (const std::exception&) {
+            throw std::runtime_error("bad cut " + text);
+        }
+        if (cut.column.empty()) throw std::runtime_error("bad cut " + text);
+        return cut;
+    }
+    throw std::runtime_error("bad cut " + text + ", expected column<op>value");
+}
+
+G4bool Cut::Pass(G4double x) const {
+    switch (op) {
+        case kLess: return x < value;
+        case kLessEqual: return x <= value;
+        case kGreater: return x > value;
+        case kGreaterEqual: return x >= value;
+        case kEqual: return x == value;
+        case kNotEqual: return x != value;
+    }
+    return false;
+}
+
+std::string Cut::ToString() const {
+    for (const auto& candidate : kOperators) {
+        if (candidate.second == op) return column + candidate.first + std::to_string(value);
+    }
+    return column;
+}
+
+/**
+ * @brief Parses a histogram definition "column:nBins:min:max".
+ */
+Histogram Histogram::Parse(const std::string& text) {
+    Histogram histogram;
+    std::vector<std::string> fields;
+    size_t begin = 0;
+    for (size_t end; (end = text.find(':', begin)) != std::string::npos; begin = end + 1) {
+        fields.push_back(text.substr(begin, end - begin));
+    }
+    fields.push_back(text.substr(begin));
+    try {
+        if (fields.size() != 4) throw std::invalid_argument(text);
+        histogram.column = fields[0];
+        histogram.nBins = std::stoul(fields[1]);
+        histogram.min = std::stod(fields[2]);
+        histogram.max = std::stod(fields[3]);
+    } catch (const std::exception&) {
+        throw std::runtime_error("bad histogram " + text + ", expected column:nBins:min:max");
+    }
+    if (histogram.nBins == 0 || !(histogram.max > histogram.min)) {
+        throw std::runtime_error("bad histogram " + text + ", needs nBins > 0 and max > min");
+    }
+    histogram.sumWeights.assign(histogram.nBins, 0.);
+    histogram.sumWeights2.assign(histogram.nBins, 0.);
+    return histogram;
+}
+
+void Histogram::Fill(G4double x, G4double weight) {
+    entries++;
+    if (x < min) {
+        underflow += weight;
+    } else if (x >= max) {
+        overflow += weight;
+    } else {
+        size_t bin = std::min(nBins - 1, static_cast<size_t>((x - min) / (max - min) * nBins));
+        sumWeights[bin] += weight;
+        sumWeights2[bin] += weight * weight;
+    }
+}
+
+void Histogram::Add(const Histogram& other) {
+    for (size_t i = 0; i < nBins; ++i) {
+        sumWeights[i] += other.sumWeights[i];
+        sumWeights2[i] += other.sumWeights2[i];
+    }
+    underflow += other.underflow;
+    overflow += other.overflow;
+    entries += other.entries;
+}
+
+nlohmann::json Histogram::ToJson() const {
+    std::vector<G4double> edges(nBins + 1);
+    for (size_t i = 0; i <= nBins; ++i) edges[i] = min + (max - min) * i / nBins;
+    return {{"column", column}, {"edges", edges}, {"sumWeights", sumWeights}, {"sumWeights2", sumWeights2},
+            {"underflow", underflow}, {"overflow", overflow}, {"entries", entries}};
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+Reduction::Reduction(const std::vector<Cut>& eventCuts, const std::vector<Cut>& hitCuts,
+                     const std::vector<Histogram>& histograms, G4bool weighted)
+    : fEventCuts(eventCuts), fHitCuts(hitCuts), fHistograms(histograms), fWeighted(weighted) {}
+
+/**
+ * @brief Resolves the columns of the cuts and histograms in the columns of a file.
+ *
+ * Throws if a column does not exist, if an event cut is on a jagged column or a hit cut is not on a hit column.
+ */
+void Reduction::Bind(const std::vector<ColumnarReader::ColumnInfo>& columns) {
+    fColumns = columns;
+    fIsHitColumn.assign(columns.size(), false);
+    for (size_t i = 0; i < columns.size(); ++i) {
+        fIsHitColumn[i] = columns[i].type != ColumnarReader::kDouble &&
+            std::find(kDetectorColumns.begin(), kDetectorColumns.end(), columns[i].name) == kDetectorColumns.end();
+    }
+
+    for (Cut& cut : fEventCuts) {
+        cut.index = FindColumn(cut.column, true);
+        if (columns[cut.index].type != ColumnarReader::kDouble) {
+            throw std::runtime_error("event cut on jagged column " + cut.column + ", use a hit cut");
+        }
+    }
+    for (Cut& cut : fHitCuts) {
+        cut.index = FindColumn(cut.column, true);
+        if (!fIsHitColumn[cut.index]) throw std::runtime_error("hit cut on column " + cut.column + " without hits");
+    }
+    for (Histogram& histogram : fHistograms) histogram.index = FindColumn(histogram.column, true);
+
+    fWeightColumn = FindColumn("w", false);
+    fHitWeightColumn = FindColumn("wh", false);
+    if (fHitWeightColumn >= 0 && !fIsHitColumn[fHitWeightColumn]) fHitWeightColumn = -1;
+}
+
+G4int Reduction::FindColumn(const std::string& name, G4bool required) const {
+    for (size_t i = 0; i < fColumns.size(); ++i) {
+        if (fColumns[i].name == name) return static_cast<G4int>(i);
+    }
+    if (required) throw std::runtime_error("unknown column " + name);
+    return -1;
+}
+
+/**
+ * @brief Copies the selected events of a chunk, with only the selected hits.
+ *
+ * @param input A chunk of a file given to Bind().
+ * @param output Filled with the selection; its vectors keep their capacity between calls.
+ */
+void Reduction::Apply(const ColumnarReader::Chunk& input, ColumnarReader::Chunk& output) {
+    const size_t nColumns = fColumns.size();
+    output.nRows = 0;
+    output.columns.resize(nColumns);
+    for (size_t c = 0; c < nColumns; ++c) {
+        ColumnarReader::Column& column = output.columns[c];
+        column.offsets.assign(fColumns[c].type == ColumnarReader::kDouble ? 0 : 1, 0);
+        column.doubleValues.clear();
+        column.intValues.clear();
+    }
+
+    for (std::uint64_t row = 0; row < input.nRows; ++row) {
+        G4bool selected = true;
+        for (const Cut& cut : fEventCuts) {
+            if (!cut.Pass(input.columns[cut.index].doubleValues[row])) {
+                selected = false;
+                break;
+            }
+        }
+        if (!selected) continue;
+
+        // hits of this event that pass all hit cuts
+        fHitSelected.clear();
+        if (!fHitCuts.empty()) {
+            const auto& offsets = input.columns[fHitCuts.front().index].offsets;
+            fHitSelected.assign(offsets[row + 1] - offsets[row], true);
+            for (const Cut& cut : fHitCuts) {
+                const ColumnarReader::Column& column = input.columns[cut.index];
+                G4bool isInt = fColumns[cut.index].type == ColumnarReader::kJaggedInt;
+                std::uint64_t begin = column.offsets[row];
+                if (column.offsets[row + 1] - begin != fHitSelected.size()) {
+                    throw std::runtime_error("hit columns " + fHitCuts.front().column + " and " + cut.column +
+                                             " have a different number of hits");
+                }
+                for (size_t hit = 0; hit < fHitSelected.size(); ++hit) {
+                    if (fHitSelected[hit] && !cut.Pass(Value(column, isInt, begin + hit))) fHitSelected[hit] = false;
+                }
+            }
+        }
+
+        for (size_t c = 0; c < nColumns; ++c) {
+            const ColumnarReader::Column& in = input.columns[c];
+            ColumnarReader::Column& out = output.columns[c];
+            if (fColumns[c].type == ColumnarReader::kDouble) {
+                out.doubleValues.push_back(in.doubleValues[row]);
+                continue;
+            }
+            G4bool isInt = fColumns[c].type == ColumnarReader::kJaggedInt;
+            std::uint64_t begin = in.offsets[row];
+            std::uint64_t end = in.offsets[row + 1];
+            G4bool filter = fIsHitColumn[c] && !fHitCuts.empty() && end - begin == fHitSelected.size();
+            for (std::uint64_t i = begin; i < end; ++i) {
+                if (filter && !fHitSelected[i - begin]) continue;
+                if (isInt) {
+                    out.intValues.push_back(in.intValues[i]);
+                } else {
+                    out.doubleValues.push_back(in.doubleValues[i]);
+                }
+            }
+            out.offsets.push_back(isInt ? out.intValues.size() : out.doubleValues.size());
+        }
+        output.nRows++;
+    }
+}
+
+/**
+ * @brief Fills the histograms with the events of a chunk returned by Apply().
+ */
+void Reduction::Fill(const ColumnarReader::Chunk& chunk) {
+    for (Histogram& histogram : fHistograms) {
+        const ColumnarReader::Column& column = chunk.columns[histogram.index];
+        ColumnarReader::ColumnType type = fColumns[histogram.index].type;
+        for (std::uint64_t row = 0; row < chunk.nRows; ++row) {
+            G4double eventWeight = fWeighted && fWeightColumn >= 0 ?
+                std::exp(chunk.columns[fWeightColumn].doubleValues[row]) : 1.;
+            if (type == ColumnarReader::kDouble) {
+                histogram.Fill(column.doubleValues[row], eventWeight);
+                continue;
+            }
+            G4bool hitWeights = fWeighted && fIsHitColumn[histogram.index] && fHitWeightColumn >= 0;
+            const ColumnarReader::Column* weights = hitWeights ? &chunk.columns[fHitWeightColumn] : nullptr;
+            std::uint64_t begin = column.offsets[row];
+            std::uint64_t end = column.offsets[row + 1];
+            if (weights && weights->offsets[row + 1] - weights->offsets[row] != end - begin) weights = nullptr;
+            for (std::uint64_t i = begin; i < end; ++i) {
+                G4double weight = weights ? std::exp(weights->doubleValues[weights->offsets[row] + i - begin]) : eventWeight;
+                histogram.Fill(Value(column, type == ColumnarReader::kJaggedInt, i), weight);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Adds the histograms of another copy.
+ */
+void Reduction::Add(const Reduction& other) {
+    for (size_t i = 0; i < fHistograms.size(); ++i) fHistograms[i].Add(other.fHistograms[i]);
+}
+
+} // namespace G4Sim
@@ -0,0 +1,102 @@
+#ifndef REDUCTION_HH
+#define REDUCTION_HH
+
+#include "ColumnarReader.hh"
+
+#include "G4Types.hh"
+#include "nlohmann/json.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @namespace G4Sim
+ * @brief Namespace for the G4Sim library.
+/*/
+namespace G4Sim {
+
+/**
+ * @struct Cut
+ * @brief A cut "column op value" on one column, with op one of <, <=, >, >=, == and !=.
+ */
+struct Cut {
+    enum Operator { kLess, kLessEqual, kGreater, kGreaterEqual, kEqual, kNotEqual };
+
+    std::string column;
+    Operator op = kGreater;
+    G4double value = 0.;
+    G4int index = -1;  // column index in the file, see Reduction::Bind()
+
+    static Cut Parse(const std::string& text);
+    G4bool Pass(G4double x) const;
+    std::string ToString() const;
+};
+
+/**
+ * @struct Histogram
+ * @brief A weighted histogram of one column with equal bins, "column:nBins:min:max" on the command line.
+ */
+struct Histogram {
+    std::string column;
+    size_t nBins = 100;
+    G4double min = 0.;
+    G4double max = 1.;
+    G4int index = -1;
+    std::vector<G4double> sumWeights;
+    std::vector<G4double> sumWeights2;
+    G4double underflow = 0.;
+    G4double overflow = 0.;
+    std::uint64_t entries = 0;
+
+    static Histogram Parse(const std::string& text);
+    void Fill(G4double x, G4double weight);
+    void Add(const Histogram& other);
+    nlohmann::json ToJson() const;
+};
+
+/**
+ * @class Reduction
+ * @brief Applies the event and hit cuts to the chunks of a columnar file, and fills histograms of the selection.
+ *
+ * The selection follows Geant4Analyzer.preprocess_data: an event passes if all event cuts (on scalar columns) pass,
+ * and within a selected event a hit passes if all hit cuts (on hit columns) pass. Hit columns are the jagged
+ * columns with one value per hit; the per-detector columns (edet, ndet, nphot, ncomp, and det of the sparse layout)
+ * are kept whole. Histograms are weighted with exp(w) for event and detector columns and exp(wh) for hit columns
+ * (exp(w) for a file without wh), unless weighting is off.
+ *
+ * Every thread uses its own copy; the histograms of the copies are combined with Add().
+ */
+class Reduction {
+public:
+    Reduction(const std::vector<Cut>& eventCuts, const std::vector<Cut>& hitCuts,
+              const std::vector<Histogram>& histograms, G4bool weighted);
+
+    void Bind(const std::vector<ColumnarReader::ColumnInfo>& columns);
+
+    void Apply(const ColumnarReader::Chunk& input, ColumnarReader::Chunk& output);
+    void Fill(const ColumnarReader::Chunk& chunk);
+    void Add(const Reduction& other);
+
+    const std::vector<Histogram>& GetHistograms() const { return fHistograms; }
+    const std::vector<Cut>& GetEventCuts() const { return fEventCuts; }
+    const std::vector<Cut>& GetHitCuts() const { return fHitCuts; }
+
+private:
+    G4int FindColumn(const std::string& name, G4bool required) const;
+
+    std::vector<Cut> fEventCuts;
+    std::vector<Cut> fHitCuts;
+    std::vector<Histogram> fHistograms;
+    G4bool fWeighted;
+
+    std::vector<ColumnarReader::ColumnInfo> fColumns;
+    std::vector<G4bool> fIsHitColumn;
+    G4int fWeightColumn = -1;     // w, log of the event weight
+    G4int fHitWeightColumn = -1;  // wh, log of the hit weights
+    std::vector<G4bool> fHitSelected;  // of the current event
+};
+
+} // namespace G4Sim
+
+#endif